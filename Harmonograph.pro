@@ -6,9 +6,14 @@ INCLUDEPATH += .
 INCLUDEPATH += src/headers
 INCLUDEPATH += libs
 
-QT += widgets
+QT += widgets network
 
 LIBS+=-lglut
+LIBS+=-lz
+unix:!macx: LIBS+=-lrt
+
+# lets '#pragma omp simd' vectorize sampler loops without pulling in the OpenMP runtime
+!msvc: QMAKE_CXXFLAGS += -fopenmp-simd
 
 HEADERS += resource.h \
            libs/* \
@@ -0,0 +1,52 @@
+# Qt-free library of the curve model, batch sampling and the software raster path, with the
+# C interface of src/headers/HarmonographCore.h. Static by default, a shared library with
+#   qmake "CONFIG+=core_shared"
+
+TEMPLATE = lib
+
+TARGET = harmonograph-core
+
+CONFIG -= qt
+CONFIG += c++17
+
+core_shared {
+    DEFINES += HARMONOGRAPH_CORE_SHARED HARMONOGRAPH_CORE_BUILD
+    !msvc: QMAKE_CXXFLAGS += -fvisibility=hidden
+} else {
+    CONFIG += staticlib
+}
+
+INCLUDEPATH += ../src/headers
+
+# lets '#pragma omp simd' vectorize sampler loops without pulling in the OpenMP runtime
+!msvc: QMAKE_CXXFLAGS += -fopenmp-simd
+
+unix: LIBS += -lpthread
+
+HEADERS += ../src/headers/AllocationTracker.h \
+           ../src/headers/CounterRandom.h \
+           ../src/headers/Dimension.h \
+           ../src/headers/DrawModesEnum.h \
+           ../src/headers/FastMath.h \
+           ../src/headers/Harmonograph.h \
+           ../src/headers/HarmonographCore.h \
+           ../src/headers/HarmonographEnginesEnum.h \
+           ../src/headers/HarmonographSampler.h \
+           ../src/headers/IntegratorsEnum.h \
+           ../src/headers/MathAccuracyEnum.h \
+           ../src/headers/Pendulum.h \
+           ../src/headers/PendulumDimension.h \
+           ../src/headers/PendulumEquationParametersEnum.h \
+           ../src/headers/PendulumSimulator.h \
+           ../src/headers/SimulationSettings.h \
+           ../src/headers/SoftwareRasterizer.h
+
+SOURCES += ../src/cpp/AllocationTracker.cpp \
+           ../src/cpp/FastMath.cpp \
+           ../src/cpp/Harmonograph.cpp \
+           ../src/cpp/HarmonographCore.cpp \
+           ../src/cpp/HarmonographSampler.cpp \
+           ../src/cpp/Pendulum.cpp \
+           ../src/cpp/PendulumDimension.cpp \
+           ../src/cpp/PendulumSimulator.cpp \
+           ../src/cpp/SoftwareRasterizer.cpp
@@ -0,0 +1,161 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "AllocationTracker.h"
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+class LiveAllocation {
+public:
+	const char* type;
+	const char* site;
+	std::size_t bytes;
+};
+
+class AllocationTotals {
+public:
+	long long liveCount = 0;
+	long long liveBytes = 0;
+	long long allocatedCount = 0;
+};
+
+static std::mutex allocationsMutex;
+static std::unordered_map<const void*, LiveAllocation> liveAllocations;
+//sorted by type and site so the report reads as a table
+static std::map<std::pair<std::string, std::string>, AllocationTotals> totalsBySite;
+
+static thread_local const char* currentSite = nullptr;
+
+std::atomic<bool> AllocationTracker::enabled(false);
+
+void AllocationTracker::setEnabled(bool isEnabled) {
+	enabled.store(isEnabled);
+}
+
+void AllocationTracker::track(const void* object, const char* type, std::size_t bytes) {
+	if (!isEnabled()) return;
+	const char* site = AllocationSite::getCurrent();
+
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+	liveAllocations[object] = { type, site, bytes };
+
+	AllocationTotals& totals = totalsBySite[std::make_pair(std::string(type), std::string(site))];
+	totals.liveCount++;
+	totals.liveBytes += bytes;
+	totals.allocatedCount++;
+}
+
+void AllocationTracker::untrack(const void* object) {
+	if (!isEnabled()) return;
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	//objects created before tracking started are not known
+	auto found = liveAllocations.find(object);
+	if (found == liveAllocations.end()) return;
+
+	AllocationTotals& totals = totalsBySite[std::make_pair(std::string(found->second.type), std::string(found->second.site))];
+	totals.liveCount--;
+	totals.liveBytes -= found->second.bytes;
+	liveAllocations.erase(found);
+}
+
+std::string AllocationTracker::getReport() {
+	std::lock_guard<std::mutex> lock(allocationsMutex);
+
+	std::map<std::string, AllocationTotals> totalsByType;
+	for (const auto& entry : totalsBySite) {
+		AllocationTotals& totals = totalsByType[entry.first.first];
+		totals.liveCount += entry.second.liveCount;
+		totals.liveBytes += entry.second.liveBytes;
+		totals.allocatedCount += entry.second.allocatedCount;
+	}
+
+	std::string report;
+	char line[256];
+
+	snprintf(line, sizeof(line), "resident memory: %zu KB\n", getResidentBytes() / 1024);
+	report += line;
+	snprintf(line, sizeof(line), "%-20s %-28s %10s %12s %12s\n", "type", "site", "live", "live bytes", "allocated");
+	report += line;
+
+	for (const auto& entry : totalsByType) {
+		snprintf(line, sizeof(line), "%-20s %-28s %10lld %12lld %12lld\n", entry.first.c_str(), "(all)",
+			entry.second.liveCount, entry.second.liveBytes, entry.second.allocatedCount);
+		report += line;
+
+		for (const auto& siteEntry : totalsBySite) {
+			if (siteEntry.first.first != entry.first) continue;
+
+			snprintf(line, sizeof(line), "%-20s %-28s %10lld %12lld %12lld\n", "", siteEntry.first.second.c_str(),
+				siteEntry.second.liveCount, siteEntry.second.liveBytes, siteEntry.second.allocatedCount);
+			report += line;
+		}
+	}
+	return report;
+}
+
+std::size_t AllocationTracker::getResidentBytes() {
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+	mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) return 0;
+	return info.resident_size;
+#else
+	//second field of statm is the resident size in pages
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (statm == nullptr) return 0;
+
+	unsigned long long size = 0, resident = 0;
+	const int fieldsRead = fscanf(statm, "%llu %llu", &size, &resident);
+	fclose(statm);
+	if (fieldsRead != 2) return 0;
+	return resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+AllocationSite::AllocationSite(const char* site) {
+	isOutermost = currentSite == nullptr;
+	if (isOutermost) currentSite = site;
+}
+
+AllocationSite::~AllocationSite() {
+	if (isOutermost) currentSite = nullptr;
+}
+
+const char* AllocationSite::getCurrent() {
+	return currentSite != nullptr ? currentSite : "(no site)";
+}
@@ -0,0 +1,90 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "BezierFitter.h"
+
+BezierFitter::BezierFitter(Harmonograph* harmonograph, float scale, float xOffset, float yOffset, float tolerance) {
+	this->harmonograph = harmonograph;
+	this->scale = scale;
+	this->xOffset = xOffset;
+	this->yOffset = yOffset;
+	this->tolerance = tolerance;
+}
+
+void BezierFitter::fit(float tStart, float tEnd, float initialStep, std::vector<CubicSegment>& segments) {
+	const int intervals = std::max(1, static_cast<int>(ceil((tEnd - tStart) / initialStep)));
+
+	for (int i = 0; i < intervals; i++) {
+		const float t0 = tStart + (tEnd - tStart) * i / intervals;
+		const float t1 = tStart + (tEnd - tStart) * (i + 1) / intervals;
+
+		fitInterval(t0, t1, 0, segments);
+	}
+}
+
+void BezierFitter::fitInterval(float t0, float t1, int depth, std::vector<CubicSegment>& segments) {
+	const float h = t1 - t0;
+
+	CubicSegment segment;
+	segment.tStart = t0;
+	segment.tEnd = t1;
+
+	float dx0, dy0, dx1, dy1;
+	getPoint(t0, segment.x0, segment.y0);
+	getPoint(t1, segment.x3, segment.y3);
+	getVelocity(t0, dx0, dy0);
+	getVelocity(t1, dx1, dy1);
+
+	segment.x1 = segment.x0 + dx0 * h / 3;
+	segment.y1 = segment.y0 + dy0 * h / 3;
+	segment.x2 = segment.x3 - dx1 * h / 3;
+	segment.y2 = segment.y3 - dy1 * h / 3;
+
+	if (depth < maxDepth) {
+		//Hermite parametrization matches time, so compare the Bezier point at u with the curve at t0 + u*h
+		for (float u : { 0.25f, 0.5f, 0.75f }) {
+			const float v = 1 - u;
+			const float bx = v * v * v * segment.x0 + 3 * v * v * u * segment.x1 + 3 * v * u * u * segment.x2 + u * u * u * segment.x3;
+			const float by = v * v * v * segment.y0 + 3 * v * v * u * segment.y1 + 3 * v * u * u * segment.y2 + u * u * u * segment.y3;
+
+			float cx, cy;
+			getPoint(t0 + u * h, cx, cy);
+
+			if ((bx - cx) * (bx - cx) + (by - cy) * (by - cy) > tolerance * tolerance) {
+				fitInterval(t0, t0 + h / 2, depth + 1, segments);
+				fitInterval(t0 + h / 2, t1, depth + 1, segments);
+				return;
+			}
+		}
+	}
+
+	segments.push_back(segment);
+}
+
+void BezierFitter::getPoint(float t, float& x, float& y) {
+	x = harmonograph->getCoordinateByTime<Dimension::x>(t) * scale + xOffset;
+	y = -harmonograph->getCoordinateByTime<Dimension::y>(t) * scale + yOffset;
+}
+
+void BezierFitter::getVelocity(float t, float& dx, float& dy) {
+	dx = harmonograph->getDerivativeByTime<Dimension::x>(t) * scale;
+	dy = -harmonograph->getDerivativeByTime<Dimension::y>(t) * scale;
+}
@@ -20,7 +20,7 @@
 
 #include "ColorTemplatesDialog.h"
 
-ColorTemplatesDialog::ColorTemplatesDialog(QWidget* parent) : QDialog(parent) {
+ColorTemplatesDialog::ColorTemplatesDialog(std::vector<NamedColorTemplate*> templates, QWidget* parent) : QDialog(parent) {
 	ui.setupUi(this);
 
 	QString expression = "[A-Za-z0-9 ]{0,20}";
@@ -29,13 +29,8 @@ ColorTemplatesDialog::ColorTemplatesDialog(QWidget* parent) : QDialog(parent) {
 
 	ui.templateInputLine->setValidator(validator);
 
-	QDir prefDir(preferencesDirPath);
-
-	QFileInfoList fileInfoList = prefDir.entryInfoList(QStringList() << "*.json", QDir::Files);
-	for (QFileInfo fileInfo : fileInfoList) {
-		qInfo() << fileInfo.absoluteFilePath();
-		readTemplatesFromFile(fileInfo.absoluteFilePath(), templates);
-	}
+	this->templates = templates;
+	maxTemplateID = templates.size();
 
 	for (int i = 0; i < templates.size(); i++) {
 		NamedColorTemplate currentTemplate = *templates.at(i);
@@ -54,6 +49,42 @@ ColorTemplatesDialog::ColorTemplatesDialog(QWidget* parent) : QDialog(parent) {
 ColorTemplatesDialog::~ColorTemplatesDialog() {
 }
 
+std::vector<NamedColorTemplate*> ColorTemplatesDialog::loadTemplates(QString preferencesDirPath, QString userTemplatesFileName) {
+	/*creating Preferences folder and empty color templates file*/
+	const QFileInfo userTemplatesFileInfo(QDir(preferencesDirPath), userTemplatesFileName);
+
+	if (!userTemplatesFileInfo.exists()) {
+		QFile file(userTemplatesFileInfo.absoluteFilePath());
+		try {
+			QDir().mkpath(userTemplatesFileInfo.absolutePath());
+
+			file.open(QIODevice::ReadWrite);
+
+			QJsonDocument document;
+			QJsonObject root;
+			QJsonArray array;
+
+			root.insert("preferences", array);
+			document.setObject(root);
+
+			file.write(QJsonDocument(document).toJson(QJsonDocument::Indented));
+		}
+		catch (...) {
+		}
+		file.close();
+	}
+
+	std::vector<NamedColorTemplate*> templates;
+	QDir prefDir(preferencesDirPath);
+
+	QFileInfoList fileInfoList = prefDir.entryInfoList(QStringList() << "*.json", QDir::Files);
+	for (QFileInfo fileInfo : fileInfoList) {
+		readTemplatesFromFile(fileInfo.absoluteFilePath(), templates);
+	}
+
+	return templates;
+}
+
 void ColorTemplatesDialog::readTemplatesFromFile(QString filename, std::vector<NamedColorTemplate*> & templates) {
 	QFile jsonFile(filename);
 
@@ -78,10 +109,9 @@ void ColorTemplatesDialog::readTemplatesFromFile(QString filename, std::vector<N
 			secondary.setNamedColor(object.value("secondary").toString());
 			background.setNamedColor(object.value("background").toString());
 
-			NamedColorTemplate* namedTemplate = new NamedColorTemplate(maxTemplateID, QFileInfo(filename).fileName(), name, ColorTemplate(primary, secondary, background));
+			NamedColorTemplate* namedTemplate = new NamedColorTemplate(templates.size(), QFileInfo(filename).fileName(), name, ColorTemplate(primary, secondary, background));
 
 			templates.push_back(namedTemplate);
-			maxTemplateID++;
 		}
 	}
 	catch (...) {
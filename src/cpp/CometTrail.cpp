@@ -0,0 +1,88 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "CometTrail.h"
+#include <algorithm>
+#include <cmath>
+
+CometTrail::CometTrail(double timeStep, double windowLength, double speed) {
+	this->timeStep = timeStep;
+	this->speed = speed;
+	capacity = std::max(2, static_cast<int>(ceil(windowLength / timeStep)));
+	sampler.setAccuracy(MathAccuracy::medium);
+}
+
+void CometTrail::addTime(double seconds) {
+	targetTime += seconds * speed;
+}
+
+void CometTrail::clearPending() {
+	pendingXs.clear();
+	pendingYs.clear();
+	isRestarted = false;
+}
+
+void CometTrail::restart() {
+	nextIndex = 0;
+	targetTime = 0;
+	pendingXs.clear();
+	pendingYs.clear();
+	isRestarted = true;
+}
+
+void CometTrail::sampleNew(Harmonograph* harmonograph) {
+	//a closed form is cheap to reload, so dragging and flexing show up in the trail at once;
+	//reloading a simulation would integrate it again from t = 0 every frame
+	if (!isLoaded || harmonograph->engine == HarmonographEngines::closedForm) {
+		sampler.load(harmonograph);
+		isLoaded = true;
+	}
+
+	const long long lastIndex = static_cast<long long>(maxT / timeStep);
+	if (nextIndex > lastIndex) restart();
+
+	const long long targetIndex = std::min(lastIndex, static_cast<long long>(floor(targetTime / timeStep)));
+	if (targetIndex < nextIndex) return;
+
+	//after a stall only the part that still fits in the window is computed, the rest would be
+	//overwritten anyway and the jump would draw a line across
+	long long count = targetIndex - nextIndex + 1;
+	if (count > capacity) {
+		nextIndex = targetIndex - capacity + 1;
+		count = capacity;
+		pendingXs.clear();
+		pendingYs.clear();
+		isRestarted = true;
+	}
+
+	const size_t first = pendingXs.size();
+	pendingXs.resize(first + count);
+	pendingYs.resize(first + count);
+	//indices keep the start time exact, which lets a simulation continue instead of starting over
+	sampler.sample(nextIndex * timeStep, timeStep, static_cast<int>(count), pendingXs.data() + first, pendingYs.data() + first);
+	nextIndex += count;
+
+	if (static_cast<int>(pendingXs.size()) > capacity) {
+		pendingXs.erase(pendingXs.begin(), pendingXs.end() - capacity);
+		pendingYs.erase(pendingYs.begin(), pendingYs.end() - capacity);
+		isRestarted = true;
+	}
+}
@@ -0,0 +1,376 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "ControlServer.h"
+#include "Tracer.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QPainter>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+
+ControlServer::ControlServer(HarmonographManager* manager, QObject* parent) : QObject(parent) {
+	this->manager = manager;
+	server = new QLocalServer(this);
+	server->setSocketOptions(QLocalServer::UserAccessOption);
+	connect(server, SIGNAL(newConnection()), this, SLOT(acceptConnection()));
+}
+
+ControlServer::~ControlServer() {
+	server->close();
+}
+
+bool ControlServer::listen(QString socketPath) {
+	//a socket file left behind by a crashed instance would make listen fail
+	QLocalServer::removeServer(socketPath);
+	return server->listen(socketPath);
+}
+
+QString ControlServer::getErrorString() {
+	return server->errorString();
+}
+
+void ControlServer::acceptConnection() {
+	while (QLocalSocket* socket = server->nextPendingConnection()) {
+		connect(socket, SIGNAL(readyRead()), this, SLOT(readCommands()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(removeSubscriber()));
+		connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+	}
+}
+
+void ControlServer::removeSubscriber() {
+	QLocalSocket* socket = static_cast<QLocalSocket*>(sender());
+	subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), socket), subscribers.end());
+}
+
+void ControlServer::readCommands() {
+	QLocalSocket* socket = static_cast<QLocalSocket*>(sender());
+
+	while (socket->canReadLine()) {
+		//the latency of a frame is counted from the moment its command was read
+		const std::uint64_t receivedNs = FrameRing::nowNs();
+		const QByteArray line = socket->readLine().trimmed();
+		if (line.isEmpty()) continue;
+
+		QJsonParseError parseError;
+		const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+		if (!document.isObject()) {
+			send(socket, error("invalid JSON: " + parseError.errorString()));
+			continue;
+		}
+
+		const QJsonObject request = document.object();
+		QJsonObject reply = execute(socket, request, receivedNs);
+		if (request.contains("id")) reply.insert("id", request.value("id"));
+		send(socket, reply);
+	}
+}
+
+QJsonObject ControlServer::execute(QLocalSocket* socket, const QJsonObject& request, std::uint64_t receivedNs) {
+	TraceSpan commandSpan("ControlServer::execute", "control");
+	const QString command = request.value("command").toString();
+
+	if (command == "ping") {
+		return QJsonObject{ { "ok", true } };
+	}
+	if (command == "get") {
+		return getState();
+	}
+	if (command == "stats") {
+		return getStatistics();
+	}
+	if (command == "openFrames") {
+		std::string errorString;
+		const int width = request.value("width").toInt(640);
+		const int height = request.value("height").toInt(480);
+		const int slotsCount = request.value("slots").toInt(3);
+		const QString name = request.value("name").toString("/harmonograph-frames");
+
+		if (!frameRing.open(name.toStdString(), slotsCount, width, height, errorString)) {
+			return error(QString::fromStdString(errorString));
+		}
+		latencies.clear();
+		return QJsonObject{ { "ok", true }, { "name", name }, { "stride", frameRing.getStride() } };
+	}
+	if (command == "render") {
+		if (!frameRing.isOpen()) return error("no frame ring, send openFrames first");
+		return renderFrame(receivedNs);
+	}
+	if (command == "subscribe" || command == "unsubscribe") {
+		if (!frameRing.isOpen()) return error("no frame ring, send openFrames first");
+
+		subscribers.erase(std::remove(subscribers.begin(), subscribers.end(), socket), subscribers.end());
+		if (command == "subscribe") subscribers.push_back(socket);
+		return QJsonObject{ { "ok", true } };
+	}
+
+	bool isChanged = false;
+	const QJsonObject reply = executeChange(command, request, isChanged);
+	//every command is a finished change, the frames sent to subscribers are never the coarse drag tier
+	manager->finishInteraction();
+	if (isChanged) {
+		emit stateChanged();
+		scheduleRender(receivedNs);
+	}
+	return reply;
+}
+
+QJsonObject ControlServer::executeChange(const QString& command, const QJsonObject& request, bool& isChanged) {
+	const QJsonValue value = request.value("value");
+
+	if (command == "changeParameter" || command == "setParameter") {
+		Dimension dimension;
+		EquationParameter parameter;
+		const int pendulumNum = request.value("pendulum").toInt(-1);
+
+		if (pendulumNum < 0 || pendulumNum >= manager->getNumOfPendulums()) return error("pendulum out of range");
+		if (!parseDimension(request.value("dimension"), dimension)) return error("dimension must be x or y");
+		if (!parseParameter(request.value("parameter"), parameter)) return error("unknown parameter");
+		if (!value.isDouble()) return error("value must be a number");
+
+		//changeParameter takes the slider position of the main window, setParameter the value itself
+		if (command == "changeParameter") manager->changeParameter(pendulumNum, parameter, dimension, value.toInt());
+		else manager->setEquationParameter(pendulumNum, dimension, parameter, value.toDouble());
+	}
+	else if (command == "setFrequencyPoint") {
+		if (value.toDouble() <= 0) return error("value must be positive");
+		manager->setFrequencyPoint(value.toDouble());
+	}
+	else if (command == "setNumOfPendulums") {
+		if (value.toInt() < 1 || value.toInt() > 1024) return error("value must be from 1 to 1024");
+		manager->setNumOfPendulums(value.toInt());
+	}
+	else if (command == "setColors") {
+		const char* keys[] = { "primary", "second", "background" };
+		QColor colors[3];
+		for (int i = 0; i < 3; i++) {
+			if (!request.contains(keys[i])) continue;
+
+			colors[i] = QColor(request.value(keys[i]).toString());
+			if (!colors[i].isValid()) return error(QString("invalid %1 color").arg(keys[i]));
+		}
+
+		if (colors[0].isValid()) manager->setPrimaryColor(colors[0]);
+		if (colors[1].isValid()) manager->setSecondColor(colors[1]);
+		if (colors[2].isValid()) manager->setBackgroundColor(colors[2]);
+		if (request.contains("useTwoColors")) manager->setUseTwoColors(request.value("useTwoColors").toBool());
+	}
+	else if (command == "setZoom") {
+		if (value.toDouble() <= 0) return error("value must be positive");
+		manager->setZoom(value.toDouble());
+	}
+	else if (command == "setPenWidth") {
+		if (value.toInt() < 1) return error("value must be positive");
+		manager->setPenWidth(value.toInt());
+	}
+	else if (command == "setTimeStep") {
+		if (value.toDouble() < 1e-4) return error("value must be at least 0.0001");
+		manager->setTimeStep(value.toDouble());
+	}
+	else if (command == "setDrawMode") {
+		const QString mode = value.toString();
+		if (mode != "lines" && mode != "points") return error("value must be lines or points");
+		manager->setDrawMode(mode == "lines" ? DrawModes::linesMode : DrawModes::pointsMode);
+	}
+	else if (command == "rotate") {
+		manager->changeXAxisRotation(value.toDouble());
+	}
+	else if (command == "randomize") {
+		manager->updateRandomValues();
+	}
+	else {
+		return error("unknown command: " + command);
+	}
+
+	isChanged = true;
+	return QJsonObject{ { "ok", true } };
+}
+
+QJsonObject ControlServer::getState() {
+	const char* dimensionNames[] = { "x", "y" };
+	QJsonArray pendulums;
+
+	for (int i = 0; i < manager->getNumOfPendulums(); i++) {
+		QJsonObject pendulum;
+		for (Dimension dimension : { Dimension::x, Dimension::y }) {
+			pendulum.insert(dimensionNames[static_cast<int>(dimension)], QJsonObject{
+				{ "amplitude", manager->getEquationParameter(i, dimension, EquationParameter::amplitude) },
+				{ "damping", manager->getEquationParameter(i, dimension, EquationParameter::dumping) },
+				{ "frequency", manager->getEquationParameter(i, dimension, EquationParameter::frequency) },
+				{ "phase", manager->getEquationParameter(i, dimension, EquationParameter::phase) },
+			});
+		}
+		pendulums.append(pendulum);
+	}
+
+	const DrawParameters parameters = manager->getDrawParameters();
+	return QJsonObject{
+		{ "ok", true },
+		{ "pendulums", pendulums },
+		{ "primary", parameters.primaryColor.name() },
+		{ "second", parameters.secondColor.name() },
+		{ "background", parameters.backgroundColor.name() },
+		{ "useTwoColors", parameters.useTwoColors },
+		{ "drawMode", parameters.drawMode == DrawModes::linesMode ? "lines" : "points" },
+		{ "penWidth", parameters.penWidth },
+		{ "zoom", parameters.zoom },
+		{ "timeStep", parameters.timeStep },
+	};
+}
+
+QJsonObject ControlServer::getStatistics() {
+	std::vector<double> sorted(latencies.begin(), latencies.end());
+	std::sort(sorted.begin(), sorted.end());
+
+	QJsonObject statistics{ { "ok", true }, { "count", static_cast<int>(sorted.size()) } };
+	if (sorted.empty()) return statistics;
+
+	double sum = 0;
+	for (double latency : sorted) sum += latency;
+
+	statistics.insert("meanUs", sum / sorted.size());
+	statistics.insert("p50Us", sorted[sorted.size() / 2]);
+	statistics.insert("p99Us", sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)]);
+	statistics.insert("maxUs", sorted.back());
+	return statistics;
+}
+
+void ControlServer::scheduleRender(std::uint64_t commandReceivedNs) {
+	if (subscribers.empty() || !frameRing.isOpen()) return;
+
+	//a burst of commands read in one go is answered with a single frame, its latency is
+	//counted from the oldest of them
+	if (!isRenderScheduled) {
+		isRenderScheduled = true;
+		pendingCommandNs = commandReceivedNs;
+		QTimer::singleShot(0, this, SLOT(renderScheduledFrame()));
+	}
+}
+
+void ControlServer::renderScheduledFrame() {
+	isRenderScheduled = false;
+	if (subscribers.empty() || !frameRing.isOpen()) return;
+
+	QJsonObject event = renderFrame(pendingCommandNs);
+	event.remove("ok");
+	event.insert("event", "frame");
+	for (QLocalSocket* socket : subscribers) {
+		send(socket, event);
+	}
+}
+
+QJsonObject ControlServer::renderFrame(std::uint64_t commandReceivedNs) {
+	TraceSpan renderSpan("ControlServer::renderFrame", "control");
+	std::uint64_t sequence;
+	unsigned char* pixels = frameRing.beginFrame(sequence);
+
+	//the image only wraps the shared memory, QPainter draws straight into the slot
+	QImage image(pixels, frameRing.getWidth(), frameRing.getHeight(), frameRing.getStride(), QImage::Format_ARGB32_Premultiplied);
+	drawFrame(image);
+	frameRing.publishFrame(commandReceivedNs);
+
+	const double latency = (FrameRing::nowNs() - commandReceivedNs) / 1000.0;
+	latencies.push_back(latency);
+	if (latencies.size() > maxLatencies) latencies.pop_front();
+
+	return QJsonObject{
+		{ "ok", true },
+		{ "sequence", static_cast<qint64>(sequence) },
+		{ "slot", frameRing.getSlot(sequence) },
+		{ "latencyUs", latency },
+	};
+}
+
+void ControlServer::drawFrame(QImage& image) {
+	const DrawParameters parameters = manager->getDrawParameters();
+	const int count = static_cast<int>(ceil(255 / parameters.timeStep));
+	xs.resize(count);
+	ys.resize(count);
+	manager->sampleTrajectory(0, parameters.timeStep, count, xs.data(), ys.data());
+
+	QPainter painter(&image);
+	painter.fillRect(image.rect(), parameters.backgroundColor);
+	if (parameters.useAntiAliasing) painter.setRenderHint(QPainter::Antialiasing, true);
+
+	QPen pen;
+	pen.setCapStyle(Qt::RoundCap);
+	pen.setWidth(parameters.penWidth);
+
+	//the same mapping as the preview, the curve height fills the frame height at zoom 1
+	const float scale = parameters.zoom * image.height() / 2;
+	const float xCenter = image.width() / 2.0f, yCenter = image.height() / 2.0f;
+
+	const QColor first = parameters.primaryColor;
+	const QColor last = parameters.useTwoColors ? parameters.secondColor : parameters.primaryColor;
+	const bool isLines = parameters.drawMode == DrawModes::linesMode;
+
+	//the gradient changes color only every count / 256 samples, one batch per color
+	std::vector<QPointF> batch;
+	QRgb batchColor = first.rgb();
+
+	for (int i = 0; i <= count; i++) {
+		const float fraction = static_cast<float>(i) / count;
+		const QRgb color = i == count ? 0 : qRgb(first.red() + (last.red() - first.red()) * fraction,
+			first.green() + (last.green() - first.green()) * fraction, first.blue() + (last.blue() - first.blue()) * fraction);
+
+		if (color != batchColor || i == count) {
+			pen.setColor(batchColor);
+			painter.setPen(pen);
+			if (isLines) painter.drawPolyline(batch.data(), static_cast<int>(batch.size()));
+			else painter.drawPoints(batch.data(), static_cast<int>(batch.size()));
+
+			//consecutive polylines share their end point so the curve has no gaps
+			const QPointF lastPoint = batch.empty() ? QPointF() : batch.back();
+			batch.clear();
+			if (isLines && i > 0) batch.push_back(lastPoint);
+			batchColor = color;
+		}
+		if (i < count) batch.push_back(QPointF(xCenter + xs[i] * scale, yCenter - ys[i] * scale));
+	}
+}
+
+void ControlServer::send(QLocalSocket* socket, const QJsonObject& object) {
+	socket->write(QJsonDocument(object).toJson(QJsonDocument::Compact));
+	socket->write("\n");
+	socket->flush();
+}
+
+QJsonObject ControlServer::error(const QString& message) {
+	return QJsonObject{ { "ok", false }, { "error", message } };
+}
+
+bool ControlServer::parseDimension(const QJsonValue& value, Dimension& dimension) {
+	if (value.toString() == "x") dimension = Dimension::x;
+	else if (value.toString() == "y") dimension = Dimension::y;
+	else return false;
+	return true;
+}
+
+bool ControlServer::parseParameter(const QJsonValue& value, EquationParameter& parameter) {
+	const QString name = value.toString();
+	if (name == "amplitude") parameter = EquationParameter::amplitude;
+	else if (name == "damping") parameter = EquationParameter::dumping;
+	else if (name == "frequency") parameter = EquationParameter::frequency;
+	else if (name == "phase") parameter = EquationParameter::phase;
+	else return false;
+	return true;
+}
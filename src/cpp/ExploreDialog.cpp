@@ -0,0 +1,45 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "ExploreDialog.h"
+
+ExploreDialog::ExploreDialog(QWidget* parent) : QDialog(parent)
+{
+	ui.setupUi(this);
+	ui.seedLineEdit->setValidator(new QRegularExpressionValidator(QRegularExpression("[0-9]{1,19}"), this));
+}
+
+ExploreDialog::~ExploreDialog() {
+}
+
+void ExploreDialog::accept() {
+	settings.seed = ui.seedLineEdit->text().toULongLong();
+	settings.candidatesCount = ui.candidatesCountSpinBox->value();
+	settings.topCount = ui.topCountSpinBox->value();
+	settings.outputDirPath = ui.outputDirLineEdit->text();
+
+	QDialog::accept();
+}
+
+void ExploreDialog::browseOutputDir() {
+	QString dirPath = QFileDialog::getExistingDirectory(this, tr("Choose output folder"), ui.outputDirLineEdit->text());
+	if (!dirPath.isEmpty()) ui.outputDirLineEdit->setText(dirPath);
+}
@@ -0,0 +1,177 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "ExportCache.h"
+#include <QCryptographicHash>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+//increased whenever the renderers change their output for the same settings
+static const int digestVersion = 2;
+
+static QString formatFloat(float value) {
+	//+0 and -0 draw the same image, 9 digits round-trip every float
+	if (value == 0) value = 0;
+	return QString::number(value, 'g', 9);
+}
+
+ExportCache& ExportCache::instance() {
+	static ExportCache cache;
+	return cache;
+}
+
+QByteArray ExportCache::computeDigest(Harmonograph* harmonograph, const ImageSettings& settings) {
+	const DrawParameters& parameters = settings.parameters;
+	const bool isVector = settings.encoder == ImageEncoders::svg || settings.encoder == ImageEncoders::pdf;
+	QStringList fields;
+
+	fields << QString("version=%1").arg(digestVersion);
+	fields << QString("engine=%1").arg(static_cast<int>(harmonograph->engine));
+	if (harmonograph->engine == HarmonographEngines::simulated) {
+		fields << QString("simulation=%1,%2,%3").arg(static_cast<int>(harmonograph->simulation.integrator))
+			.arg(formatFloat(harmonograph->simulation.swingAngle), formatFloat(harmonograph->simulation.coupling));
+	}
+
+	for (Pendulum* p : harmonograph->getPendulums()) {
+		for (Dimension dimension : { Dimension::x, Dimension::y }) {
+			fields << QString("pendulum=%1,%2,%3,%4")
+				.arg(formatFloat(p->getEquationParameter(dimension, EquationParameter::amplitude)))
+				.arg(formatFloat(p->getEquationParameter(dimension, EquationParameter::dumping)))
+				.arg(formatFloat(p->getEquationParameter(dimension, EquationParameter::frequency)))
+				.arg(formatFloat(p->getEquationParameter(dimension, EquationParameter::phase)));
+		}
+	}
+
+	//the zoom of the preview does not reach exports, they fit the curve into the image
+	fields << QString("colors=%1,%2").arg(parameters.primaryColor.rgba()).arg(parameters.backgroundColor.rgba());
+	if (parameters.useTwoColors) fields << QString("second=%1").arg(parameters.secondColor.rgba());
+	fields << QString("pen=%1,%2").arg(parameters.penWidth).arg(static_cast<int>(parameters.useAntiAliasing));
+	fields << QString("mode=%1").arg(static_cast<int>(parameters.drawMode));
+	//lines are drawn at a fixed fine step, except in vector exports of simulated curves,
+	//which write the polyline sampled at the time step
+	const bool isTimeStepUsed = parameters.drawMode == DrawModes::pointsMode || (isVector && harmonograph->engine == HarmonographEngines::simulated);
+	if (isTimeStepUsed) fields << "timeStep=" + formatFloat(parameters.timeStep);
+
+	fields << QString("image=%1x%2,%3").arg(settings.saveWidth).arg(settings.saveHeight).arg(settings.borderPercentage);
+	fields << QString("encoder=%1,%2,%3").arg(static_cast<int>(settings.encoder)).arg(settings.compressionLevel).arg(static_cast<int>(settings.useGpuRenderer));
+	if (isVector) fields << QString("vector=%1,%2").arg(formatFloat(settings.vectorTolerance)).arg(settings.vectorPaletteSize);
+
+	return QCryptographicHash::hash(fields.join("\n").toUtf8(), QCryptographicHash::Sha256).toHex();
+}
+
+void ExportCache::setDirectory(const QString& dirPath) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	if (!dirPath.isEmpty()) QDir().mkpath(dirPath);
+	this->dirPath = dirPath;
+}
+
+QString ExportCache::cachedFilePath(const QByteArray& digest) {
+	return QDir(dirPath).filePath(QString::fromLatin1(digest));
+}
+
+bool ExportCache::acquire(const QByteArray& digest, const ImageSettings& settings) {
+	std::lock_guard<std::mutex> lock(mutex);
+	statistics.requests++;
+
+	const bool hasSidecar = settings.encoder == ImageEncoders::rawRGBA;
+
+	auto found = inFlight.find(digest);
+	if (found != inFlight.end()) {
+		found->second.waitingFilenames.push_back(settings.filename);
+		statistics.coalesced++;
+		return true;
+	}
+
+	if (!dirPath.isEmpty() && QFile::exists(cachedFilePath(digest))) {
+		if (placeFile(cachedFilePath(digest), settings.filename, hasSidecar)) {
+			statistics.hits++;
+			return true;
+		}
+	}
+
+	//the old output may be a link to a cached file
+	QFile::remove(settings.filename);
+	if (hasSidecar) QFile::remove(settings.filename + ".json");
+
+	inFlight[digest].hasSidecar = hasSidecar;
+	statistics.renders++;
+	return false;
+}
+
+void ExportCache::complete(const QByteArray& digest, const QString& filename, bool isWritten, bool isStored) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto found = inFlight.find(digest);
+	if (found == inFlight.end()) return;
+
+	const InFlightExport request = found->second;
+	inFlight.erase(found);
+
+	if (!isWritten) {
+		statistics.failures += 1 + request.waitingFilenames.size();
+		return;
+	}
+
+	if (isStored && !dirPath.isEmpty()) placeFile(filename, cachedFilePath(digest), request.hasSidecar);
+
+	for (const QString& waitingFilename : request.waitingFilenames) {
+		if (waitingFilename == filename) continue;
+		if (!placeFile(filename, waitingFilename, request.hasSidecar)) statistics.failures++;
+	}
+}
+
+bool ExportCache::placeFile(const QString& source, const QString& destination, bool hasSidecar) {
+	if (!linkFile(source, destination)) return false;
+	return !hasSidecar || linkFile(source + ".json", destination + ".json");
+}
+
+bool ExportCache::linkFile(const QString& source, const QString& destination) {
+	QFile::remove(destination);
+
+#ifdef _WIN32
+	const QString nativeSource = QDir::toNativeSeparators(source), nativeDestination = QDir::toNativeSeparators(destination);
+	if (CreateHardLinkW(reinterpret_cast<LPCWSTR>(nativeDestination.utf16()), reinterpret_cast<LPCWSTR>(nativeSource.utf16()), nullptr)) return true;
+#else
+	if (link(QFile::encodeName(source).constData(), QFile::encodeName(destination).constData()) == 0) return true;
+#endif
+
+	//another file system or one without links, a copy is as good
+	return QFile::copy(source, destination);
+}
+
+ExportCacheStatistics ExportCache::getStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+QString ExportCache::getReport() {
+	const ExportCacheStatistics current = getStatistics();
+	const double hitRate = current.requests > 0 ? 100.0 * (current.hits + current.coalesced) / current.requests : 0;
+
+	return QString("Export cache: %1 requests, %2 from the cache, %3 coalesced, %4 rendered, %5 failed, hit rate %6%\n")
+		.arg(current.requests).arg(current.hits).arg(current.coalesced).arg(current.renders).arg(current.failures)
+		.arg(hitRate, 0, 'f', 1);
+}
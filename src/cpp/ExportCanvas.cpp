@@ -0,0 +1,114 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "ExportCanvas.h"
+#include "AllocationTracker.h"
+
+ExportCanvas::ExportCanvas(QImage* image, const DrawParameters& parameters, int saveZoom, int batchSize) {
+	this->parameters = parameters;
+	this->saveZoom = saveZoom;
+	this->batchSize = batchSize;
+	isLines = parameters.drawMode == DrawModes::linesMode;
+
+	painter = new QPainter(image);
+	AllocationTracker::track(painter, "QPainter", sizeof(QPainter));
+	pen.setCapStyle(Qt::RoundCap);
+
+	if (parameters.useAntiAliasing) painter->setRenderHint(QPainter::Antialiasing, true);
+	pen.setColor(Qt::black);
+	pen.setWidth(parameters.penWidth);
+	painter->setPen(pen);
+
+	painter->fillRect(0, 0, image->width(), image->height(), parameters.backgroundColor);
+
+	widthAdd = image->width() / 2;
+	heightAdd = image->height() / 2;
+
+	if (parameters.useTwoColors) {
+		const int stepCount = (int)(maxT / getTimeStep()) + 10;
+
+		stepR = ((float)(parameters.secondColor.red() - parameters.primaryColor.red()) / stepCount);
+		stepG = ((float)(parameters.secondColor.green() - parameters.primaryColor.green()) / stepCount);
+		stepB = ((float)(parameters.secondColor.blue() - parameters.primaryColor.blue()) / stepCount);
+	}
+}
+
+ExportCanvas::~ExportCanvas() {
+	AllocationTracker::untrack(painter);
+	delete painter;
+}
+
+void ExportCanvas::drawSamples(const float* xs, const float* ys, int first, int count) {
+	if (isLines) {
+		for (int j = 0; j < count; j++) {
+			const int i = first + j;
+
+			const float xCurrent = (xs[j] * saveZoom) + widthAdd;
+			const float yCurrent = -(ys[j] * saveZoom) + heightAdd;
+
+			if (i > 0) {
+				const QRgb color = getColor(i);
+				if (color != batchColor || lines.size() >= batchSize) {
+					drawLinesBatch();
+					batchColor = color;
+				}
+				lines.push_back(QLine(xLast, yLast, xCurrent, yCurrent));
+			}
+
+			xLast = xCurrent;
+			yLast = yCurrent;
+		}
+	}
+	else {
+		for (int j = 0; j < count; j++) {
+			const QRgb color = getColor(first + j + 1);
+			if (color != batchColor || points.size() >= batchSize) {
+				drawPointsBatch();
+				batchColor = color;
+			}
+			points.push_back(QPoint((xs[j] * saveZoom) + widthAdd, -(ys[j] * saveZoom) + heightAdd));
+		}
+	}
+}
+
+void ExportCanvas::finish() {
+	drawLinesBatch();
+	drawPointsBatch();
+	painter->end();
+}
+
+void ExportCanvas::drawLinesBatch() {
+	if (lines.empty()) return;
+
+	pen.setColor(QColor(batchColor));
+	painter->setPen(pen);
+	painter->drawLines(lines.data(), lines.size());
+	lines.clear();
+}
+
+void ExportCanvas::drawPointsBatch() {
+	if (points.empty()) return;
+
+	pen.setColor(QColor(batchColor));
+	painter->setPen(pen);
+	painter->drawPoints(points.data(), points.size());
+	points.clear();
+}
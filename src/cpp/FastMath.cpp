@@ -0,0 +1,83 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "FastMath.h"
+#include <algorithm>
+
+static const int accuracySamplesCount = 1 << 20;
+
+template<MathAccuracy accuracy>
+static void measureTier(double maxPhase, double maxExponent, std::vector<FastMathError>& errors) {
+	FastMathError sinError = { "sin", accuracy, FastMath::getTolerance(accuracy), 0, 0 };
+	FastMathError cosError = { "cos", accuracy, FastMath::getTolerance(accuracy), 0, 0 };
+	FastMathError expError = { "exp", accuracy, FastMath::getTolerance(accuracy), 0, 0 };
+
+	for (int i = 0; i <= accuracySamplesCount; i++) {
+		const double phase = maxPhase * i / accuracySamplesCount;
+		float s, c;
+		FastMath::sinCos<accuracy>(phase, s, c);
+
+		const double sinDifference = fabs(s - std::sin(phase));
+		if (sinDifference > sinError.maxError) {
+			sinError.maxError = sinDifference;
+			sinError.worstArgument = phase;
+		}
+		const double cosDifference = fabs(c - std::cos(phase));
+		if (cosDifference > cosError.maxError) {
+			cosError.maxError = cosDifference;
+			cosError.worstArgument = phase;
+		}
+
+		const double exponent = -maxExponent * i / accuracySamplesCount;
+		const double exact = std::exp(exponent);
+		//the curve only sees the absolute error, a relative one on a flushed result means nothing
+		if (exact < 1e-30) continue;
+		const double expDifference = fabs(FastMath::exp<accuracy>(exponent) - exact) / exact;
+		if (expDifference > expError.maxError) {
+			expError.maxError = expDifference;
+			expError.worstArgument = exponent;
+		}
+	}
+
+	errors.push_back(sinError);
+	errors.push_back(cosError);
+	errors.push_back(expError);
+}
+
+double FastMath::getTolerance(MathAccuracy accuracy) {
+	switch (accuracy) {
+	case MathAccuracy::coarse: return 1e-3;
+	case MathAccuracy::medium: return 1e-5;
+	default: return 2e-7;
+	}
+}
+
+std::vector<FastMathError> FastMath::measureAccuracy(double maxFrequency, double maxDumping, double maxTime) {
+	//the phase of a dimension is at most pi, the envelope exponent is -d*t
+	const double maxPhase = maxFrequency * maxTime + 3.14159265358979323846;
+	const double maxExponent = maxDumping * maxTime;
+
+	std::vector<FastMathError> errors;
+	measureTier<MathAccuracy::coarse>(maxPhase, maxExponent, errors);
+	measureTier<MathAccuracy::medium>(maxPhase, maxExponent, errors);
+	measureTier<MathAccuracy::precise>(maxPhase, maxExponent, errors);
+	return errors;
+}
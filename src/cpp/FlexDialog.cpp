@@ -37,6 +37,9 @@ void FlexDialog::changeBase(int value) {
 	else if(value==1){
 		flexBaseMode = FlexModes::frequencyBased;
 	}
+	else if(value==2){
+		flexBaseMode = FlexModes::cometTrail;
+	}
 }
 
 void FlexDialog::useAntialiasingState(int state) {
@@ -19,6 +19,7 @@
  */
 
 #include "FlexWindow.h"
+#include "Tracer.h"
 
 
 FlexWindow::FlexWindow(FlexSettings* settings, QWidget* parent) : QMainWindow(parent) {
@@ -38,19 +39,27 @@ FlexWindow::FlexWindow(FlexSettings* settings, QWidget* parent) : QMainWindow(pa
 	if(parameters.useAntiAliasing){
 		gl->setEnableAA(true);
 	}
+	//a comet trail computes a few samples per frame, there is nothing to trade for time
+	if (settings->flexBaseMode == FlexModes::cometTrail) {
+		cometTrail = new CometTrail(parameters.timeStep, trailWindow, trailSpeed);
+		gl->setCometTrail(cometTrail);
+		trailClock.start();
+	}
+	else {
+		gl->setAdaptiveQuality(true, settings->FPSLimit);
+	}
 	
 	gridLayout->addWidget(gl, 0, 0);
 
 	this->setAttribute(Qt::WA_DeleteOnClose);
 
+	flexBaseMode = settings->flexBaseMode;
 	if (settings->flexBaseMode == FlexModes::frequencyBased)
 		flexSpeedChangeFactor = flexSpeedChangeFactor / 30.0;
 	if (settings->flexBaseMode == FlexModes::phaseBased)
 		flexSpeedChangeFactor = flexSpeedChangeFactor / 2.0;
 
-	flexTimer = new QTimer(this);
 	FPSLimit = settings->FPSLimit;
-	flexTimer->setInterval((int)((1.0/settings->FPSLimit)*1000));
 
 	maximizeAction = new QAction(this);
 	maximizeAction->setShortcut(Qt::Key_F11);
@@ -99,8 +108,6 @@ FlexWindow::FlexWindow(FlexSettings* settings, QWidget* parent) : QMainWindow(pa
 			ySpeedValues.push_back(boundedRandDouble(0.005, 0.01)*slowFactor);
 			xSpeedValues.push_back(boundedRandDouble(0.005, 0.01)*slowFactor);
 		}
-
-		connect(flexTimer, SIGNAL(timeout()), this, SLOT(phaseFlex()));
 	}
 	else {
 		for (Pendulum p : flexGraph->getPendulums()) {
@@ -110,28 +117,63 @@ FlexWindow::FlexWindow(FlexSettings* settings, QWidget* parent) : QMainWindow(pa
 			ySpeedValues.push_back(boundedRandDouble(0.0005, 0.001)*slowFactor);
 			xSpeedValues.push_back(boundedRandDouble(0.0005, 0.001)*slowFactor);
 		}
-
-		connect(flexTimer, SIGNAL(timeout()), this, SLOT(frequencyFlex()));
 	}
 	
-	flexTimer->start();
+	RenderScheduler::instance()->addClient(this);
 	delete settings;
 }
 
 FlexWindow::~FlexWindow() {
+	RenderScheduler::instance()->removeClient(this);
 	delete maximizeAction;
 	delete incSpeedAction;
 	delete decSpeedAction;
 	delete pauseAction;
-	delete flexTimer;
 	delete gl;
+	delete cometTrail;
 }
 
 void FlexWindow::closeEvent(QCloseEvent* event) {
-	flexTimer->stop();
+	RenderScheduler::instance()->removeClient(this);
 	delete manager;
 }
 
+int FlexWindow::getFrameRate() {
+	return FPSLimit;
+}
+
+bool FlexWindow::advanceFrame() {
+	//hidden windows are not evaluated at all, so idle flex windows cost nothing
+	if (isFlexPaused || !gl->isOnScreen()) {
+		if (cometTrail != nullptr) trailClock.restart();
+		return false;
+	}
+
+	if (cometTrail != nullptr) {
+		//wall time, so a late tick does not slow the pen down; a long stall is cut short
+		cometTrail->addTime(std::min(0.25, trailClock.restart() / 1000.0));
+		return true;
+	}
+
+	if (flexBaseMode == FlexModes::phaseBased) phaseFlex();
+	else frequencyFlex();
+	return true;
+}
+
+void FlexWindow::prepareFrame(int samplingThreads) {
+	if (cometTrail != nullptr) {
+		cometTrail->sampleNew(flexGraph);
+		return;
+	}
+
+	manager->setSamplingThreads(samplingThreads);
+	gl->prepareFrame();
+}
+
+void FlexWindow::submitFrame() {
+	gl->update();
+}
+
 void FlexWindow::maximizeWindow() {
 	if (this->isFullScreen()) {
 		this->showNormal();
@@ -143,29 +185,30 @@ void FlexWindow::maximizeWindow() {
 
 
 void FlexWindow::increaseFlexSpeed(){
-	flexTimer->stop();
+	if (cometTrail != nullptr) {
+		cometTrail->setSpeed(cometTrail->getSpeed() * trailSpeedChangeFactor);
+		return;
+	}
+
 	for (int i = 0; i < xSpeedValues.size(); i++) {
 		xSpeedValues.at(i) += flexSpeedChangeFactor;
 		ySpeedValues.at(i) += flexSpeedChangeFactor;
 	}
-	flexTimer->start();
 }
 
 void FlexWindow::decreaseFlexSpeed(){
-	flexTimer->stop();
+	if (cometTrail != nullptr) {
+		cometTrail->setSpeed(cometTrail->getSpeed() / trailSpeedChangeFactor);
+		return;
+	}
+
 	for (int i = 0; i < xSpeedValues.size(); i++) {
 		xSpeedValues.at(i) -= flexSpeedChangeFactor;
 		ySpeedValues.at(i) -= flexSpeedChangeFactor;
 	}
-	flexTimer->start();
 }
 
 void FlexWindow::pauseFlex() {
-	if(isFlexPaused) {
-		flexTimer->start();
-	}else {
-		flexTimer->stop();
-	}
 	isFlexPaused = !isFlexPaused;
 }
 
@@ -176,7 +219,7 @@ void FlexWindow::saveImageToFile() {
 		if (code == 1) {
 			QString fileName = QFileDialog::getSaveFileName(this,
 				tr("Save Harmonograph Image"), "",
-				tr("png image (*.png);;All Files (*)"));
+				ImageEncoder::fileFilter(saveImageDialog->encoder));
 			if (!fileName.isEmpty()) {
 				ImageSettings* imageSettings = new ImageSettings();
 				imageSettings->parameters = manager->getDrawParameters();
@@ -189,6 +232,9 @@ void FlexWindow::saveImageToFile() {
 				imageSettings->saveWidth = saveImageDialog->saveWidth;
 				imageSettings->saveHeight = saveImageDialog->saveHeight;
 				imageSettings->borderPercentage = saveImageDialog->borderPercentage;
+				imageSettings->encoder = saveImageDialog->encoder;
+				imageSettings->compressionLevel = saveImageDialog->compressionLevel;
+				imageSettings->useGpuRenderer = saveImageDialog->useGpuRenderer;
 
 				manager->saveCurrentImage(imageSettings);
 			}
@@ -197,7 +243,7 @@ void FlexWindow::saveImageToFile() {
 }
 
 void FlexWindow::frequencyFlex() {
-	gl->update();
+	TraceSpan flexSpan("frequencyFlex", "flex");
 
 	for (int i = 0; i < flexGraph->getNumOfPendulums();i++) {
 		xFlexStartValues.at(i) += xSpeedValues.at(i);
@@ -221,7 +267,7 @@ void FlexWindow::frequencyFlex() {
 }
 
 void FlexWindow::phaseFlex() {
-	gl->update();
+	TraceSpan flexSpan("phaseFlex", "flex");
 
 	for (int i = 0; i < flexGraph->getNumOfPendulums(); i++) {
 		flexGraph->getPendulums().at(i)->changeDimensionEquationPhase(Dimension::x, xSpeedValues.at(i));
@@ -0,0 +1,90 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "FramePipeline.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+FramePipeline::FramePipeline(int framesCount, int threadsCount, int window) {
+	this->framesCount = framesCount;
+	this->threadsCount = threadsCount > 0 ? threadsCount : std::max(1u, std::thread::hardware_concurrency());
+	this->window = window > 0 ? window : 2 * this->threadsCount;
+}
+
+bool FramePipeline::run(const RenderFunction& render, const SinkFunction& sink) {
+	std::vector<std::thread> workers;
+	for (int i = 0; i < std::min(threadsCount, framesCount); i++) {
+		workers.emplace_back(&FramePipeline::work, this, std::cref(render), std::cref(sink));
+	}
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	finishedFrames.clear();
+	return !isCancelled && nextEmittedFrame == framesCount;
+}
+
+void FramePipeline::cancel() {
+	std::lock_guard<std::mutex> lock(mutex);
+	isCancelled = true;
+	frameEmitted.notify_all();
+}
+
+void FramePipeline::work(const RenderFunction& render, const SinkFunction& sink) {
+	for (;;) {
+		int frame;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			frameEmitted.wait(lock, [this] {
+				return isCancelled || nextFrame >= framesCount || nextFrame < nextEmittedFrame + window;
+			});
+			if (isCancelled || nextFrame >= framesCount) return;
+			frame = nextFrame++;
+		}
+
+		QImage image = render(frame);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		finishedFrames[frame] = image;
+
+		//the thread that is already emitting picks this frame up when its turn comes
+		if (isEmitting) continue;
+		isEmitting = true;
+
+		while (!isCancelled) {
+			auto found = finishedFrames.find(nextEmittedFrame);
+			if (found == finishedFrames.end()) break;
+
+			const QImage ready = found->second;
+			finishedFrames.erase(found);
+
+			lock.unlock();
+			const bool isAccepted = sink(nextEmittedFrame, ready);
+			lock.lock();
+
+			if (!isAccepted) isCancelled = true;
+			nextEmittedFrame++;
+			frameEmitted.notify_all();
+		}
+		isEmitting = false;
+	}
+}
@@ -0,0 +1,167 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "FrameRing.h"
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static std::uint64_t alignUp(std::uint64_t bytes) {
+	return (bytes + FrameRing::alignment - 1) / FrameRing::alignment * FrameRing::alignment;
+}
+
+FrameRing::~FrameRing() {
+	close();
+}
+
+std::uint64_t FrameRing::nowNs() {
+	//steady_clock is CLOCK_MONOTONIC on Linux, the clock readers compare against
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool FrameRing::open(const std::string& name, int slotsCount, int width, int height, std::string& error) {
+	close();
+
+	if (slotsCount < 1 || slotsCount > maxSlotsCount) {
+		error = "slots must be from 1 to " + std::to_string(maxSlotsCount);
+		return false;
+	}
+	if (width < 1 || width > maxSize || height < 1 || height > maxSize) {
+		error = "width and height must be from 1 to " + std::to_string(maxSize);
+		return false;
+	}
+	//one path component under our prefix, so a client cannot name someone else's object
+	if (name.compare(0, strlen(namePrefix), namePrefix) != 0 || name.size() == strlen(namePrefix)
+		|| name.find('/', 1) != std::string::npos || name.size() > 255) {
+		error = std::string("name must be ") + namePrefix + "<name> without further slashes";
+		return false;
+	}
+
+	//in 64 bits: the limits above keep every term far from overflow, the total is checked
+	const std::uint64_t frameBytes = static_cast<std::uint64_t>(width) * 4 * height;
+	const std::uint64_t totalBytes = alignUp(sizeof(FrameRingHeader)) + alignUp(alignUp(sizeof(FrameSlotHeader)) + frameBytes) * slotsCount;
+	if (totalBytes > maxMappingBytes) {
+		error = "slots * width * height * 4 must not exceed " + std::to_string(maxMappingBytes) + " bytes";
+		return false;
+	}
+
+#ifdef _WIN32
+	error = "shared memory frames need POSIX shared memory";
+	return false;
+#else
+	this->slotsCount = slotsCount;
+	this->width = width;
+	this->height = height;
+	stride = width * 4;
+	headerBytes = static_cast<std::size_t>(alignUp(sizeof(FrameRingHeader)));
+	pixelsOffset = static_cast<std::size_t>(alignUp(sizeof(FrameSlotHeader)));
+	slotBytes = static_cast<std::size_t>(alignUp(pixelsOffset + frameBytes));
+	mappingBytes = static_cast<std::size_t>(totalBytes);
+
+	//never reuse an existing object: truncating it and unlinking it on close would destroy it
+	const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0) {
+		error = std::string("shm_open failed: ") + strerror(errno);
+		if (errno == EEXIST) error += ", choose another name or remove the stale /dev/shm" + name;
+		return false;
+	}
+	if (ftruncate(fd, static_cast<off_t>(mappingBytes)) != 0) {
+		error = std::string("ftruncate failed: ") + strerror(errno);
+		::close(fd);
+		shm_unlink(name.c_str());
+		return false;
+	}
+
+	void* address = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (address == MAP_FAILED) {
+		error = std::string("mmap failed: ") + strerror(errno);
+		shm_unlink(name.c_str());
+		return false;
+	}
+	mapping = address;
+	this->name = name;
+	writingSequence = 0;
+
+	FrameRingHeader* header = new (mapping) FrameRingHeader();
+	header->version = 1;
+	header->slotsCount = slotsCount;
+	header->width = width;
+	header->height = height;
+	header->stride = stride;
+	header->pixelsOffset = static_cast<std::uint32_t>(pixelsOffset);
+	header->headerBytes = headerBytes;
+	header->slotBytes = slotBytes;
+	header->latestSequence.store(0);
+	for (int i = 0; i < slotsCount; i++) {
+		FrameSlotHeader* slot = new (static_cast<char*>(mapping) + headerBytes + slotBytes * i) FrameSlotHeader();
+		slot->sequence.store(0);
+	}
+
+	//readers recognize a complete header by its magic, so it goes last
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(header->magic, FrameRingHeader::magicValue, sizeof(header->magic));
+	return true;
+#endif
+}
+
+void FrameRing::close() {
+#ifndef _WIN32
+	if (mapping == nullptr) return;
+
+	munmap(mapping, mappingBytes);
+	shm_unlink(name.c_str());
+	mapping = nullptr;
+#endif
+}
+
+FrameRingHeader* FrameRing::getHeader() const {
+	return static_cast<FrameRingHeader*>(mapping);
+}
+
+FrameSlotHeader* FrameRing::getSlotHeader(std::uint64_t sequence) const {
+	return reinterpret_cast<FrameSlotHeader*>(static_cast<char*>(mapping) + headerBytes + slotBytes * getSlot(sequence));
+}
+
+unsigned char* FrameRing::beginFrame(std::uint64_t& sequence) {
+	sequence = ++writingSequence;
+	FrameSlotHeader* slot = getSlotHeader(sequence);
+
+	slot->sequence.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	return reinterpret_cast<unsigned char*>(slot) + pixelsOffset;
+}
+
+void FrameRing::publishFrame(std::uint64_t commandReceivedNs) {
+	FrameSlotHeader* slot = getSlotHeader(writingSequence);
+	slot->commandReceivedNs = commandReceivedNs;
+	slot->publishedNs = nowNs();
+
+	slot->sequence.store(writingSequence, std::memory_order_release);
+	getHeader()->latestSequence.store(writingSequence, std::memory_order_release);
+}
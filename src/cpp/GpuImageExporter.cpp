@@ -0,0 +1,209 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "GpuImageExporter.h"
+#include "HarmonographSampler.h"
+#include "TrajectoryRenderer.h"
+#include "Tracer.h"
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLFramebufferObject>
+#include <algorithm>
+#include <cstring>
+
+class Tile {
+public:
+	int x, y, width, height;
+};
+
+static void copyTile(QOpenGLExtraFunctions* f, GLuint pixelBuffer, const Tile& tile, QImage& image) {
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+	const uchar* pixels = static_cast<const uchar*>(f->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, tile.width * tile.height * 4, GL_MAP_READ_BIT));
+
+	if (pixels != nullptr) {
+		//OpenGL rows go bottom up
+		for (int row = 0; row < tile.height; row++) {
+			std::memcpy(image.scanLine(tile.y + tile.height - 1 - row) + tile.x * 4, pixels + row * tile.width * 4, tile.width * 4);
+		}
+		f->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+/*
+ * Renders an export on the exporter's thread. The context is created there; the surface was
+ * created on the GUI thread and goes back there to be destroyed.
+ */
+class GpuRenderTask : public QRunnable {
+public:
+	Harmonograph* harmonograph;
+	ImageSettings settings;
+	QOffscreenSurface* surface;
+	GpuImageExporter::DoneFunction done;
+
+	GpuRenderTask(Harmonograph* harmonograph, const ImageSettings& settings, QOffscreenSurface* surface, const GpuImageExporter::DoneFunction& done) {
+		this->harmonograph = harmonograph;
+		this->settings = settings;
+		this->surface = surface;
+		this->done = done;
+	}
+
+	void run() override {
+		const QImage image = GpuImageExporter::renderOn(surface, harmonograph, settings);
+		surface->deleteLater();
+		done(image);
+	}
+};
+
+QThreadPool* GpuImageExporter::getThreadPool() {
+	//one thread: exports share the GPU anyway, and every one needs a context of its own
+	static QThreadPool* pool = [] {
+		QThreadPool* threadPool = new QThreadPool();
+		threadPool->setMaxThreadCount(1);
+		return threadPool;
+	}();
+	return pool;
+}
+
+QImage GpuImageExporter::render(Harmonograph* harmonograph, const ImageSettings& settings) {
+	QOffscreenSurface surface;
+	surface.setFormat(QSurfaceFormat::defaultFormat());
+	surface.create();
+	return renderOn(&surface, harmonograph, settings);
+}
+
+void GpuImageExporter::renderAsync(Harmonograph* harmonograph, const ImageSettings& settings, const DoneFunction& done) {
+	//without threaded OpenGL a context only works on the GUI thread
+	if (!QOpenGLContext::supportsThreadedOpenGL()) {
+		done(render(harmonograph, settings));
+		return;
+	}
+
+	QOffscreenSurface* surface = new QOffscreenSurface();
+	surface->setFormat(QSurfaceFormat::defaultFormat());
+	surface->create();
+	getThreadPool()->start(new GpuRenderTask(harmonograph, settings, surface, done));
+}
+
+void GpuImageExporter::waitForDone() {
+	getThreadPool()->waitForDone();
+}
+
+QImage GpuImageExporter::renderOn(QSurface* surface, Harmonograph* harmonograph, const ImageSettings& settings) {
+	TraceSpan renderSpan("GpuImageExporter::render", "export");
+	QOpenGLContext context;
+	context.setFormat(QSurfaceFormat::defaultFormat());
+	if (!context.create() || !context.makeCurrent(surface)) return QImage();
+
+	//GL objects are released inside, while the context is still current
+	QImage image = renderTiles(context.extraFunctions(), harmonograph, settings);
+
+	context.doneCurrent();
+	return image;
+}
+
+QImage GpuImageExporter::renderTiles(QOpenGLExtraFunctions* f, Harmonograph* harmonograph, const ImageSettings& settings) {
+	const DrawParameters& parameters = settings.parameters;
+	const int width = settings.saveWidth;
+	const int height = settings.saveHeight;
+
+	//same sampling density and gradient length as SaveImageTask
+	const float tStep = parameters.drawMode == DrawModes::linesMode ? 1e-04 : parameters.timeStep;
+	const int count = (int)ceil(255 / tStep);
+	std::vector<float> xs(count), ys(count);
+	HarmonographSampler(harmonograph).sample(0, tStep, count, xs.data(), ys.data());
+
+	float maxX = 0, maxY = 0;
+	for (int i = 0; i < count; i++) {
+		maxX = std::max(maxX, std::abs(xs[i]));
+		maxY = std::max(maxY, std::abs(ys[i]));
+	}
+	float zoom = std::min((width / 2.0f) / maxX, (height / 2.0f) / maxY);
+	zoom -= zoom * settings.borderPercentage / 100.0f;
+
+	TrajectoryRenderer renderer;
+	if (!renderer.initialize()) return QImage();
+	//the measured extent is a valid packing bound for either engine
+	renderer.upload(xs.data(), ys.data(), count, maxX, maxY);
+
+	GLint maxRenderbufferSize = 0, maxTextureSize = 0;
+	f->glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &maxRenderbufferSize);
+	f->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+	const int tileSize = std::min({ maxTileSize, (int)maxRenderbufferSize, (int)maxTextureSize });
+
+	std::vector<Tile> tiles;
+	for (int y = 0; y < height; y += tileSize) {
+		for (int x = 0; x < width; x += tileSize) {
+			tiles.push_back(Tile{ x, y, std::min(tileSize, width - x), std::min(tileSize, height - y) });
+		}
+	}
+
+	QOpenGLFramebufferObjectFormat multisampledFormat;
+	multisampledFormat.setSamples(parameters.useAntiAliasing ? 8 : 0);
+	QOpenGLFramebufferObject multisampled(tileSize, tileSize, multisampledFormat);
+	QOpenGLFramebufferObject resolved(tileSize, tileSize);
+
+	GLuint pixelBuffers[2];
+	f->glGenBuffers(2, pixelBuffers);
+	for (GLuint pixelBuffer : pixelBuffers) {
+		f->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+		f->glBufferData(GL_PIXEL_PACK_BUFFER, tileSize * tileSize * 4, nullptr, GL_STREAM_READ);
+	}
+	f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	//antialiased edges over a transparent background resolve to premultiplied colors
+	const bool isOpaque = parameters.backgroundColor.alpha() == 255;
+	QImage image(width, height, isOpaque ? QImage::Format_RGBA8888 : QImage::Format_RGBA8888_Premultiplied);
+
+	for (int i = 0; i < tiles.size(); i++) {
+		const Tile& tile = tiles[i];
+
+		multisampled.bind();
+		f->glViewport(0, 0, tile.width, tile.height);
+		f->glClearColor(parameters.backgroundColor.redF(), parameters.backgroundColor.greenF(), parameters.backgroundColor.blueF(), parameters.backgroundColor.alphaF());
+		f->glClear(GL_COLOR_BUFFER_BIT);
+
+		//pixel coordinates of this tile, y down, curve centered in the whole image
+		QMatrix4x4 matrix;
+		matrix.ortho(tile.x, tile.x + tile.width, tile.y + tile.height, tile.y, -1, 1);
+		matrix.translate(width / 2.0f, height / 2.0f);
+		matrix.scale(zoom, -zoom);
+		renderer.draw(matrix, parameters, count + 10);
+
+		QOpenGLFramebufferObject::blitFramebuffer(&resolved, QRect(0, 0, tile.width, tile.height), &multisampled, QRect(0, 0, tile.width, tile.height));
+
+		resolved.bind();
+		f->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[i % 2]);
+		f->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		f->glReadPixels(0, 0, tile.width, tile.height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		f->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		//the previous tile has finished transferring while this one was drawn
+		if (i > 0) copyTile(f, pixelBuffers[(i - 1) % 2], tiles[i - 1], image);
+	}
+	if (!tiles.empty()) copyTile(f, pixelBuffers[(tiles.size() - 1) % 2], tiles.back(), image);
+
+	f->glDeleteBuffers(2, pixelBuffers);
+	resolved.release();
+
+	return image;
+}
@@ -19,6 +19,10 @@
  */
 
 #include "Harmonograph.h"
+#include <algorithm>
+#include <stdexcept>
+
+const char* const Harmonograph::allocationType = "Harmonograph";
 
 
 Harmonograph::Harmonograph(int numOfPendulums) {
@@ -36,6 +40,8 @@ Harmonograph::Harmonograph(Harmonograph* harmonograph) {
 	isCircle = harmonograph->isCircle;
 	firstRatioValue = harmonograph->firstRatioValue;
 	secondRatioValue = harmonograph->secondRatioValue;
+	engine = harmonograph->engine;
+	simulation = harmonograph->simulation;
 
 	pendlums = harmonograph->getPundlumsCopy();
 }
@@ -55,15 +61,35 @@ Harmonograph::~Harmonograph() {
 }
 
 float Harmonograph::getCoordinateByTime(Dimension demension, float t) {
-	float c = 0;
+	switch (demension) {
+	case Dimension::x: return getCoordinateByTime<Dimension::x>(t);
+	case Dimension::y: return getCoordinateByTime<Dimension::y>(t);
+	case Dimension::z: return getCoordinateByTime<Dimension::z>(t);
+	default: throw std::out_of_range("unknown dimension");
+	}
+}
+
+float Harmonograph::getDerivativeByTime(Dimension dimension, float t) {
+	switch (dimension) {
+	case Dimension::x: return getDerivativeByTime<Dimension::x>(t);
+	case Dimension::y: return getDerivativeByTime<Dimension::y>(t);
+	case Dimension::z: return getDerivativeByTime<Dimension::z>(t);
+	default: throw std::out_of_range("unknown dimension");
+	}
+}
+
+float Harmonograph::getCoordinateBound(Dimension dimension, float tStart, float tEnd) {
+	float bound = 0;
 
 	for (Pendulum* p : pendlums) {
-		c += p->getCoordinateByTime(demension, t);
+		const float dumping = p->getEquationParameter(dimension, EquationParameter::dumping);
+		bound += std::max(exp(-dumping * tStart), exp(-dumping * tEnd));
 	}
-	return c;
+	return bound;
 }
 
 std::vector<Pendulum*> Harmonograph::getPundlumsCopy() {
+	AllocationSite site("getPundlumsCopy");
 	std::vector<Pendulum*> copies;
 	for (Pendulum* p : pendlums) {
 		copies.push_back(new Pendulum(p));
@@ -71,15 +97,20 @@ std::vector<Pendulum*> Harmonograph::getPundlumsCopy() {
 	return copies;
 }
 void Harmonograph::update() {
+	CounterRandom random(CounterRandom::nextSeed(), 0);
+	update(random);
+}
+
+void Harmonograph::update(CounterRandom& random) {
 	if (isStar && numOfPendulums > 1) {
-		pendlums.at(0)->update((frequencyPoint / (firstRatioValue + secondRatioValue)) * firstRatioValue, isCircle);
+		pendlums.at(0)->update((frequencyPoint / (firstRatioValue + secondRatioValue)) * firstRatioValue, isCircle, random);
 		for (int i = 1; i < pendlums.size(); i++) {
-			pendlums.at(i)->update((frequencyPoint / (firstRatioValue + secondRatioValue)) * secondRatioValue, isCircle);
+			pendlums.at(i)->update((frequencyPoint / (firstRatioValue + secondRatioValue)) * secondRatioValue, isCircle, random);
 		}
 	}
 	else {
 		for (Pendulum* p : pendlums) {
-			p->update(frequencyPoint, isCircle);
+			p->update(frequencyPoint, isCircle, random);
 		}
 	}
 }
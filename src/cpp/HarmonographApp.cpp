@@ -19,6 +19,9 @@
  */
 
 #include "HarmonographApp.h"
+#include "GpuImageExporter.h"
+#include "Tracer.h"
+#include <cstdio>
 
 
 HarmonographApp::HarmonographApp(QWidget *parent) : QMainWindow(parent)
@@ -27,31 +30,10 @@ HarmonographApp::HarmonographApp(QWidget *parent) : QMainWindow(parent)
     QApplication::setStyle(QStyleFactory::create("Fusion"));
     QApplication::setWindowIcon(QIcon(":/HarmonographApp/assets/icon.png"));
 
-	/*creating Preferences folder and empty color templates file*/
-    const QFileInfo userTemplatesFileInfo(QDir(preferencesDirPath), userTemplatesFileName);
-	
-	if(!userTemplatesFileInfo.exists()) {
-        QFile file(userTemplatesFileInfo.absoluteFilePath());
-        try {
-            QDir().mkpath(userTemplatesFileInfo.absolutePath());
-
-
-            file.open(QIODevice::ReadWrite);
-
-            QJsonDocument document;
-            QJsonObject root;
-            QJsonArray array;
-
-            root.insert("preferences", array);
-            document.setObject(root);
+    StartupTrace::mark("main window ui");
 
-            file.write(QJsonDocument(document).toJson(QJsonDocument::Indented));
-
-
-        }catch (...) {   
-        }
-        file.close();
-	}
+    //template files are scanned while the window is built and shown
+    colorTemplatesFuture = std::async(std::launch::async, &ColorTemplatesDialog::loadTemplates, preferencesDirPath, userTemplatesFileName);
 
     manager = new HarmonographManager();
 
@@ -64,6 +46,27 @@ HarmonographApp::HarmonographApp(QWidget *parent) : QMainWindow(parent)
     GLWidget2D->setMinimumWidth(1280);
     GLWidget2D->setEnableAA(true);
     gridLayout2D->addWidget(GLWidget2D, 1, 1);
+    StartupTrace::mark("manager and GL widget");
+
+    pendulumsTableModel = new PendulumsTableModel(manager, this);
+
+    QTableView* pendulumsTableView = new QTableView(this);
+    pendulumsTableView->setModel(pendulumsTableModel);
+    pendulumsTableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    pendulumsTableView->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QDockWidget* pendulumsDockWidget = new QDockWidget("Pendulums", this);
+    pendulumsDockWidget->setFeatures(QDockWidget::NoDockWidgetFeatures);
+    pendulumsDockWidget->setWidget(pendulumsTableView);
+    addDockWidget(Qt::RightDockWidgetArea, pendulumsDockWidget);
+    tabifyDockWidget(ui.parametersDockWidget, pendulumsDockWidget);
+    ui.parametersDockWidget->raise();
+
+    cacheStatisticsLabel = new QLabel(this);
+    ui.statusBar->addPermanentWidget(cacheStatisticsLabel);
+    vertexMemoryLabel = new QLabel(this);
+    ui.statusBar->addPermanentWidget(vertexMemoryLabel);
+    StartupTrace::mark("docks");
 
     auto gridLayout3D = dynamic_cast<QGridLayout*>(ui.tab3D->layout());
 
@@ -137,9 +140,19 @@ HarmonographApp::HarmonographApp(QWidget *parent) : QMainWindow(parent)
     QPushButton* loadColorPreferencesBtn = new QPushButton(this);
     loadColorPreferencesBtn->setText("Color templates...");
     ui.mainToolBar->addWidget(loadColorPreferencesBtn);
+    StartupTrace::mark("toolbar");
 
     connect(autoRotationTimer, SIGNAL(timeout()), this, SLOT(autoRotationTimerTimeout()));
 
+    connect(manager, SIGNAL(parameterChanged(int, Dimension, EquationParameter, float)),
+        this, SLOT(pendulumParameterChanged(int, Dimension, EquationParameter, float)));
+    connect(manager, SIGNAL(pendulumsChanged()), this, SLOT(pendulumsChanged()));
+    connect(manager, SIGNAL(interactionFinished()), this, SLOT(redrawImage()));
+    //a slider drag ends on release, a click or key press on a slider ends by the manager's settle timer
+    for (QSlider* slider : ui.centralWidget->findChildren<QSlider*>()) {
+        connect(slider, SIGNAL(sliderReleased()), manager, SLOT(finishInteraction()));
+    }
+
     connect(useTwoColorsCheckBox, SIGNAL(clicked(bool)), this, SLOT(useTwoColorsCheckBoxChanged(bool)));
 
     connect(timeSpinBox, SIGNAL(valueChanged(double)), this, SLOT(timeStepChanged(double)));
@@ -152,7 +165,9 @@ HarmonographApp::HarmonographApp(QWidget *parent) : QMainWindow(parent)
     connect(backColorBtn, SIGNAL(clicked()), this, SLOT(backgroundColorBtnClicked()));
     connect(loadColorPreferencesBtn, SIGNAL(clicked()), this, SLOT(loadColorPreferencesBtnClicked()));
 
+    refreshParameterSliders();
     redrawImage();
+    StartupTrace::mark("connections and sliders");
 }
 
 void HarmonographApp::updateImage(){
@@ -163,102 +178,132 @@ void HarmonographApp::updateImage(){
 
 HarmonographApp::~HarmonographApp() {
     QThreadPool::globalInstance()->clear();
+    //a GPU export uses its surface until it is done, the surface goes with the application
+    GpuImageExporter::waitForDone();
+    if (colorTemplatesFuture.valid()) colorTemplatesFuture.wait();
 }
 
-void HarmonographApp::redrawImage() {
-	GLWidget2D->update();
-
-    std::vector<Pendulum*> pendlums = manager->getPendulumsCopy();
-    float pi = manager->pi;
+FlexDialog* HarmonographApp::getFlexDialog() {
+    if (flexDialog == nullptr) flexDialog = new FlexDialog(this);
+    return flexDialog;
+}
 
-    ui.firstXDamping->blockSignals(true);
-    ui.firstXFreq->blockSignals(true);
-    ui.firstXPhase->blockSignals(true);
+SaveImageDialog* HarmonographApp::getSaveImageDialog() {
+    if (saveImageDialog == nullptr) saveImageDialog = new SaveImageDialog(this);
+    return saveImageDialog;
+}
 
-    ui.firstYDamping->blockSignals(true);
-    ui.firstYFreq->blockSignals(true);
-    ui.firstYPhase->blockSignals(true);
+ColorTemplatesDialog* HarmonographApp::getColorTemplatesDialog() {
+    if (colorTemplatesDialog == nullptr) colorTemplatesDialog = new ColorTemplatesDialog(colorTemplatesFuture.get(), this);
+    return colorTemplatesDialog;
+}
 
+ExploreDialog* HarmonographApp::getExploreDialog() {
+    if (exploreDialog == nullptr) exploreDialog = new ExploreDialog(this);
+    return exploreDialog;
+}
 
-    ui.firstXDamping->setValue((pendlums.at(0)->getEquationParameter(Dimension::x, EquationParameter::dumping) * manager->sliderMaxValue) / manager->maxDampingValue);
-    ui.firstXFreq->setValue((pendlums.at(0)->getEquationParameter(Dimension::x, EquationParameter::frequencyNoise) * manager->sliderMaxValue) / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2));
-	
-    ui.firstXPhase->setValue(((pendlums.at(0)->getEquationParameter(Dimension::x, EquationParameter::phase) -
-        (floor(pendlums.at(0)->getEquationParameter(Dimension::x, EquationParameter::phase) / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi))
-        * (manager->sliderMaxValue + manager->sliderMaxValue / 10));
+SweepDialog* HarmonographApp::getSweepDialog() {
+    if (sweepDialog == nullptr) sweepDialog = new SweepDialog(this);
+    return sweepDialog;
+}
 
-	
-    ui.firstYDamping->setValue((pendlums.at(0)->getEquationParameter(Dimension::y, EquationParameter::dumping) * manager->sliderMaxValue) / manager->maxDampingValue);
-    ui.firstYFreq->setValue((pendlums.at(0)->getEquationParameter(Dimension::y, EquationParameter::frequencyNoise) * manager->sliderMaxValue)
-        / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2));
-	
-    ui.firstYPhase->setValue(((pendlums.at(0)->getEquationParameter(Dimension::y, EquationParameter::phase) -
-        (floor(pendlums.at(0)->getEquationParameter(Dimension::y, EquationParameter::phase) / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi))
-        * (manager->sliderMaxValue + manager->sliderMaxValue / 10));
+SimulationDialog* HarmonographApp::getSimulationDialog() {
+    if (simulationDialog == nullptr) simulationDialog = new SimulationDialog(this);
+    return simulationDialog;
+}
 
+void HarmonographApp::redrawImage() {
+	TraceSpan redrawSpan("redrawImage", "ui");
+	GLWidget2D->update();
+}
 
-    ui.firstXDamping->blockSignals(false);
-    ui.firstXFreq->blockSignals(false);
-    ui.firstXPhase->blockSignals(false);
+QSlider* HarmonographApp::getParameterSlider(int pendulumNum, Dimension dimension, EquationParameter parameter) {
+    const bool isX = dimension == Dimension::x;
 
-    ui.firstYDamping->blockSignals(false);
-    ui.firstYFreq->blockSignals(false);
-    ui.firstYPhase->blockSignals(false);
+    switch (parameter) {
+    case EquationParameter::dumping:
+        if (pendulumNum == 0) return isX ? ui.firstXDamping : ui.firstYDamping;
+        if (pendulumNum == 1) return isX ? ui.secondXDamping : ui.secondYDamping;
+        if (pendulumNum == 2) return isX ? ui.thridXDamping : ui.thirdYDamping;
+        break;
+    case EquationParameter::frequencyNoise:
+        if (pendulumNum == 0) return isX ? ui.firstXFreq : ui.firstYFreq;
+        if (pendulumNum == 1) return isX ? ui.secondXFrequency : ui.secondyFrequency;
+        if (pendulumNum == 2) return isX ? ui.thirdXFrequency : ui.thirdYFrequency;
+        break;
+    case EquationParameter::phase:
+        if (pendulumNum == 0) return isX ? ui.firstXPhase : ui.firstYPhase;
+        if (pendulumNum == 1) return isX ? ui.secondXPhase : ui.secondYPhase;
+        if (pendulumNum == 2) return isX ? ui.thirdXPhase : ui.thirdYPhase;
+        break;
+    default:
+        break;
+    }
+    return nullptr;
+}
 
-    if (pendlums.size() >= 2) {
-        ui.secondXDamping->blockSignals(true);
-        ui.secondXFrequency->blockSignals(true);
-        ui.secondXPhase->blockSignals(true);
+void HarmonographApp::setParameterSliderValue(int pendulumNum, Dimension dimension, EquationParameter parameter, float value) {
+    if (dimension == Dimension::z) return;
 
-        ui.secondYDamping->blockSignals(true);
-        ui.secondyFrequency->blockSignals(true);
-        ui.secondYPhase->blockSignals(true);
+    QSlider* slider = getParameterSlider(pendulumNum, dimension, parameter);
+    if (slider == nullptr) return;
 
+    const float pi = manager->pi;
+    int sliderValue = 0;
 
-        ui.secondXDamping->setValue((pendlums.at(1)->getEquationParameter(Dimension::x, EquationParameter::dumping) * manager->sliderMaxValue) / manager->maxDampingValue);
-        ui.secondXFrequency->setValue((pendlums.at(1)->getEquationParameter(Dimension::x, EquationParameter::frequencyNoise) * manager->sliderMaxValue) / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2));
-        ui.secondXPhase->setValue(((pendlums.at(1)->getEquationParameter(Dimension::x, EquationParameter::phase) - (floor(pendlums.at(1)->getEquationParameter(Dimension::x, EquationParameter::phase) / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi)) * (manager->sliderMaxValue + manager->sliderMaxValue / 10));
+    switch (parameter) {
+    case EquationParameter::dumping:
+        sliderValue = (value * manager->sliderMaxValue) / manager->maxDampingValue;
+        break;
+    case EquationParameter::frequencyNoise:
+        sliderValue = (value * manager->sliderMaxValue) / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2);
+        break;
+    case EquationParameter::phase:
+        sliderValue = ((value - (floor(value / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi))
+            * (manager->sliderMaxValue + manager->sliderMaxValue / 10);
+        break;
+    default:
+        return;
+    }
 
-        ui.secondYDamping->setValue((pendlums.at(1)->getEquationParameter(Dimension::y, EquationParameter::dumping) * manager->sliderMaxValue) / manager->maxDampingValue);
-        ui.secondyFrequency->setValue((pendlums.at(1)->getEquationParameter(Dimension::y, EquationParameter::frequencyNoise) * manager->sliderMaxValue) / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2));
-        ui.secondYPhase->setValue(((pendlums.at(1)->getEquationParameter(Dimension::y, EquationParameter::phase) - (floor(pendlums.at(1)->getEquationParameter(Dimension::x, EquationParameter::phase) / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi)) * (manager->sliderMaxValue + manager->sliderMaxValue / 10));
+    if (slider->value() == sliderValue) return;
 
+    slider->blockSignals(true);
+    slider->setValue(sliderValue);
+    slider->blockSignals(false);
+}
 
-        ui.secondXDamping->blockSignals(false);
-        ui.secondXFrequency->blockSignals(false);
-        ui.secondXPhase->blockSignals(false);
+void HarmonographApp::refreshParameterSliders() {
+    const int visiblePendulums = std::min(manager->getNumOfPendulums(), 3);
 
-        ui.secondYDamping->blockSignals(false);
-        ui.secondyFrequency->blockSignals(false);
-        ui.secondYPhase->blockSignals(false);
+    for (int i = 0; i < visiblePendulums; i++) {
+        for (Dimension dimension : { Dimension::x, Dimension::y }) {
+            for (EquationParameter parameter : { EquationParameter::dumping, EquationParameter::frequencyNoise, EquationParameter::phase }) {
+                setParameterSliderValue(i, dimension, parameter, manager->getEquationParameter(i, dimension, parameter));
+            }
+        }
     }
-    if (pendlums.size() >= 3) {
-        ui.thridXDamping->blockSignals(true);
-        ui.thirdXFrequency->blockSignals(true);
-        ui.thirdXPhase->blockSignals(true);
-
-        ui.thirdYDamping->blockSignals(true);
-        ui.thirdYFrequency->blockSignals(true);
-        ui.thirdYPhase->blockSignals(true);
-
-
-        ui.thridXDamping->setValue((pendlums.at(2)->getEquationParameter(Dimension::x, EquationParameter::dumping) * manager->sliderMaxValue) / manager->maxDampingValue);
-        ui.thirdXFrequency->setValue((pendlums.at(2)->getEquationParameter(Dimension::x, EquationParameter::frequencyNoise) * manager->sliderMaxValue) / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2));
-        ui.thirdXPhase->setValue(((pendlums.at(2)->getEquationParameter(Dimension::x, EquationParameter::phase) - (floor(pendlums.at(2)->getEquationParameter(Dimension::x, EquationParameter::phase) / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi)) * (manager->sliderMaxValue + manager->sliderMaxValue / 10));
+}
 
-        ui.thirdYDamping->setValue((pendlums.at(2)->getEquationParameter(Dimension::y, EquationParameter::dumping) * manager->sliderMaxValue) / manager->maxDampingValue);
-        ui.thirdYFrequency->setValue((pendlums.at(2)->getEquationParameter(Dimension::y, EquationParameter::frequencyNoise) * manager->sliderMaxValue) / (2 * manager->maxFreqModuleValue) + (manager->sliderMaxValue / 2));
-        ui.thirdYPhase->setValue(((pendlums.at(2)->getEquationParameter(Dimension::y, EquationParameter::phase) - (floor(pendlums.at(2)->getEquationParameter(Dimension::y, EquationParameter::phase) / (2.0 * pi)) * 2.0 * pi)) / (2.0 * pi)) * (manager->sliderMaxValue + manager->sliderMaxValue / 10));
+void HarmonographApp::pendulumParameterChanged(int pendulumNum, Dimension dimension, EquationParameter parameter, float value) {
+    setParameterSliderValue(pendulumNum, dimension, parameter, value);
+}
 
+void HarmonographApp::pendulumsChanged() {
+    refreshParameterSliders();
 
-        ui.thridXDamping->blockSignals(false);
-        ui.thirdXFrequency->blockSignals(false);
-        ui.thirdXPhase->blockSignals(false);
+    const TrajectoryCacheStatistics statistics = manager->getTrajectoryCacheStatistics();
+    cacheStatisticsLabel->setText(tr("Trajectory cache: %1 hits (%2 from disk), %3 misses, %4 MB")
+        .arg(statistics.memoryHits + statistics.diskHits)
+        .arg(statistics.diskHits)
+        .arg(statistics.misses)
+        .arg(statistics.memoryBytes / (1 << 20)));
+    vertexMemoryLabel->setText(GLWidget2D->getVertexMemoryReport());
+}
 
-        ui.thirdYDamping->blockSignals(false);
-        ui.thirdYFrequency->blockSignals(false);
-        ui.thirdYPhase->blockSignals(false);
-    }
+void HarmonographApp::setTrajectoryCacheDir(QString dirPath) {
+    manager->setTrajectoryCacheDir(dirPath);
 }
 
 void HarmonographApp::changeParameter(int pendulumNum, EquationParameter parameter, Dimension dimension, int value) {
@@ -270,9 +315,12 @@ void HarmonographApp::autoRotate()
 {
     if (autoRotationTimer->isActive()) {
         autoRotationTimer->stop();
+        GLWidget2D->setAdaptiveQuality(false);
+        manager->finishInteraction();
+        redrawImage();
     }
     else {
-        autoRotationTimer->start();
+        startAutoRotation();
     }
 }
 
@@ -285,26 +333,67 @@ void HarmonographApp::undoUpdate() {
 
 void HarmonographApp::startFlex() {
 
-    int code = flexDialog->exec();
+    int code = getFlexDialog()->exec();
 
     if (code==1) {
-        DrawParameters params = manager->getDrawParameters();
-        FlexSettings* flexSettings = new FlexSettings();
-        flexSettings->flexGraph = manager->getHarmCopy();
-        flexSettings->flexBaseMode = flexDialog->flexBaseMode;
-        params.useAntiAliasing = flexDialog->useAntiAliasing;
-        flexSettings->FPSLimit = flexDialog->FPS;
-
-        flexSettings->parameters = params;
-        FlexWindow* flexWindow = new FlexWindow(flexSettings, this);
-        flexWindow->setFixedWidth(1280);
-        flexWindow->setFixedHeight(720);
-        flexWindow->show();
+        openFlexWindow(flexDialog->flexBaseMode, flexDialog->useAntiAliasing, flexDialog->FPS);
+    }
+}
+
+void HarmonographApp::openFlexWindow(FlexModes flexBaseMode, bool useAntiAliasing, int fps) {
+    DrawParameters params = manager->getDrawParameters();
+    FlexSettings* flexSettings = new FlexSettings();
+    flexSettings->flexGraph = manager->getHarmCopy();
+    flexSettings->flexBaseMode = flexBaseMode;
+    params.useAntiAliasing = useAntiAliasing;
+    flexSettings->FPSLimit = fps;
+
+    flexSettings->parameters = params;
+    FlexWindow* flexWindow = new FlexWindow(flexSettings, this);
+    flexWindow->setFixedWidth(1280);
+    flexWindow->setFixedHeight(720);
+    flexWindow->show();
+}
+
+bool HarmonographApp::startControlServer(QString socketPath) {
+    controlServer = new ControlServer(manager, this);
+    connect(controlServer, SIGNAL(stateChanged()), this, SLOT(controlStateChanged()));
+
+    if (!controlServer->listen(socketPath)) {
+        fprintf(stderr, "Cannot listen on %s: %s\n", qPrintable(socketPath), qPrintable(controlServer->getErrorString()));
+        return false;
     }
+    return true;
+}
+
+void HarmonographApp::controlStateChanged() {
+    //sliders follow the parameter signals of the manager, only the toolbar is refreshed here
+    const DrawParameters parameters = manager->getDrawParameters();
+    penWidthSpinBox->blockSignals(true);
+    timeSpinBox->blockSignals(true);
+    ui.numOfPendulumsSpinBox->blockSignals(true);
+    penWidthSpinBox->setValue(parameters.penWidth);
+    timeSpinBox->setValue(parameters.timeStep);
+    ui.numOfPendulumsSpinBox->setValue(manager->getNumOfPendulums());
+    penWidthSpinBox->blockSignals(false);
+    timeSpinBox->blockSignals(false);
+    ui.numOfPendulumsSpinBox->blockSignals(false);
+
+    redrawImage();
+}
+
+void HarmonographApp::startAutoRotation() {
+    if (autoRotationTimer->isActive()) return;
+
+    GLWidget2D->setAdaptiveQuality(true, 1000 / autoRotationTimer->interval());
+    autoRotationTimer->start();
 }
 
 void HarmonographApp::autoRotationTimerTimeout()
 {
+    //a minimized or covered window does not rotate at all
+    if (!GLWidget2D->isOnScreen()) return;
+
     manager->changeXAxisRotation(0.05);
     redrawImage();
 }
@@ -313,12 +402,12 @@ void HarmonographApp::saveImage() {
     bool wasRotationActive = autoRotationTimer->isActive();
     autoRotationTimer->stop();
 
-    int code = saveImageDialog->exec();
+    int code = getSaveImageDialog()->exec();
 
     if (code == 1) {
         QString fileName = QFileDialog::getSaveFileName(this,
             tr("Save Harmonograph Image"), "",
-            tr("png image (*.png);;All Files (*)"));
+            ImageEncoder::fileFilter(saveImageDialog->encoder));
         if (!fileName.isEmpty()) {
             ImageSettings* imageSettings = new ImageSettings();
             imageSettings->parameters = manager->getDrawParameters();
@@ -331,6 +420,9 @@ void HarmonographApp::saveImage() {
             imageSettings->saveWidth = saveImageDialog->saveWidth;
             imageSettings->saveHeight = saveImageDialog->saveHeight;
             imageSettings->borderPercentage = saveImageDialog->borderPercentage;
+            imageSettings->encoder = saveImageDialog->encoder;
+            imageSettings->compressionLevel = saveImageDialog->compressionLevel;
+            imageSettings->useGpuRenderer = saveImageDialog->useGpuRenderer;
 
             manager->saveCurrentImage(imageSettings);
         }
@@ -369,6 +461,7 @@ void HarmonographApp::loadParametersFromFile() {
         ui.numOfPendulumsSpinBox->blockSignals(true);
 
         autoRotationTimer->stop();
+        GLWidget2D->setAdaptiveQuality(false);
         manager->loadParametersFromFile(fileName);
 
         Harmonograph* harmCopy = manager->getHarmCopy();
@@ -396,6 +489,39 @@ void HarmonographApp::loadParametersFromFile() {
     }
 }
 
+void HarmonographApp::explore() {
+    if (getExploreDialog()->exec() == QDialog::Accepted) {
+        //candidates use the current pendulum count, ratio and circle settings
+        QThreadPool::globalInstance()->start(new ExplorationTask(manager->getHarmCopy(), exploreDialog->settings));
+        ui.statusBar->showMessage(tr("Exploring %1 harmonographs into %2").arg(exploreDialog->settings.candidatesCount).arg(exploreDialog->settings.outputDirPath), 5000);
+    }
+}
+
+void HarmonographApp::sweep() {
+    if (getSweepDialog()->exec() == QDialog::Accepted) {
+        QString fileName = QFileDialog::getSaveFileName(this,
+            tr("Save contact sheet"), "",
+            ImageEncoder::fileFilter(ImageEncoders::parallelPng));
+        if (!fileName.isEmpty()) {
+            SweepSettings settings;
+            settings.columns = sweepDialog->columns;
+            settings.rows = sweepDialog->rows;
+            settings.cellSize = sweepDialog->cellSize;
+            settings.parameters = manager->getDrawParameters();
+            settings.filename = fileName;
+
+            QThreadPool::globalInstance()->start(new SweepTask(manager->getHarmCopy(), settings));
+        }
+    }
+}
+
+void HarmonographApp::changeSimulation() {
+    getSimulationDialog()->setValues(manager->getEngine(), manager->getSimulationSettings());
+    if (simulationDialog->exec() == QDialog::Accepted) {
+        manager->setSimulation(simulationDialog->engine, simulationDialog->settings);
+    }
+}
+
 void HarmonographApp::ratioCheckBoxCliked(bool checked) {
     ui.firstRatioValueSpinBox->setEnabled(checked);
     ui.colonLabel->setEnabled(checked);
@@ -439,6 +565,7 @@ void HarmonographApp::timeStepChanged(double step) {
     step = step < 0.001 ? 0.001 : step;
     step = step > 0.1 ? 0.1 : step;
     manager->setTimeStep(step);
+    vertexMemoryLabel->setText(GLWidget2D->getVertexMemoryReport());
     redrawImage();
 }
 
@@ -494,7 +621,7 @@ void HarmonographApp::backgroundColorBtnClicked() {
 }
 
 void HarmonographApp::loadColorPreferencesBtnClicked() {
-    colorTemplatesDialog->preferencesDirPath = preferencesDirPath;
+    getColorTemplatesDialog()->preferencesDirPath = preferencesDirPath;
     colorTemplatesDialog->userTemplatesFileName = userTemplatesFileName;
 
     DrawParameters params = manager->getDrawParameters();
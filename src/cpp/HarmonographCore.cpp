@@ -0,0 +1,209 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "HarmonographCore.h"
+#include "Harmonograph.h"
+#include "HarmonographSampler.h"
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <vector>
+
+struct hg_harmonograph {
+	//Harmonograph does not own its pendulums, the handle does; each pendulum owns its dimensions
+	std::vector<std::unique_ptr<Pendulum>> pendulums;
+	std::unique_ptr<Harmonograph> harmonograph;
+	HarmonographSampler sampler;
+
+	void build(const hg_pendulum* parameters, int count, float frequencyPoint) {
+		harmonograph.reset();
+		pendulums.clear();
+
+		std::vector<Pendulum*> created;
+		for (int i = 0; i < count; i++) {
+			std::vector<PendulumDimension*> pendulumDimensions;
+			for (const hg_dimension* d : { &parameters[i].x, &parameters[i].y }) {
+				pendulumDimensions.push_back(new PendulumDimension(d->amplitude, d->frequency, d->phase, d->damping, d->frequency - frequencyPoint));
+			}
+			pendulums.emplace_back(new Pendulum(pendulumDimensions));
+			created.push_back(pendulums.back().get());
+		}
+
+		harmonograph.reset(new Harmonograph(created, 1, 1, false, false, frequencyPoint));
+		sampler.load(harmonograph.get());
+	}
+
+	void randomize(int count, float frequencyPoint, uint64_t seed) {
+		const std::vector<hg_pendulum> parameters(count, hg_pendulum{ { 1, frequencyPoint, 0, 0 }, { 1, frequencyPoint, 0, 0 } });
+		build(parameters.data(), count, frequencyPoint);
+
+		CounterRandom random(seed, 0);
+		harmonograph->update(random);
+		sampler.load(harmonograph.get());
+	}
+};
+
+static bool isValid(const hg_pendulum* pendulums, int count) {
+	return count > 0 && pendulums != nullptr;
+}
+
+int hg_abi_version(void) {
+	return HG_ABI_VERSION;
+}
+
+hg_harmonograph* hg_create(const hg_pendulum* pendulums, int count) {
+	if (!isValid(pendulums, count)) return nullptr;
+
+	try {
+		std::unique_ptr<hg_harmonograph> harmonograph(new hg_harmonograph());
+		harmonograph->build(pendulums, count, 0);
+		return harmonograph.release();
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+hg_harmonograph* hg_create_random(int count, float frequency_point, uint64_t seed) {
+	if (count <= 0 || frequency_point <= 0) return nullptr;
+
+	try {
+		std::unique_ptr<hg_harmonograph> harmonograph(new hg_harmonograph());
+		harmonograph->randomize(count, frequency_point, seed);
+		return harmonograph.release();
+	}
+	catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void hg_destroy(hg_harmonograph* harmonograph) {
+	delete harmonograph;
+}
+
+int hg_get_pendulum_count(const hg_harmonograph* harmonograph) {
+	return harmonograph == nullptr ? 0 : static_cast<int>(harmonograph->pendulums.size());
+}
+
+int hg_get_pendulums(const hg_harmonograph* harmonograph, hg_pendulum* pendulums, int capacity) {
+	if (harmonograph == nullptr || pendulums == nullptr) return hg_invalid_argument;
+
+	const int count = std::min(capacity, hg_get_pendulum_count(harmonograph));
+	for (int i = 0; i < count; i++) {
+		Pendulum* pendulum = harmonograph->pendulums[i].get();
+		hg_dimension* dimensions[] = { &pendulums[i].x, &pendulums[i].y };
+
+		for (Dimension dimension : { Dimension::x, Dimension::y }) {
+			hg_dimension* d = dimensions[static_cast<int>(dimension)];
+			d->amplitude = pendulum->getEquationParameter(dimension, EquationParameter::amplitude);
+			d->frequency = pendulum->getEquationParameter(dimension, EquationParameter::frequency);
+			d->phase = pendulum->getEquationParameter(dimension, EquationParameter::phase);
+			d->damping = pendulum->getEquationParameter(dimension, EquationParameter::dumping);
+		}
+	}
+	return count;
+}
+
+int hg_set_pendulums(hg_harmonograph* harmonograph, const hg_pendulum* pendulums, int count) {
+	if (harmonograph == nullptr || !isValid(pendulums, count)) return hg_invalid_argument;
+
+	try {
+		//copied first, the caller may pass the array hg_get_pendulums filled
+		const std::vector<hg_pendulum> parameters(pendulums, pendulums + count);
+		harmonograph->build(parameters.data(), count, harmonograph->harmonograph->frequencyPoint);
+		return hg_ok;
+	}
+	catch (const std::bad_alloc&) {
+		return hg_out_of_memory;
+	}
+}
+
+int hg_randomize(hg_harmonograph* harmonograph, float frequency_point, uint64_t seed) {
+	if (harmonograph == nullptr || frequency_point <= 0) return hg_invalid_argument;
+
+	try {
+		harmonograph->randomize(hg_get_pendulum_count(harmonograph), frequency_point, seed);
+		return hg_ok;
+	}
+	catch (const std::bad_alloc&) {
+		return hg_out_of_memory;
+	}
+}
+
+int hg_sample(const hg_harmonograph* harmonograph, double t_start, double t_step, int count, float* xs, float* ys) {
+	if (harmonograph == nullptr || count < 0 || xs == nullptr || ys == nullptr) return hg_invalid_argument;
+
+	harmonograph->sampler.sample(t_start, t_step, count, xs, ys);
+	return hg_ok;
+}
+
+float hg_bound(const hg_harmonograph* harmonograph, int dimension, float t_start, float t_end) {
+	if (harmonograph == nullptr || dimension < 0 || dimension > 1) return 0;
+	return harmonograph->harmonograph->getCoordinateBound(static_cast<Dimension>(dimension), t_start, t_end);
+}
+
+void hg_default_raster_settings(hg_raster_settings* settings) {
+	if (settings == nullptr) return;
+
+	const RasterSettings defaults;
+	settings->width = defaults.width;
+	settings->height = defaults.height;
+	settings->border = defaults.borderPercentage;
+	settings->draw_mode = hg_lines;
+	settings->pen_width = defaults.penWidth;
+	settings->anti_aliasing = defaults.useAntiAliasing;
+	settings->time_step = defaults.timeStep;
+	settings->use_two_colors = defaults.useTwoColors;
+	settings->primary_color = defaults.primaryColor;
+	settings->second_color = defaults.secondColor;
+	settings->background_color = defaults.backgroundColor;
+}
+
+int hg_render(const hg_harmonograph* harmonograph, const hg_raster_settings* settings, uint32_t* pixels, int stride) {
+	if (harmonograph == nullptr || settings == nullptr || pixels == nullptr) return hg_invalid_argument;
+	//in 64 bits, width * 4 overflows int for widths a stride can not hold anyway
+	if (settings->width <= 0 || settings->height <= 0 || stride % 4 != 0) return hg_invalid_argument;
+	if (static_cast<long long>(stride) < static_cast<long long>(settings->width) * 4) return hg_invalid_argument;
+	if (settings->pen_width <= 0 || settings->time_step <= 0) return hg_invalid_argument;
+
+	RasterSettings rasterSettings;
+	rasterSettings.width = settings->width;
+	rasterSettings.height = settings->height;
+	rasterSettings.borderPercentage = settings->border;
+	rasterSettings.drawMode = settings->draw_mode == hg_points ? DrawModes::pointsMode : DrawModes::linesMode;
+	rasterSettings.penWidth = settings->pen_width;
+	rasterSettings.useAntiAliasing = settings->anti_aliasing != 0;
+	rasterSettings.timeStep = settings->time_step;
+	rasterSettings.useTwoColors = settings->use_two_colors != 0;
+	rasterSettings.primaryColor = settings->primary_color;
+	rasterSettings.secondColor = settings->second_color;
+	rasterSettings.backgroundColor = settings->background_color;
+
+	try {
+		SoftwareRasterizer rasterizer(rasterSettings);
+		rasterizer.render(harmonograph->sampler, pixels, stride);
+		return hg_ok;
+	}
+	catch (const std::bad_alloc&) {
+		return hg_out_of_memory;
+	}
+}
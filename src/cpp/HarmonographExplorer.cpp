@@ -0,0 +1,221 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "HarmonographExplorer.h"
+#include "HarmonographSampler.h"
+#include "HarmonographSaver.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+static bool isBetterScore(const ExplorationScore& a, const ExplorationScore& b) {
+	if (a.total != b.total) return a.total > b.total;
+	return a.candidateIndex < b.candidateIndex;
+}
+
+HarmonographExplorer::HarmonographExplorer(Harmonograph* templateHarmonograph, ExplorationSettings settings) {
+	this->templateHarmonograph = templateHarmonograph;
+	this->settings = settings;
+}
+
+HarmonographExplorer::~HarmonographExplorer() {
+	for (Pendulum* p : templateHarmonograph->getPendulums()) {
+		delete p;
+	}
+	delete templateHarmonograph;
+}
+
+Harmonograph* HarmonographExplorer::createCandidate(long long candidateIndex) {
+	Harmonograph* candidate = new Harmonograph(templateHarmonograph);
+
+	CounterRandom random(settings.seed, candidateIndex);
+	candidate->update(random);
+
+	return candidate;
+}
+
+std::vector<ExplorationScore> HarmonographExplorer::explore() {
+	const int threadsCount = std::max(1u, std::thread::hardware_concurrency());
+	std::atomic<long long> nextCandidate(0);
+	std::vector<std::vector<ExplorationScore>> threadResults(threadsCount);
+
+	auto worker = [&](int threadIndex) {
+		std::vector<float> xs, ys;
+		std::vector<unsigned char> grid;
+		std::vector<ExplorationScore>& best = threadResults[threadIndex];
+
+		for (long long i = nextCandidate++; i < settings.candidatesCount; i = nextCandidate++) {
+			best.push_back(scoreCandidate(i, xs, ys, grid));
+			std::push_heap(best.begin(), best.end(), isBetterScore);
+
+			//heap front is the worst kept candidate
+			if (best.size() > settings.topCount) {
+				std::pop_heap(best.begin(), best.end(), isBetterScore);
+				best.pop_back();
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threadsCount; i++) {
+		workers.emplace_back(worker, i);
+	}
+	worker(0);
+	for (std::thread& t : workers) {
+		t.join();
+	}
+
+	std::vector<ExplorationScore> scores;
+	for (const std::vector<ExplorationScore>& result : threadResults) {
+		scores.insert(scores.end(), result.begin(), result.end());
+	}
+
+	std::sort(scores.begin(), scores.end(), isBetterScore);
+	if (scores.size() > settings.topCount) scores.resize(settings.topCount);
+
+	return scores;
+}
+
+bool HarmonographExplorer::writeTopCandidates(const std::vector<ExplorationScore>& scores) {
+	QDir outputDir(settings.outputDirPath);
+	if (!outputDir.mkpath(".")) return false;
+
+	HarmonographSaver saver;
+	QJsonArray candidatesArray;
+
+	for (int rank = 0; rank < scores.size(); rank++) {
+		const ExplorationScore& score = scores[rank];
+		const QString filename = QString("candidate_%1.json").arg(score.candidateIndex);
+
+		//saver takes ownership of the harmonograph
+		saver.saveParametersToFile(outputDir.filePath(filename), createCandidate(score.candidateIndex));
+
+		QJsonObject candidateObject;
+		candidateObject.insert("rank", rank + 1);
+		candidateObject.insert("candidate", score.candidateIndex);
+		candidateObject.insert("file", filename);
+		candidateObject.insert("coverage", score.coverage);
+		candidateObject.insert("symmetry", score.symmetry);
+		candidateObject.insert("edgeDensity", score.edgeDensity);
+		candidateObject.insert("score", score.total);
+		candidatesArray.append(candidateObject);
+	}
+
+	QJsonObject root;
+	root.insert("seed", QString::number(settings.seed));
+	root.insert("candidatesCount", settings.candidatesCount);
+	root.insert("candidates", candidatesArray);
+
+	QFile indexFile(outputDir.filePath("exploration.json"));
+	if (!indexFile.open(QIODevice::WriteOnly)) return false;
+
+	indexFile.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+	indexFile.close();
+	return true;
+}
+
+ExplorationScore HarmonographExplorer::scoreCandidate(long long candidateIndex, std::vector<float>& xs, std::vector<float>& ys, std::vector<unsigned char>& grid) {
+	Harmonograph* candidate = createCandidate(candidateIndex);
+
+	const int count = static_cast<int>(ceil(255 / settings.timeStep));
+	xs.resize(count);
+	ys.resize(count);
+
+	//the score is taken on a coarse grid, the 1e-3 tier is far below one of its cells
+	HarmonographSampler sampler(candidate);
+	sampler.setAccuracy(MathAccuracy::coarse);
+	sampler.sample(0, settings.timeStep, count, xs.data(), ys.data());
+
+	for (Pendulum* p : candidate->getPendulums()) {
+		delete p;
+	}
+	delete candidate;
+
+	rasterize(xs, ys, grid);
+
+	const int n = settings.resolution;
+	long long filled = 0, edges = 0, mirrored = 0;
+
+	for (int y = 0; y < n; y++) {
+		for (int x = 0; x < n; x++) {
+			if (!grid[y * n + x]) continue;
+			filled++;
+
+			//filled cell next to an empty one
+			if (x == 0 || y == 0 || x == n - 1 || y == n - 1 ||
+				!grid[y * n + x - 1] || !grid[y * n + x + 1] || !grid[(y - 1) * n + x] || !grid[(y + 1) * n + x]) {
+				edges++;
+			}
+
+			//point symmetry through the center covers both mirror axes of typical figures
+			if (grid[(n - 1 - y) * n + (n - 1 - x)]) mirrored++;
+		}
+	}
+
+	ExplorationScore score;
+	score.candidateIndex = candidateIndex;
+	score.coverage = static_cast<float>(filled) / (n * n);
+	score.symmetry = filled > 0 ? static_cast<float>(mirrored) / filled : 0;
+	score.edgeDensity = filled > 0 ? static_cast<float>(edges) / filled : 0;
+	score.total = settings.coverageWeight * score.coverage
+		+ settings.symmetryWeight * score.symmetry
+		+ settings.edgeDensityWeight * score.edgeDensity;
+
+	return score;
+}
+
+void HarmonographExplorer::rasterize(const std::vector<float>& xs, const std::vector<float>& ys, std::vector<unsigned char>& grid) {
+	const int n = settings.resolution;
+	grid.assign(n * n, 0);
+
+	float maxAbs = 0;
+	for (int i = 0; i < xs.size(); i++) {
+		maxAbs = std::max(maxAbs, std::max(std::abs(xs[i]), std::abs(ys[i])));
+	}
+	if (maxAbs <= 0) return;
+
+	const float scale = (n / 2.0f - 1) / maxAbs;
+	const float center = n / 2.0f;
+
+	for (int i = 1; i < xs.size(); i++) {
+		const float x0 = xs[i - 1] * scale + center, y0 = center - ys[i - 1] * scale;
+		const float x1 = xs[i] * scale + center, y1 = center - ys[i] * scale;
+
+		const int steps = std::max(1, static_cast<int>(std::max(std::abs(x1 - x0), std::abs(y1 - y0))));
+		for (int s = 0; s <= steps; s++) {
+			const int x = static_cast<int>(x0 + (x1 - x0) * s / steps);
+			const int y = static_cast<int>(y0 + (y1 - y0) * s / steps);
+			if (x >= 0 && y >= 0 && x < n && y < n) grid[y * n + x] = 1;
+		}
+	}
+}
+
+ExplorationTask::ExplorationTask(Harmonograph* templateHarmonograph, ExplorationSettings settings) {
+	explorer = new HarmonographExplorer(templateHarmonograph, settings);
+}
+
+ExplorationTask::~ExplorationTask() {
+	delete explorer;
+}
+
+void ExplorationTask::run() {
+	explorer->writeTopCandidates(explorer->explore());
+}
@@ -19,15 +19,38 @@
  */
 
 #include "HarmonographManager.h"
+#include <algorithm>
 
 HarmonographManager::HarmonographManager() {
     harmonograph = new Harmonograph(3);
     harmonographSaver = new HarmonographSaver();
+    createSettleTimer();
 }
 
 HarmonographManager::HarmonographManager(Harmonograph* harm) {
     this->harmonograph = harm;
     harmonographSaver = new HarmonographSaver();
+    createSettleTimer();
+}
+
+void HarmonographManager::createSettleTimer() {
+    settleTimer = new QTimer(this);
+    settleTimer->setSingleShot(true);
+    settleTimer->setInterval(250);
+    connect(settleTimer, SIGNAL(timeout()), this, SLOT(finishInteraction()));
+}
+
+void HarmonographManager::startInteraction() {
+    isTrajectoryTransient = true;
+    settleTimer->start();
+}
+
+void HarmonographManager::finishInteraction() {
+    settleTimer->stop();
+    if (!isTrajectoryTransient) return;
+
+    isTrajectoryTransient = false;
+    emit interactionFinished();
 }
 
 HarmonographManager::~HarmonographManager() {
@@ -36,6 +59,7 @@ HarmonographManager::~HarmonographManager() {
 }
 
 Harmonograph* HarmonographManager::getHarmCopy() {
+    AllocationSite site("getHarmCopy");
     return new Harmonograph(harmonograph);
 }
 
@@ -43,28 +67,120 @@ float HarmonographManager::getCoordinateByTime(Dimension dimension, float t) {
     return harmonograph->getCoordinateByTime(dimension, t);
 }
 
+float HarmonographManager::getCoordinateBound(Dimension dimension, float tStart, float tEnd) {
+    //before anything was sampled the closed-form amplitude is the best guess
+    const float bound = sampledBound[dimension == Dimension::x ? 0 : 1];
+    if (harmonograph->engine == HarmonographEngines::simulated && bound > 0) return bound;
+    return harmonograph->getCoordinateBound(dimension, tStart, tEnd);
+}
+
+void HarmonographManager::sampleTrajectory(float tStart, float tStep, int count, float* xs, float* ys) {
+    lastSampleStart = tStart;
+    lastSampleStep = tStep;
+    lastSampleCount = count;
+
+    const std::uint64_t key = TrajectoryCache::computeKey(harmonograph, tStart, tStep, count);
+    if (trajectoryCache.lookup(key, count, xs, ys)) {
+        if (isTrajectoryPersistent) trajectoryCache.persist(key);
+        isTrajectoryPersistent = false;
+    }
+    else {
+        //a transient trajectory lives for one frame of a drag, the 1e-3 tier is plenty for it
+        sampler.load(harmonograph);
+        sampler.setAccuracy(isTrajectoryTransient ? MathAccuracy::coarse : MathAccuracy::medium);
+        sampler.sample(tStart, tStep, count, xs, ys);
+
+        if (!isTrajectoryTransient) trajectoryCache.insert(key, count, xs, ys, isTrajectoryPersistent);
+        isTrajectoryPersistent = false;
+    }
+
+    if (harmonograph->engine == HarmonographEngines::simulated) {
+        sampledBound[0] = sampledBound[1] = 0;
+        for (int i = 0; i < count; i++) {
+            sampledBound[0] = std::max(sampledBound[0], std::abs(xs[i]));
+            sampledBound[1] = std::max(sampledBound[1], std::abs(ys[i]));
+        }
+    }
+}
+
+//deep zoom frames are never cached, every pan or zoom step gives a new viewport
+void HarmonographManager::sampleViewport(const Viewport& viewport, float maxTimeStep, ViewportSamples& samples) {
+    viewportSampler.load(harmonograph);
+    viewportSampler.sample(viewport, maxTimeStep, samples);
+}
+
+void HarmonographManager::setSamplingThreads(int threadsCount) {
+    sampler.setMaxThreads(threadsCount);
+}
+
+void HarmonographManager::cacheCurrentTrajectory(bool isPersistent) {
+    if (lastSampleCount == 0) return;
+
+    const std::uint64_t key = TrajectoryCache::computeKey(harmonograph, lastSampleStart, lastSampleStep, lastSampleCount);
+    if (trajectoryCache.contains(key)) {
+        if (isPersistent) trajectoryCache.persist(key);
+        return;
+    }
+
+    std::vector<float> xs(lastSampleCount), ys(lastSampleCount);
+    sampler.load(harmonograph);
+    sampler.setAccuracy(MathAccuracy::medium);
+    sampler.sample(lastSampleStart, lastSampleStep, lastSampleCount, xs.data(), ys.data());
+    trajectoryCache.insert(key, lastSampleCount, xs.data(), ys.data(), isPersistent);
+}
+
+void HarmonographManager::setTrajectoryCacheDir(QString dirPath) {
+    trajectoryCache.setDiskTier(dirPath);
+}
+
+TrajectoryCacheStatistics HarmonographManager::getTrajectoryCacheStatistics() {
+    return trajectoryCache.getStatistics();
+}
+
 void HarmonographManager::updateRandomValues() {
+    //makes undo of this state a cache hit even if it was reached by rotation
+    cacheCurrentTrajectory(false);
+    isTrajectoryTransient = false;
+
+    AllocationSite site("history");
     history.push_back(new Harmonograph(harmonograph));
     harmonograph->update();
     if (history.size() > 10) {
         history.pop_front();
     }
+    emit pendulumsChanged();
 }
 
 void HarmonographManager::changeXAxisRotation(float radians) {
+    startInteraction();
     harmonograph->rotateXAxis(radians);
+
+    const std::vector<Pendulum*>& pendulums = harmonograph->getPendulums();
+    for (int i = 0; i < pendulums.size(); i++) {
+        emit parameterChanged(i, Dimension::x, EquationParameter::phase, pendulums[i]->getEquationParameter(Dimension::x, EquationParameter::phase));
+    }
 }
 
 void HarmonographManager::rotateXY(float x, float y) {
+    startInteraction();
     harmonograph->rotateXY(x, y);
+
+    Pendulum* first = harmonograph->getPendulums().at(0);
+    emit parameterChanged(0, Dimension::x, EquationParameter::phase, first->getEquationParameter(Dimension::x, EquationParameter::phase));
+    emit parameterChanged(0, Dimension::y, EquationParameter::phase, first->getEquationParameter(Dimension::y, EquationParameter::phase));
 }
 
 void HarmonographManager::saveCurrentImage(ImageSettings* settings){
+    AllocationSite site("saveCurrentImage");
     Harmonograph* copyHarm = new Harmonograph(harmonograph);
 
     harmonographSaver->saveImage(copyHarm, settings);
 }
 void HarmonographManager::saveParametersToFile(QString filename) {
+    //loading this preset later, even after restart, is a disk tier hit
+    cacheCurrentTrajectory(true);
+
+    AllocationSite site("saveParametersToFile");
     Harmonograph* copyHarmonograph = new Harmonograph(harmonograph);
     harmonographSaver->saveParametersToFile(filename, copyHarmonograph);
 }
@@ -74,6 +190,9 @@ void HarmonographManager::loadParametersFromFile(QString filename) {
     if (loadedHarmonograph != nullptr) {
         delete harmonograph;
         harmonograph = loadedHarmonograph;
+        isTrajectoryTransient = false;
+        isTrajectoryPersistent = true;
+        emit pendulumsChanged();
     }
 }
 
@@ -85,8 +204,38 @@ int HarmonographManager::getHistorySize() {
     return history.size();
 }
 
-std::vector<Pendulum*> HarmonographManager::getPendulumsCopy() {
-    return harmonograph->getPundlumsCopy();
+int HarmonographManager::getNumOfPendulums() {
+    return harmonograph->getNumOfPendulums();
+}
+
+float HarmonographManager::getEquationParameter(int pendulumNum, Dimension dimension, EquationParameter parameter) {
+    return harmonograph->getPendulums().at(pendulumNum)->getEquationParameter(dimension, parameter);
+}
+
+void HarmonographManager::setEquationParameter(int pendulumNum, Dimension dimension, EquationParameter parameter, float value) {
+    startInteraction();
+    Pendulum* pendulum = harmonograph->getPendulums().at(pendulumNum);
+    pendulum->setEquationParameter(dimension, parameter, value);
+    emit parameterChanged(pendulumNum, dimension, parameter, value);
+
+    /*frequency is always base frequency plus noise, keep both in sync*/
+    if (parameter == EquationParameter::frequency) {
+        const float noise = value - getBaseFrequency(pendulumNum);
+        pendulum->setEquationParameter(dimension, EquationParameter::frequencyNoise, noise);
+        emit parameterChanged(pendulumNum, dimension, EquationParameter::frequencyNoise, noise);
+    }
+    else if (parameter == EquationParameter::frequencyNoise) {
+        const float frequency = getBaseFrequency(pendulumNum) + value;
+        pendulum->setEquationParameter(dimension, EquationParameter::frequency, frequency);
+        emit parameterChanged(pendulumNum, dimension, EquationParameter::frequency, frequency);
+    }
+}
+
+float HarmonographManager::getBaseFrequency(int pendulumNum) {
+    if (!harmonograph->isStar) return harmonograph->frequencyPoint;
+
+    return harmonograph->frequencyPoint / (harmonograph->firstRatioValue + harmonograph->secondRatioValue)
+        * (pendulumNum == 0 ? harmonograph->firstRatioValue : harmonograph->secondRatioValue);
 }
 
 void HarmonographManager::setSecondColor(QColor color) {
@@ -100,12 +249,14 @@ void HarmonographManager::setBackgroundColor(QColor color) {
 void HarmonographManager::setRatioStateEnabled(bool isEnabled) {
     harmonograph->isStar = isEnabled;
     harmonograph->update();
+    emit pendulumsChanged();
 }
 
 void HarmonographManager::setFirstRatioValue(int value) {
     if (value > 0) {
         harmonograph->firstRatioValue = value;
         harmonograph->update();
+        emit pendulumsChanged();
     }
 }
 
@@ -113,12 +264,14 @@ void HarmonographManager::setSecondRatioValue(int value) {
     if (value > 0) {
         harmonograph->secondRatioValue = value;
         harmonograph->update();
+        emit pendulumsChanged();
     }
 }
 
 void HarmonographManager::setIsCircleEnabled(bool isEnabled) {
     harmonograph->isCircle = isEnabled;
     harmonograph->update();
+    emit pendulumsChanged();
 }
 
 void HarmonographManager::setPenWidth(int width) {
@@ -146,23 +299,49 @@ void HarmonographManager::setUseTwoColors(bool isEnabled) {
 }
 
 void HarmonographManager::setFrequencyPoint(float freqPt) {
-    if (freqPt > 0) harmonograph->changeFrequencyPointNoUpdate(freqPt);
-
+    if (freqPt > 0) {
+        harmonograph->changeFrequencyPointNoUpdate(freqPt);
+
+        const std::vector<Pendulum*>& pendulums = harmonograph->getPendulums();
+        for (int i = 0; i < pendulums.size(); i++) {
+            emit parameterChanged(i, Dimension::x, EquationParameter::frequency, pendulums[i]->getEquationParameter(Dimension::x, EquationParameter::frequency));
+            emit parameterChanged(i, Dimension::y, EquationParameter::frequency, pendulums[i]->getEquationParameter(Dimension::y, EquationParameter::frequency));
+        }
+    }
 }
 
 void HarmonographManager::setNumOfPendulums(int newNum) {
     if (newNum > 0) harmonograph->setNumOfPendulums(newNum);
     harmonograph->update();
+    emit pendulumsChanged();
+}
+
+HarmonographEngines HarmonographManager::getEngine() {
+    return harmonograph->engine;
+}
+
+SimulationSettings HarmonographManager::getSimulationSettings() {
+    return harmonograph->simulation;
+}
+
+void HarmonographManager::setSimulation(HarmonographEngines engine, SimulationSettings settings) {
+    harmonograph->engine = engine;
+    harmonograph->simulation = settings;
+    isTrajectoryTransient = false;
+    emit pendulumsChanged();
 }
 
 void HarmonographManager::undoUpdate() {
     if (history.size() > 0) {
+        AllocationSite site("undoUpdate");
         Harmonograph* undoHarm = new Harmonograph(history.back());
         history.pop_back();
 
         delete harmonograph;
 
         harmonograph = undoHarm;
+        isTrajectoryTransient = false;
+        emit pendulumsChanged();
     }
 }
 
@@ -171,6 +350,7 @@ DrawParameters HarmonographManager::getDrawParameters() {
 }
 
 void HarmonographManager::changeParameter(int pendulumNum, EquationParameter parameter, Dimension dimension, int value) {
+    startInteraction();
     float realValue = 0;
     switch (parameter) {
     case EquationParameter::amplitude:
@@ -179,16 +359,11 @@ void HarmonographManager::changeParameter(int pendulumNum, EquationParameter par
         realValue = (maxDampingValue / sliderMaxValue) * value;
         break;
     case EquationParameter::frequency:
-        if (!harmonograph->isStar)
-            realValue = 
-            (maxFreqModuleValue / (sliderMaxValue / 2)) * (value - (sliderMaxValue / 2)) + harmonograph->frequencyPoint;
-        else
-            realValue =
-            (maxFreqModuleValue / (sliderMaxValue / 2)) * (value - (sliderMaxValue / 2)) +
-            (harmonograph->frequencyPoint / (harmonograph->firstRatioValue + harmonograph->secondRatioValue)
-                * (pendulumNum == 0 ? harmonograph->firstRatioValue : harmonograph->secondRatioValue));
+        realValue = (maxFreqModuleValue / (sliderMaxValue / 2)) * (value - (sliderMaxValue / 2)) + getBaseFrequency(pendulumNum);
 
         harmonograph->getPendulums().at(pendulumNum)->setEquationParameter(dimension, EquationParameter::frequencyNoise, (maxFreqModuleValue / (sliderMaxValue / 2)) * (value - (sliderMaxValue / 2)));
+        emit parameterChanged(pendulumNum, dimension, EquationParameter::frequencyNoise,
+            harmonograph->getPendulums().at(pendulumNum)->getEquationParameter(dimension, EquationParameter::frequencyNoise));
         break;
     case EquationParameter::phase:
         realValue = (2 * pi / sliderMaxValue) * value;
@@ -198,4 +373,5 @@ void HarmonographManager::changeParameter(int pendulumNum, EquationParameter par
     }
 
     harmonograph->getPendulums().at(pendulumNum)->setEquationParameter(dimension, parameter, realValue);
+    emit parameterChanged(pendulumNum, dimension, parameter, realValue);
 }
@@ -19,6 +19,10 @@
  */
 
 #include "HarmonographOpenGLWidget.h"
+#include "Tracer.h"
+#include <QElapsedTimer>
+#include <QWindow>
+#include <algorithm>
 
 HarmonographOpenGLWidget::HarmonographOpenGLWidget(QWidget* parent, HarmonographManager* manager){
 	this->manager = manager;
@@ -32,9 +36,29 @@ void HarmonographOpenGLWidget::wheelEvent(QWheelEvent* event){
 
 	float yDegrees = numDegrees.y()/2000.0;
 
-	const float temp = manager->getDrawParameters().zoom + yDegrees;
-	if (temp > minZoom && temp < maxZoom) {
-		manager->setZoom(temp);
+	const float zoom = manager->getDrawParameters().zoom;
+	const bool isDeepZoomAvailable = manager->getEngine() == HarmonographEngines::closedForm && cometTrail == nullptr;
+	if (isDeepZoomAvailable && (deepZoom > 1 || (yDegrees > 0 && zoom + yDegrees >= maxZoom))) {
+		//the curve point under the cursor stays under it
+		const double ndcX = (2.0 * event->position().x() / width() - 1) * aspect;
+		const double ndcY = 1 - 2.0 * event->position().y() / height();
+		const double pointX = centerX + ndcX / (zoom * deepZoom);
+		const double pointY = centerY + ndcY / (zoom * deepZoom);
+
+		deepZoom = std::min(maxDeepZoom, std::max(1.0, deepZoom * pow(deepZoomPerNotch, numDegrees.y() / 15.0)));
+		if (deepZoom == 1) {
+			centerX = centerY = 0;
+		}
+		else {
+			centerX = pointX - ndcX / (zoom * deepZoom);
+			centerY = pointY - ndcY / (zoom * deepZoom);
+		}
+	}
+	else {
+		const float temp = zoom + yDegrees;
+		if (temp > minZoom && temp < maxZoom) {
+			manager->setZoom(temp);
+		}
 	}
 	this->update();
 }
@@ -50,7 +74,13 @@ void HarmonographOpenGLWidget::mouseMoveEvent(QMouseEvent* event){
 		previousX = event->globalX();
 		previousY = event->globalY();
 
-		manager->rotateXY(dfX, dfY);
+		if (isDeepZoomed()) {
+			centerX += dx * getPixelSize();
+			centerY -= dy * getPixelSize();
+		}
+		else {
+			manager->rotateXY(dfX, dfY);
+		}
 	}
 	this->update();
 }
@@ -66,6 +96,7 @@ void HarmonographOpenGLWidget::mousePressEvent(QMouseEvent* event){
 void HarmonographOpenGLWidget::mouseReleaseEvent(QMouseEvent* event){
 	isMousePressed = false;
 	this->setCursor(Qt::OpenHandCursor);
+	manager->finishInteraction();
 	this->update();
 }
 
@@ -76,72 +107,179 @@ void HarmonographOpenGLWidget::initializeGL() {
 	glLineWidth(manager->getDrawParameters().penWidth);
 	glPointSize(manager->getDrawParameters().penWidth);
 	glEnable(GL_POINT_SMOOTH);
+
+	renderer.initialize();
+	trailRenderer.initialize();
 }
 
 void HarmonographOpenGLWidget::resizeGL(int w, int h){
 	glViewport(0, 0, w, h);
-	glMatrixMode(GL_PROJECTION);
-	float aspect = (float)w / (float)h;
-	glLoadIdentity();
-	glOrtho(-aspect, aspect, -1, 1, -1, 1);
-
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	aspect = (float)w / (float)h;
+	viewHeight = std::max(1, h);
 }
 
 void HarmonographOpenGLWidget::paintGL(){
+	TraceSpan paintSpan("paintGL", "paint");
+	QElapsedTimer frameTimer;
+	frameTimer.start();
 	DrawParameters parameters = manager->getDrawParameters();
 
 	glClearColor(parameters.backgroundColor.redF(), parameters.backgroundColor.greenF(), parameters.backgroundColor.blueF(), 1);
 	glClear(GL_COLOR_BUFFER_BIT);
 
-	glLineWidth(parameters.penWidth);
-	glPointSize(parameters.penWidth);
-
-	switch (parameters.drawMode) {
-		case DrawModes::linesMode:
-			glBegin(GL_LINE_STRIP);
-			break;
-		case DrawModes::pointsMode:
-			glBegin(GL_POINTS);
-			break;
-		default:
-			glBegin(GL_LINE_STRIP);
-			break;
+	if (cometTrail != nullptr) {
+		paintTrail(parameters);
+		return;
 	}
 
-	float xCurrent = 0;
-	float yCurrent = 0;
-
-	if (parameters.useTwoColors) {
-		int stepCount = (int)(255 / parameters.timeStep) + 10;
-		float stepR = ((float)(parameters.secondColor.redF() - parameters.primaryColor.redF()) / stepCount);
-		float stepG = ((float)(parameters.secondColor.greenF() - parameters.primaryColor.greenF()) / stepCount);
-		float stepB = ((float)(parameters.secondColor.blueF() - parameters.primaryColor.blueF()) / stepCount);
-		
-		int i = 1;
-		
-		for (float t = 0; t < 255; t += parameters.timeStep) {
-			glColor3f(parameters.primaryColor.redF() + stepR * i, parameters.primaryColor.greenF() + stepG * i, parameters.primaryColor.blueF() + stepB * i);
-
-			xCurrent = (manager->getCoordinateByTime(Dimension::x, t) * parameters.zoom);
-			yCurrent = (manager->getCoordinateByTime(Dimension::y, t) * parameters.zoom);
-
-			glVertex3f(xCurrent, yCurrent, 0);
-			i++;
-		}
-		
-	} else {
-		glColor3f(parameters.primaryColor.redF(), parameters.primaryColor.greenF(), parameters.primaryColor.blueF());
-		for (float t = 0; t < 255; t += parameters.timeStep) {
-			xCurrent = (manager->getCoordinateByTime(Dimension::x, t) * parameters.zoom);
-			yCurrent = (manager->getCoordinateByTime(Dimension::y, t) * parameters.zoom);
+	//a frame prepared by the render scheduler is only uploaded, any other repaint samples here
+	if (!isFramePrepared) {
+		prepareFrame();
+		prepareNanoseconds = 0;
+	}
+	isFramePrepared = false;
 
-			glVertex3f(xCurrent, yCurrent, 0);
-		}
+	if (isQualityAdaptive && !qualityController.isAntiAliasingAllowed()) glDisable(GL_MULTISAMPLE);
+	else glEnable(GL_MULTISAMPLE);
+
+	TraceSpan uploadSpan("upload", "paint");
+	if (isDeepFrame) {
+		renderer.upload(viewportSamples.xs.data(), viewportSamples.ys.data(), static_cast<int>(viewportSamples.xs.size()), xBound, yBound);
+	}
+	else {
+		renderer.upload(xBuffer.data(), yBuffer.data(), static_cast<int>(xBuffer.size()), xBound, yBound);
+	}
+	uploadSpan.finish();
+
+	TraceSpan drawSpan("draw", "paint");
+	QMatrix4x4 matrix;
+	matrix.ortho(-aspect, aspect, -1, 1, -1, 1);
+	const int colorStepCount = static_cast<int>(ceil(255 / frameTimeStep)) + 10;
+	if (isDeepFrame) {
+		//viewport samples are relative to the center, so only the scale is left
+		matrix.scale(parameters.zoom * deepZoom);
+		renderer.drawRanges(matrix, parameters, colorStepCount, ranges, colorScale);
+	}
+	else {
+		matrix.scale(parameters.zoom);
+		renderer.draw(matrix, parameters, colorStepCount);
+	}
+	drawSpan.finish();
+
+	//only the CPU side of drawing is measured, a glFinish here would stall every frame
+	if (isQualityAdaptive) qualityController.addFrameCost((prepareNanoseconds + frameTimer.nsecsElapsed()) / 1e6);
+	prepareNanoseconds = 0;
+
+	StartupTrace::firstFrame();
+}
+
+//needs no GL context, so the render scheduler calls it on a worker thread before update()
+void HarmonographOpenGLWidget::prepareFrame() {
+	TraceSpan sampleSpan("sample", "paint");
+	QElapsedTimer prepareTimer;
+	prepareTimer.start();
+	float timeStep = manager->getDrawParameters().timeStep;
+	if (isQualityAdaptive) timeStep *= qualityController.getTimeStepScale();
+	frameTimeStep = timeStep;
+	isDeepFrame = isDeepZoomed();
+
+	if (isDeepFrame) {
+		prepareViewportFrame();
 	}
+	else {
+		const int count = static_cast<int>(ceil(255 / timeStep));
+		xBuffer.resize(count);
+		yBuffer.resize(count);
+		manager->sampleTrajectory(0, timeStep, count, xBuffer.data(), yBuffer.data());
+
+		xBound = manager->getCoordinateBound(Dimension::x, 0, 255);
+		yBound = manager->getCoordinateBound(Dimension::y, 0, 255);
+	}
+	isFramePrepared = true;
+	prepareNanoseconds = prepareTimer.nsecsElapsed();
+}
+
+void HarmonographOpenGLWidget::setCometTrail(CometTrail* trail) {
+	cometTrail = trail;
+	if (trail != nullptr) trail->isRestarted = true;
+}
+
+//only the samples computed since the last frame are uploaded
+void HarmonographOpenGLWidget::paintTrail(const DrawParameters& parameters) {
+	TraceSpan uploadSpan("upload", "paint");
+	if (cometTrail->isRestarted) {
+		trailRenderer.reset(cometTrail->getCapacity(),
+			manager->getCoordinateBound(Dimension::x, 0, 255), manager->getCoordinateBound(Dimension::y, 0, 255));
+	}
+	trailRenderer.append(cometTrail->pendingXs.data(), cometTrail->pendingYs.data(), static_cast<int>(cometTrail->pendingXs.size()));
+	cometTrail->clearPending();
+	uploadSpan.finish();
+
+	TraceSpan drawSpan("draw", "paint");
+	QMatrix4x4 matrix;
+	matrix.ortho(-aspect, aspect, -1, 1, -1, 1);
+	matrix.scale(parameters.zoom);
+	trailRenderer.draw(matrix, parameters);
+}
+
+void HarmonographOpenGLWidget::prepareViewportFrame() {
+	const double zoom = manager->getDrawParameters().zoom * deepZoom;
+
+	Viewport viewport;
+	viewport.centerX = centerX;
+	viewport.centerY = centerY;
+	viewport.halfWidth = aspect / zoom;
+	viewport.halfHeight = 1 / zoom;
+	viewport.pixelSize = getPixelSize();
+	manager->sampleViewport(viewport, frameTimeStep, viewportSamples);
+
+	//the gradient follows time, a run starting at tStart continues the color of the full curve there
+	colorScale = viewportSamples.timeStep / frameTimeStep;
+	ranges.clear();
+	for (const ViewportRun& run : viewportSamples.runs) {
+		DrawRange range;
+		range.first = run.first;
+		range.count = run.count;
+		range.colorOffset = run.tStart / frameTimeStep + 1 - run.first * colorScale;
+		ranges.push_back(range);
+	}
+
+	xBound = viewportSamples.xBound;
+	yBound = viewportSamples.yBound;
+}
+
+double HarmonographOpenGLWidget::getPixelSize() {
+	return 2 / (manager->getDrawParameters().zoom * deepZoom * viewHeight);
+}
+
+bool HarmonographOpenGLWidget::isDeepZoomed() {
+	return deepZoom > 1 && manager->getEngine() == HarmonographEngines::closedForm;
+}
+
+//still images are always drawn at full quality, so the controller starts over every time
+void HarmonographOpenGLWidget::setAdaptiveQuality(bool isEnabled, int targetFps) {
+	isQualityAdaptive = isEnabled;
+	qualityController.setTargetFps(targetFps);
+	qualityController.reset();
+}
+
+//false when the view is hidden, minimized, fully covered or on another virtual desktop,
+//as far as the window system reports it
+bool HarmonographOpenGLWidget::isOnScreen() {
+	QWidget* topLevel = window();
+	if (!isVisible() || topLevel->isMinimized()) return false;
+	return topLevel->windowHandle() != nullptr && topLevel->windowHandle()->isExposed();
+}
+
+QString HarmonographOpenGLWidget::getVertexMemoryReport() {
+	const int count = static_cast<int>(ceil(255 / manager->getDrawParameters().timeStep));
+	const long long before = (long long)count * VertexPacker::unpackedVertexBytes;
+	const long long after = (long long)count * VertexPacker::packedVertexBytes;
 
-	glEnd();
+	return QString("%1 vertices: %2 B/vertex, %3 KB per frame (was %4 B/vertex, %5 KB)")
+		.arg(count)
+		.arg(VertexPacker::packedVertexBytes).arg(after / 1024)
+		.arg(VertexPacker::unpackedVertexBytes).arg(before / 1024);
 }
 
 void HarmonographOpenGLWidget::setEnableAA(bool isEnabled) {
@@ -0,0 +1,228 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "HarmonographSampler.h"
+#include "FastMath.h"
+#include <algorithm>
+#include <thread>
+
+template<MathAccuracy accuracy>
+static void computeAnchorsWith(int n, double t, const double* dumping, const double* frequency, const double* phase, double* re, double* im) {
+	for (int k = 0; k < n; k++) {
+		const float envelope = FastMath::exp<accuracy>(-dumping[k] * t);
+		float s, c;
+		FastMath::sinCos<accuracy>(frequency[k] * t + phase[k], s, c);
+
+		re[k] = envelope * c;
+		im[k] = envelope * s;
+	}
+}
+
+HarmonographSampler::HarmonographSampler(Harmonograph* harmonograph) {
+	load(harmonograph);
+}
+
+void HarmonographSampler::load(Harmonograph* harmonograph) {
+	const std::vector<Pendulum*>& pendulums = harmonograph->getPendulums();
+	numOfPendulums = pendulums.size();
+
+	isSimulated = harmonograph->engine == HarmonographEngines::simulated;
+	if (isSimulated) simulator.load(harmonograph);
+
+	xDumping.resize(numOfPendulums);
+	xFrequency.resize(numOfPendulums);
+	xPhase.resize(numOfPendulums);
+	yDumping.resize(numOfPendulums);
+	yFrequency.resize(numOfPendulums);
+	yPhase.resize(numOfPendulums);
+
+	for (int k = 0; k < numOfPendulums; k++) {
+		Pendulum* p = pendulums[k];
+
+		xDumping[k] = p->getEquationParameter(Dimension::x, EquationParameter::dumping);
+		xFrequency[k] = p->getEquationParameter(Dimension::x, EquationParameter::frequency);
+		xPhase[k] = p->getEquationParameter(Dimension::x, EquationParameter::phase);
+
+		yDumping[k] = p->getEquationParameter(Dimension::y, EquationParameter::dumping);
+		yFrequency[k] = p->getEquationParameter(Dimension::y, EquationParameter::frequency);
+		yPhase[k] = p->getEquationParameter(Dimension::y, EquationParameter::phase);
+	}
+}
+
+void HarmonographSampler::sample(double tStart, double tStep, int count, float* xs, float* ys) const {
+	if (count <= 0) return;
+
+	if (isSimulated) {
+		simulator.sample(tStart, tStep, count, xs, ys);
+		return;
+	}
+
+	const long long work = static_cast<long long>(count) * std::max(numOfPendulums, 1);
+	long long hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	if (maxThreads > 0) hardwareThreads = std::min<long long>(hardwareThreads, maxThreads);
+	const int threadsCount = static_cast<int>(std::min(hardwareThreads, work / minWorkPerThread));
+
+	if (threadsCount <= 1) {
+		sampleRange(tStart, tStep, count, xs, ys);
+		return;
+	}
+
+	const int chunk = (count + threadsCount - 1) / threadsCount;
+	std::vector<std::thread> workers;
+
+	for (int first = chunk; first < count; first += chunk) {
+		const int chunkCount = std::min(chunk, count - first);
+		workers.emplace_back(&HarmonographSampler::sampleRange, this,
+			tStart + tStep * first, tStep, chunkCount, xs + first, ys + first);
+	}
+
+	sampleRange(tStart, tStep, std::min(chunk, count), xs, ys);
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+void HarmonographSampler::computeAnchors(int n, double t, const double* dumping, const double* frequency, const double* phase, double* re, double* im) const {
+	switch (accuracy) {
+	case MathAccuracy::coarse: computeAnchorsWith<MathAccuracy::coarse>(n, t, dumping, frequency, phase, re, im); break;
+	case MathAccuracy::medium: computeAnchorsWith<MathAccuracy::medium>(n, t, dumping, frequency, phase, re, im); break;
+	default: computeAnchorsWith<MathAccuracy::precise>(n, t, dumping, frequency, phase, re, im); break;
+	}
+}
+
+template<int N>
+void HarmonographSampler::sampleRangeFixed(double tStart, double tStep, int count, float* xs, float* ys) const {
+	//same recurrence as sampleRangeGeneric, with the state on the stack and every pendulum loop
+	//of constant length so the compiler unrolls it completely
+	double xRe[N], xIm[N], yRe[N], yIm[N];
+	double xRotRe[N], xRotIm[N], yRotRe[N], yRotIm[N];
+
+	for (int k = 0; k < N; k++) {
+		const double xDecay = exp(-xDumping[k] * tStep);
+		xRotRe[k] = xDecay * cos(xFrequency[k] * tStep);
+		xRotIm[k] = xDecay * sin(xFrequency[k] * tStep);
+
+		const double yDecay = exp(-yDumping[k] * tStep);
+		yRotRe[k] = yDecay * cos(yFrequency[k] * tStep);
+		yRotIm[k] = yDecay * sin(yFrequency[k] * tStep);
+	}
+
+	for (int blockStart = 0; blockStart < count; blockStart += anchorInterval) {
+		const double t = tStart + tStep * blockStart;
+
+		computeAnchors(N, t, xDumping.data(), xFrequency.data(), xPhase.data(), xRe, xIm);
+		computeAnchors(N, t, yDumping.data(), yFrequency.data(), yPhase.data(), yRe, yIm);
+
+		const int blockEnd = std::min(count, blockStart + anchorInterval);
+
+		for (int i = blockStart; i < blockEnd; i++) {
+			double x = 0, y = 0;
+
+			for (int k = 0; k < N; k++) {
+				x += xRe[k];
+				y += yIm[k];
+
+				const double xNextRe = xRe[k] * xRotRe[k] - xIm[k] * xRotIm[k];
+				xIm[k] = xRe[k] * xRotIm[k] + xIm[k] * xRotRe[k];
+				xRe[k] = xNextRe;
+
+				const double yNextRe = yRe[k] * yRotRe[k] - yIm[k] * yRotIm[k];
+				yIm[k] = yRe[k] * yRotIm[k] + yIm[k] * yRotRe[k];
+				yRe[k] = yNextRe;
+			}
+
+			xs[i] = x - xOrigin;
+			ys[i] = y - yOrigin;
+		}
+	}
+}
+
+void HarmonographSampler::sampleRange(double tStart, double tStep, int count, float* xs, float* ys) const {
+	switch (numOfPendulums) {
+	case 1: sampleRangeFixed<1>(tStart, tStep, count, xs, ys); break;
+	case 2: sampleRangeFixed<2>(tStart, tStep, count, xs, ys); break;
+	case 3: sampleRangeFixed<3>(tStart, tStep, count, xs, ys); break;
+	case 4: sampleRangeFixed<4>(tStart, tStep, count, xs, ys); break;
+	case 5: sampleRangeFixed<5>(tStart, tStep, count, xs, ys); break;
+	case 6: sampleRangeFixed<6>(tStart, tStep, count, xs, ys); break;
+	case 7: sampleRangeFixed<7>(tStart, tStep, count, xs, ys); break;
+	case 8: sampleRangeFixed<8>(tStart, tStep, count, xs, ys); break;
+	default: sampleRangeGeneric(tStart, tStep, count, xs, ys); break;
+	}
+}
+
+void HarmonographSampler::sampleRangeGeneric(double tStart, double tStep, int count, float* xs, float* ys) const {
+	const int n = numOfPendulums;
+
+	thread_local std::vector<double> state;
+	state.resize(n * 8);
+
+	double* xRe = state.data();
+	double* xIm = xRe + n;
+	double* yRe = xIm + n;
+	double* yIm = yRe + n;
+	double* xRotRe = yIm + n;
+	double* xRotIm = xRotRe + n;
+	double* yRotRe = xRotIm + n;
+	double* yRotIm = yRotRe + n;
+
+	for (int k = 0; k < n; k++) {
+		const double xDecay = exp(-xDumping[k] * tStep);
+		xRotRe[k] = xDecay * cos(xFrequency[k] * tStep);
+		xRotIm[k] = xDecay * sin(xFrequency[k] * tStep);
+
+		const double yDecay = exp(-yDumping[k] * tStep);
+		yRotRe[k] = yDecay * cos(yFrequency[k] * tStep);
+		yRotIm[k] = yDecay * sin(yFrequency[k] * tStep);
+	}
+
+	for (int blockStart = 0; blockStart < count; blockStart += anchorInterval) {
+		const double t = tStart + tStep * blockStart;
+
+		computeAnchors(n, t, xDumping.data(), xFrequency.data(), xPhase.data(), xRe, xIm);
+		computeAnchors(n, t, yDumping.data(), yFrequency.data(), yPhase.data(), yRe, yIm);
+
+		const int blockEnd = std::min(count, blockStart + anchorInterval);
+
+		for (int i = blockStart; i < blockEnd; i++) {
+			double x = 0, y = 0;
+
+			//x is the cosine (real) part, y is the sine (imaginary) part, as in Pendulum::getCoordinateByTime
+#pragma omp simd reduction(+:x, y)
+			for (int k = 0; k < n; k++) {
+				x += xRe[k];
+				y += yIm[k];
+
+				const double xNextRe = xRe[k] * xRotRe[k] - xIm[k] * xRotIm[k];
+				xIm[k] = xRe[k] * xRotIm[k] + xIm[k] * xRotRe[k];
+				xRe[k] = xNextRe;
+
+				const double yNextRe = yRe[k] * yRotRe[k] - yIm[k] * yRotIm[k];
+				yIm[k] = yRe[k] * yRotIm[k] + yIm[k] * yRotRe[k];
+				yRe[k] = yNextRe;
+			}
+
+			xs[i] = x - xOrigin;
+			ys[i] = y - yOrigin;
+		}
+	}
+}
@@ -20,10 +20,21 @@
 
 #pragma once
 #include "HarmonographSaver.h"
+#include "HarmonographSampler.h"
+#include "SoftwareRasterizer.h"
+#include "ExportCanvas.h"
+#include "ImageEncoder.h"
+#include "BezierFitter.h"
+#include "GpuImageExporter.h"
+#include "Tracer.h"
+#include "ExportCache.h"
+#include <thread>
 
 class SaveImageTask : public QRunnable {
 public:
 	QString filename;
+	QByteArray digest;
+	bool isCached = true;
 	Harmonograph* harmonograph;
 	DrawParameters parameters;
 	QImage* imageToSave;
@@ -31,6 +42,8 @@ public:
 	int width = 1280;
 	int height = 720;
 	float borderPercentage = 0.03;
+	ImageEncoders encoder = ImageEncoders::parallelPng;
+	int compressionLevel = 6;
 	
 	SaveImageTask(Harmonograph* harmonograph, ImageSettings* settings) {
 		this->filename = settings->filename;
@@ -39,97 +52,317 @@ public:
 		this->width = settings->saveWidth;
 		this->height = settings->saveHeight;
 		this->borderPercentage = settings->borderPercentage/100.0;
+		this->encoder = settings->encoder;
+		this->compressionLevel = settings->compressionLevel;
 
 		imageToSave = new QImage(width, height, QImage::Format_ARGB32);
+		AllocationTracker::track(imageToSave, "QImage", imageToSave->sizeInBytes());
 		delete settings;
 	}
 	
 	void run() override {
-		int const maxT = 255;
-		float const tStep = 1e-04;
-		QPainter* savePainter = new QPainter(imageToSave);
-		QPen savePen;
-		savePen.setCapStyle(Qt::RoundCap);
+		TraceSpan runSpan("SaveImageTask::run", "export");
+		int const samplesChunkSize = 1 << 16;
 
-		if (parameters.useAntiAliasing) savePainter->setRenderHint(QPainter::Antialiasing, true);
-		savePen.setColor(Qt::black);
-		savePen.setWidth(parameters.penWidth);
-		savePainter->setPen(savePen);
+		HarmonographSampler sampler(harmonograph);
+		std::vector<float> xs(samplesChunkSize), ys(samplesChunkSize);
 
-		savePainter->fillRect(0, 0, width, height, parameters.backgroundColor);
+		TraceSpan boundsSpan("bounds pass", "export");
+		const int saveZoom = SoftwareRasterizer::computeScale(sampler, width, height, borderPercentage);
+		boundsSpan.finish();
 
-		float widthAdd = width / 2;
-		float heightAdd = height / 2;
+		TraceSpan drawingSpan("drawing", "export");
+		ExportCanvas canvas(imageToSave, parameters, saveZoom);
+		const float tStep = canvas.getTimeStep();
+		const int samplesCount = ExportCanvas::getSamplesCount(parameters);
 
-		int saveZoom = (int)((parameters.zoom * 500) / ((1280 * 1.0) / width));
+		for (int first = 0; first < samplesCount; first += samplesChunkSize) {
+			const int count = std::min(samplesChunkSize, samplesCount - first);
+			sampler.sample(first * (double)tStep, tStep, count, xs.data(), ys.data());
+			canvas.drawSamples(xs.data(), ys.data(), first, count);
+		}
+		canvas.finish();
+		drawingSpan.finish();
 
-		float stepR = 0, stepG = 0, stepB = 0;
+		TraceSpan encodeSpan("encode", "export");
+		const bool isWritten = ImageEncoder::save(*imageToSave, filename, encoder, compressionLevel);
+		encodeSpan.finish();
+		ExportCache::instance().complete(digest, filename, isWritten, isCached);
 
-		if (parameters.useTwoColors) {
-			int stepCount = 0;
-			if (parameters.drawMode == DrawModes::linesMode) stepCount = (int)(maxT / tStep) + 10;
-			else stepCount = (int)(maxT / parameters.timeStep) + 10;
+		AllocationTracker::untrack(imageToSave);
+		delete imageToSave;
+		delete harmonograph;
+	}
+};
 
-			stepR = ((float)(parameters.secondColor.red() - parameters.primaryColor.red()) / stepCount);
-			stepG = ((float)(parameters.secondColor.green() - parameters.primaryColor.green()) / stepCount);
-			stepB = ((float)(parameters.secondColor.blue() - parameters.primaryColor.blue()) / stepCount);
-		}
+/*
+ * Exports one harmonograph at several sizes. The trajectory is sampled once and the extent is
+ * measured once; every target then draws the shared samples into its own image and encodes
+ * it on its own thread, so the job takes about as long as its largest image alone.
+ */
+class SaveImageSetTask : public QRunnable {
+public:
+	Harmonograph* harmonograph;
+	DrawParameters parameters;
+	std::vector<ExportTarget> targets;
+	std::vector<QByteArray> digests;
+	ImageEncoders encoder = ImageEncoders::parallelPng;
+	int compressionLevel = 6;
 
-		
-		float maxX = 0, maxY = 0, xZoom = 0, yZoom = 0;
+	SaveImageSetTask(Harmonograph* harmonograph, ImageSettings* settings, const std::vector<ExportTarget>& targets, const std::vector<QByteArray>& digests) {
+		this->harmonograph = harmonograph;
+		this->parameters = settings->parameters;
+		this->targets = targets;
+		this->digests = digests;
+		this->encoder = settings->encoder;
+		this->compressionLevel = settings->compressionLevel;
 
-		for (float t = 0; t < maxT; t += 1e-02) {
-			float x = abs(harmonograph->getCoordinateByTime(Dimension::x, t));
-			float y = abs(harmonograph->getCoordinateByTime(Dimension::y, t));
-			if (x > maxX) maxX = x;
-			if (y > maxY) maxY = y;
+		delete settings;
+	}
+
+	void run() override {
+		TraceSpan runSpan("SaveImageSetTask::run", "export");
+		HarmonographSampler sampler(harmonograph);
+
+		TraceSpan samplingSpan("sampling", "export");
+		const float tStep = ExportCanvas::getTimeStep(parameters);
+		const int samplesCount = ExportCanvas::getSamplesCount(parameters);
+		std::vector<float> xs(samplesCount), ys(samplesCount);
+		sampler.sample(0, tStep, samplesCount, xs.data(), ys.data());
+		samplingSpan.finish();
+
+		TraceSpan boundsSpan("bounds pass", "export");
+		float maxX, maxY;
+		SoftwareRasterizer::computeExtent(sampler, maxX, maxY);
+		boundsSpan.finish();
+
+		std::vector<std::thread> workers;
+		for (int i = 0; i < targets.size(); i++) {
+			const ExportTarget& target = targets[i];
+			const int saveZoom = SoftwareRasterizer::computeScale(maxX, maxY, target.width, target.height, target.borderPercentage / 100.0);
+			workers.emplace_back(&SaveImageSetTask::renderTarget, this, target, digests[i], saveZoom, xs.data(), ys.data(), samplesCount);
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
 		}
 
-		xZoom = (width / 2.0) / maxX;
-		yZoom = (height / 2.0) / maxY;
+		delete harmonograph;
+	}
 
-		saveZoom = xZoom > yZoom ? yZoom : xZoom;
-		saveZoom -= saveZoom * borderPercentage;
+private:
+	void renderTarget(ExportTarget target, QByteArray digest, int saveZoom, const float* xs, const float* ys, int samplesCount) {
+		TraceSpan targetSpan("export target", "export");
+		QImage* image = new QImage(target.width, target.height, QImage::Format_ARGB32);
+		AllocationTracker::track(image, "QImage", image->sizeInBytes());
 
+		{
+			ExportCanvas canvas(image, parameters, saveZoom);
+			canvas.drawSamples(xs, ys, 0, samplesCount);
+			canvas.finish();
+		}
+		const bool isWritten = ImageEncoder::save(*image, target.filename, encoder, compressionLevel);
+		ExportCache::instance().complete(digest, target.filename, isWritten);
 
-		int i = 1;
-		if (parameters.drawMode == DrawModes::linesMode) {
+		AllocationTracker::untrack(image);
+		delete image;
+	}
+};
 
-			float xLast = (harmonograph->getCoordinateByTime(Dimension::x, 0) * saveZoom) + widthAdd, xCurrent = 0;
-			float yLast = -(harmonograph->getCoordinateByTime(Dimension::y, 0) * saveZoom) + heightAdd, yCurrent = 0;
+/*
+ * Exports the curve as cubic Bezier paths (SVG or PDF) instead of rasterizing line segments.
+ * Gradient colors are quantized into a bounded palette and consecutive segments of the same
+ * color share one path, which keeps files small and viewers fast.
+ */
+class SaveVectorImageTask : public QRunnable {
+public:
+	QString filename;
+	QByteArray digest;
+	Harmonograph* harmonograph;
+	DrawParameters parameters;
+	ImageEncoders encoder = ImageEncoders::svg;
 
-			for (float t = tStep; t < maxT; t += tStep) {
+	int width = 1280;
+	int height = 720;
+	float borderPercentage = 0.03;
+	float tolerance = 0.25;
+	int paletteSize = 64;
 
-				savePen.setColor(QColor(parameters.primaryColor.red() + stepR * i, parameters.primaryColor.green() + stepG * i, parameters.primaryColor.blue() + stepB * i, 255));
-				savePainter->setPen(savePen);
-				xCurrent = (harmonograph->getCoordinateByTime(Dimension::x, t) * saveZoom) + widthAdd;
-				yCurrent = -(harmonograph->getCoordinateByTime(Dimension::y, t) * saveZoom) + heightAdd;
+	SaveVectorImageTask(Harmonograph* harmonograph, ImageSettings* settings) {
+		this->filename = settings->filename;
+		this->harmonograph = harmonograph;
+		this->parameters = settings->parameters;
+		this->encoder = settings->encoder;
+		this->width = settings->saveWidth;
+		this->height = settings->saveHeight;
+		this->borderPercentage = settings->borderPercentage / 100.0;
+		this->tolerance = settings->vectorTolerance;
+		this->paletteSize = std::max(1, settings->vectorPaletteSize);
 
-				savePainter->drawLine(xLast, yLast, xCurrent, yCurrent);
+		delete settings;
+	}
 
-				xLast = xCurrent;
-				yLast = yCurrent;
-				i++;
-			}
+	void run() override {
+		int const maxT = 255;
+		float const initialStep = 1;
+
+		HarmonographSampler sampler(harmonograph);
+		const int saveZoom = SoftwareRasterizer::computeScale(sampler, width, height, borderPercentage);
 
+		std::vector<CubicSegment> segments;
+		if (harmonograph->engine == HarmonographEngines::simulated) {
+			sampleStraightSegments(sampler, saveZoom, maxT, segments);
 		}
 		else {
-			for (float t = 0; t < maxT; t += parameters.timeStep) {
-				savePen.setColor(QColor(parameters.primaryColor.red() + stepR * i, parameters.primaryColor.green() + stepG * i, parameters.primaryColor.blue() + stepB * i, 255));
-				savePainter->setPen(savePen);
+			BezierFitter fitter(harmonograph, saveZoom, width / 2, height / 2, tolerance);
+			fitter.fit(0, maxT, initialStep, segments);
+		}
+
+		std::vector<QPainterPath> paths;
+		std::vector<QColor> colors;
 
-				savePainter->drawPoint((harmonograph->getCoordinateByTime(Dimension::x, t) * saveZoom) + widthAdd, -(harmonograph->getCoordinateByTime(Dimension::y, t) * saveZoom) + heightAdd);
+		int currentColorIndex = -1;
+		for (const CubicSegment& segment : segments) {
+			const int colorIndex = getColorIndex((segment.tStart + segment.tEnd) / 2 / maxT);
 
-				i++;
+			if (colorIndex != currentColorIndex) {
+				paths.push_back(QPainterPath(QPointF(segment.x0, segment.y0)));
+				colors.push_back(getPaletteColor(colorIndex));
+				currentColorIndex = colorIndex;
 			}
+
+			paths.back().cubicTo(segment.x1, segment.y1, segment.x2, segment.y2, segment.x3, segment.y3);
 		}
 
-		imageToSave->save(filename, "PNG");
+		const bool isWritten = encoder == ImageEncoders::pdf ? writePdf(paths, colors) : writeSvg(paths, colors);
+		ExportCache::instance().complete(digest, filename, isWritten);
 
-		delete savePainter;
-		delete imageToSave;
 		delete harmonograph;
 	}
+
+private:
+	//a simulated curve can not be evaluated at arbitrary times, it is written as the polyline the
+	//preview draws, each line as a cubic with control points on it
+	void sampleStraightSegments(const HarmonographSampler& sampler, int saveZoom, int maxT, std::vector<CubicSegment>& segments) {
+		const float tStep = parameters.timeStep;
+		const int count = (int)ceil(maxT / tStep);
+		std::vector<float> xs(count), ys(count);
+		sampler.sample(0, tStep, count, xs.data(), ys.data());
+
+		for (int i = 1; i < count; i++) {
+			CubicSegment segment;
+			segment.tStart = (i - 1) * tStep;
+			segment.tEnd = i * tStep;
+			segment.x0 = xs[i - 1] * saveZoom + width / 2;
+			segment.y0 = -ys[i - 1] * saveZoom + height / 2;
+			segment.x3 = xs[i] * saveZoom + width / 2;
+			segment.y3 = -ys[i] * saveZoom + height / 2;
+			segment.x1 = segment.x0 + (segment.x3 - segment.x0) / 3;
+			segment.y1 = segment.y0 + (segment.y3 - segment.y0) / 3;
+			segment.x2 = segment.x0 + (segment.x3 - segment.x0) * 2 / 3;
+			segment.y2 = segment.y0 + (segment.y3 - segment.y0) * 2 / 3;
+			segments.push_back(segment);
+		}
+	}
+
+	int getColorIndex(float position) {
+		if (!parameters.useTwoColors || paletteSize == 1) return 0;
+		return std::min(paletteSize - 1, (int)(position * (paletteSize - 1) + 0.5));
+	}
+
+	QColor getPaletteColor(int index) {
+		if (!parameters.useTwoColors || paletteSize == 1) return parameters.primaryColor;
+
+		const float k = (float)index / (paletteSize - 1);
+		return QColor(
+			parameters.primaryColor.red() + (parameters.secondColor.red() - parameters.primaryColor.red()) * k,
+			parameters.primaryColor.green() + (parameters.secondColor.green() - parameters.primaryColor.green()) * k,
+			parameters.primaryColor.blue() + (parameters.secondColor.blue() - parameters.primaryColor.blue()) * k);
+	}
+
+	bool writeSvg(const std::vector<QPainterPath>& paths, const std::vector<QColor>& colors) {
+		QFile file(filename);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+		QTextStream out(&file);
+		out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+		out << QString("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%1\" height=\"%2\" viewBox=\"0 0 %1 %2\">\n").arg(width).arg(height);
+
+		if (parameters.backgroundColor.alpha() > 0) {
+			out << QString("<rect width=\"100%\" height=\"100%\" fill=\"%1\"/>\n").arg(parameters.backgroundColor.name());
+		}
+
+		out << QString("<g fill=\"none\" stroke-width=\"%1\" stroke-linecap=\"round\" stroke-linejoin=\"round\">\n").arg(parameters.penWidth);
+
+		for (int i = 0; i < paths.size(); i++) {
+			const QPainterPath& path = paths[i];
+
+			out << "<path stroke=\"" << colors[i].name() << "\" d=\"M" << formatPoint(path.elementAt(0));
+
+			//cubicTo adds the first control point followed by two CurveToData elements
+			for (int j = 1; j + 2 < path.elementCount(); j += 3) {
+				out << "C" << formatPoint(path.elementAt(j)) << " " << formatPoint(path.elementAt(j + 1)) << " " << formatPoint(path.elementAt(j + 2));
+			}
+			out << "\"/>\n";
+		}
+
+		out << "</g>\n</svg>\n";
+		out.flush();
+		file.close();
+		return out.status() == QTextStream::Ok && file.error() == QFileDevice::NoError;
+	}
+
+	bool writePdf(const std::vector<QPainterPath>& paths, const std::vector<QColor>& colors) {
+		QPdfWriter writer(filename);
+		writer.setResolution(72);
+		writer.setPageSize(QPageSize(QSizeF(width, height), QPageSize::Point));
+		writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+
+		QPainter painter(&writer);
+		painter.setRenderHint(QPainter::Antialiasing, true);
+		if (parameters.backgroundColor.alpha() > 0) painter.fillRect(0, 0, width, height, parameters.backgroundColor);
+
+		QPen pen;
+		pen.setCapStyle(Qt::RoundCap);
+		pen.setJoinStyle(Qt::RoundJoin);
+		pen.setWidth(parameters.penWidth);
+
+		for (int i = 0; i < paths.size(); i++) {
+			pen.setColor(colors[i]);
+			painter.strokePath(paths[i], pen);
+		}
+
+		return painter.end();
+	}
+
+	static QString formatPoint(const QPointF& point) {
+		return QString::number(point.x(), 'f', 2) + " " + QString::number(point.y(), 'f', 2);
+	}
+};
+
+/*
+ * Encodes an image that is already rendered, used after the GPU exporter.
+ */
+class EncodeImageTask : public QRunnable {
+public:
+	QImage image;
+	QString filename;
+	QByteArray digest;
+	ImageEncoders encoder;
+	int compressionLevel;
+
+	EncodeImageTask(QImage image, QString filename, QByteArray digest, ImageEncoders encoder, int compressionLevel) {
+		this->image = image;
+		this->filename = filename;
+		this->digest = digest;
+		this->encoder = encoder;
+		this->compressionLevel = compressionLevel;
+	}
+
+	void run() override {
+		TraceSpan encodeSpan("encode", "export");
+		const bool isWritten = ImageEncoder::save(image, filename, encoder, compressionLevel);
+		ExportCache::instance().complete(digest, filename, isWritten);
+	}
 };
 
 HarmonographSaver::HarmonographSaver() {
@@ -137,11 +370,89 @@ HarmonographSaver::HarmonographSaver() {
 }
 
 void HarmonographSaver::saveImage(Harmonograph* harmonograph, ImageSettings* settings) {
+	const QByteArray digest = ExportCache::computeDigest(harmonograph, *settings);
+	if (ExportCache::instance().acquire(digest, *settings)) {
+		delete harmonograph;
+		delete settings;
+		return;
+	}
+
+	if (settings->encoder == ImageEncoders::svg || settings->encoder == ImageEncoders::pdf) {
+		SaveVectorImageTask* task = new SaveVectorImageTask(harmonograph, settings);
+		task->digest = digest;
+		QThreadPool::globalInstance()->start(task);
+		return;
+	}
+
+	if (settings->useGpuRenderer) {
+		//the exporter renders on its own thread, encoding then goes to the pool
+		GpuImageExporter::renderAsync(harmonograph, *settings, [harmonograph, settings, digest](const QImage& image) {
+			if (!image.isNull()) {
+				QThreadPool::globalInstance()->start(new EncodeImageTask(image, settings->filename, digest, settings->encoder, settings->compressionLevel));
+				delete harmonograph;
+				delete settings;
+				return;
+			}
+
+			//after a failed GPU render the CPU image is not what the digest describes, it is not cached
+			SaveImageTask* task = new SaveImageTask(harmonograph, settings);
+			task->digest = digest;
+			task->isCached = false;
+			QThreadPool::globalInstance()->start(task);
+		});
+		return;
+	}
+
 	SaveImageTask* task = new SaveImageTask(harmonograph, settings);
+	task->digest = digest;
 	QThreadPool::globalInstance()->start(task);
 }
 
+void HarmonographSaver::saveImages(Harmonograph* harmonograph, ImageSettings* settings, const std::vector<ExportTarget>& targets) {
+	const bool isVector = settings->encoder == ImageEncoders::svg || settings->encoder == ImageEncoders::pdf;
+
+	//vector and GPU exports do not rasterize shared samples, they are saved one by one
+	if (targets.size() == 1 || isVector || settings->useGpuRenderer) {
+		for (const ExportTarget& target : targets) {
+			ImageSettings* targetSettings = new ImageSettings(*settings);
+			targetSettings->filename = target.filename;
+			targetSettings->saveWidth = target.width;
+			targetSettings->saveHeight = target.height;
+			targetSettings->borderPercentage = target.borderPercentage;
+			saveImage(new Harmonograph(harmonograph), targetSettings);
+		}
+		delete harmonograph;
+		delete settings;
+		return;
+	}
+
+	//targets that are already cached or rendering elsewhere drop out of the shared pass
+	std::vector<ExportTarget> renderedTargets;
+	std::vector<QByteArray> digests;
+	for (const ExportTarget& target : targets) {
+		ImageSettings targetSettings(*settings);
+		targetSettings.filename = target.filename;
+		targetSettings.saveWidth = target.width;
+		targetSettings.saveHeight = target.height;
+		targetSettings.borderPercentage = target.borderPercentage;
+
+		const QByteArray digest = ExportCache::computeDigest(harmonograph, targetSettings);
+		if (ExportCache::instance().acquire(digest, targetSettings)) continue;
+
+		renderedTargets.push_back(target);
+		digests.push_back(digest);
+	}
+
+	if (renderedTargets.empty()) {
+		delete harmonograph;
+		delete settings;
+		return;
+	}
+	QThreadPool::globalInstance()->start(new SaveImageSetTask(harmonograph, settings, renderedTargets, digests));
+}
+
 void HarmonographSaver::saveParametersToFile(QString filename, Harmonograph* harmonograph) {
+	TraceSpan saveSpan("saveParametersToFile", "io");
 	QFile jsonFile(filename);
 
 	QJsonDocument document = QJsonDocument();
@@ -168,9 +479,11 @@ void HarmonographSaver::saveParametersToFile(QString filename, Harmonograph* har
 			dimObject.insert("phase", dim->phase);
 
 			dimensionsArray.insert(j, dimObject);
+			delete dim;
 		}
 
 		pendulumsArray.insert(i, dimensionsArray);
+		delete pendulums.at(i);
 	}
 
 	try {
@@ -181,6 +494,13 @@ void HarmonographSaver::saveParametersToFile(QString filename, Harmonograph* har
 		root.insert("isStar", QJsonValue(harmonograph->isStar));
 		root.insert("isCircle", QJsonValue(harmonograph->isCircle));
 		root.insert("pendulums", pendulumsArray);
+
+		QJsonObject simulationObject = QJsonObject();
+		simulationObject.insert("integrator", harmonograph->simulation.integrator == Integrators::rungeKutta4 ? "rungeKutta4" : "symplectic");
+		simulationObject.insert("swingAngle", harmonograph->simulation.swingAngle);
+		simulationObject.insert("coupling", harmonograph->simulation.coupling);
+		root.insert("engine", harmonograph->engine == HarmonographEngines::simulated ? "simulated" : "closedForm");
+		root.insert("simulation", simulationObject);
 		document.setObject(root);
 
 		jsonFile.write(QJsonDocument(document).toJson(QJsonDocument::Indented));
@@ -194,6 +514,8 @@ void HarmonographSaver::saveParametersToFile(QString filename, Harmonograph* har
 
 
 Harmonograph* HarmonographSaver::loadParametersFromFile(QString filename) {
+	TraceSpan loadSpan("loadParametersFromFile", "io");
+	AllocationSite site("loadParametersFromFile");
 	if (!filename.isEmpty()) {
 		QFile jsonFile(filename);
 		try {
@@ -234,6 +556,15 @@ Harmonograph* HarmonographSaver::loadParametersFromFile(QString filename) {
 			}
 
 			Harmonograph* harmonograph = new Harmonograph(pendulums, firstRatioValue, secondRatioValue, isStar, isCircle, frequencyPoint);
+
+			//files written before the simulation engine have neither key and stay closed form
+			if (root.value("engine").toString() == "simulated") harmonograph->engine = HarmonographEngines::simulated;
+			if (root.contains("simulation")) {
+				QJsonObject simulationObject = root.value("simulation").toObject();
+				if (simulationObject.value("integrator").toString() == "rungeKutta4") harmonograph->simulation.integrator = Integrators::rungeKutta4;
+				harmonograph->simulation.swingAngle = simulationObject.value("swingAngle").toDouble(harmonograph->simulation.swingAngle);
+				harmonograph->simulation.coupling = simulationObject.value("coupling").toDouble(harmonograph->simulation.coupling);
+			}
 			return harmonograph;
 		}
 		catch (...) {
@@ -0,0 +1,409 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "HarmonographSweeper.h"
+#include "HarmonographSampler.h"
+#include "PendulumSimulator.h"
+#include "ImageEncoder.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+float SweepAxis::valueAt(int index) const {
+	if (steps <= 1) return from;
+	return from + (to - from) * index / (steps - 1);
+}
+
+QString SweepAxis::label(int index) const {
+	const float value = valueAt(index);
+
+	switch (parameter) {
+	case SweepParameters::firstRatio:
+	case SweepParameters::secondRatio:
+		return QString::number(qRound(value));
+	case SweepParameters::damping:
+		return QString("d=%1").arg(value, 0, 'g', 3);
+	case SweepParameters::phase:
+		return QString("p=%1").arg(value, 0, 'f', 2);
+	default:
+		return QString("f=%1").arg(value, 0, 'f', 2);
+	}
+}
+
+QString SweepAxis::parameterName(SweepParameters parameter) {
+	switch (parameter) {
+	case SweepParameters::firstRatio:
+		return "firstRatio";
+	case SweepParameters::secondRatio:
+		return "secondRatio";
+	case SweepParameters::damping:
+		return "damping";
+	case SweepParameters::phase:
+		return "phase";
+	default:
+		return "frequencyPoint";
+	}
+}
+
+bool SweepAxis::fromString(const QString& str, SweepAxis& axis) {
+	const QStringList parts = str.split(":");
+	if (parts.size() != 4) return false;
+
+	const SweepParameters all[] = { SweepParameters::firstRatio, SweepParameters::secondRatio,
+		SweepParameters::frequencyPoint, SweepParameters::damping, SweepParameters::phase };
+
+	bool found = false;
+	for (SweepParameters parameter : all) {
+		if (parameterName(parameter) == parts.at(0)) {
+			axis.parameter = parameter;
+			found = true;
+		}
+	}
+
+	bool fromOk, toOk, stepsOk;
+	axis.from = parts.at(1).toFloat(&fromOk);
+	axis.to = parts.at(2).toFloat(&toOk);
+	axis.steps = parts.at(3).toInt(&stepsOk);
+
+	return found && fromOk && toOk && stepsOk && axis.steps > 0;
+}
+
+HarmonographSweeper::HarmonographSweeper(Harmonograph* baseHarmonograph, SweepSettings settings) {
+	this->baseHarmonograph = baseHarmonograph;
+	this->settings = settings;
+}
+
+HarmonographSweeper::~HarmonographSweeper() {
+	for (Pendulum* p : baseHarmonograph->getPendulums()) {
+		delete p;
+	}
+	delete baseHarmonograph;
+}
+
+Harmonograph* HarmonographSweeper::createCell(int column, int row) {
+	Harmonograph* cell = new Harmonograph(baseHarmonograph);
+	const SweepAxis* axes[] = { &settings.columns, &settings.rows };
+	const int indices[] = { column, row };
+
+	float frequencyPoint = cell->frequencyPoint;
+	bool frequenciesChanged = false;
+
+	for (int i = 0; i < 2; i++) {
+		const float value = axes[i]->valueAt(indices[i]);
+
+		switch (axes[i]->parameter) {
+		case SweepParameters::firstRatio:
+			cell->firstRatioValue = std::max(1, qRound(value));
+			cell->isStar = true;
+			frequenciesChanged = true;
+			break;
+		case SweepParameters::secondRatio:
+			cell->secondRatioValue = std::max(1, qRound(value));
+			cell->isStar = true;
+			frequenciesChanged = true;
+			break;
+		case SweepParameters::frequencyPoint:
+			frequencyPoint = value;
+			frequenciesChanged = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	//same star logic as Harmonograph::update, but the random phases and noise are kept
+	if (frequenciesChanged) cell->changeFrequencyPointNoUpdate(frequencyPoint);
+
+	for (int i = 0; i < 2; i++) {
+		if (axes[i]->parameter != SweepParameters::damping) continue;
+
+		for (Pendulum* p : cell->getPendulums()) {
+			p->setEquationParameter(Dimension::x, EquationParameter::dumping, axes[i]->valueAt(indices[i]));
+			p->setEquationParameter(Dimension::y, EquationParameter::dumping, axes[i]->valueAt(indices[i]));
+		}
+	}
+
+	return cell;
+}
+
+float HarmonographSweeper::phaseOffset(int column, int row) const {
+	float offset = 0;
+	if (settings.columns.parameter == SweepParameters::phase) offset += settings.columns.valueAt(column);
+	if (settings.rows.parameter == SweepParameters::phase) offset += settings.rows.valueAt(row);
+	return offset;
+}
+
+bool HarmonographSweeper::render() {
+	const int columns = settings.columns.steps;
+	const int rows = settings.rows.steps;
+	const bool columnsArePhase = settings.columns.parameter == SweepParameters::phase;
+	const bool rowsArePhase = settings.rows.parameter == SweepParameters::phase;
+	const bool isSimulated = baseHarmonograph->engine == HarmonographEngines::simulated;
+
+	std::vector<std::vector<int>> jobs;
+	if (isSimulated) {
+		//a simulated curve is not linear in its phases, so every cell is integrated on its own,
+		//a few cells per job so the simulator steps them together
+		for (int cellIndex = 0; cellIndex < columns * rows; cellIndex++) {
+			if (cellIndex % simulatedCellsPerJob == 0) jobs.emplace_back();
+			jobs.back().push_back(cellIndex);
+		}
+	}
+	else {
+		//cells that differ only in phase share one job and one set of basis samples
+		std::map<int, std::vector<int>> groups;
+		for (int row = 0; row < rows; row++) {
+			for (int column = 0; column < columns; column++) {
+				const int key = (columnsArePhase ? 0 : column) + (rowsArePhase ? 0 : row) * columns;
+				groups[key].push_back(row * columns + column);
+			}
+		}
+
+		for (auto& group : groups) {
+			jobs.push_back(group.second);
+		}
+	}
+
+	std::vector<QImage> cells(columns * rows);
+	std::atomic<int> nextJob(0);
+
+	auto worker = [&]() {
+		const int count = static_cast<int>(ceil(255 / settings.parameters.timeStep));
+		std::vector<float> baseX(count), shiftedX(count), ys(count), xs(count);
+		HarmonographSampler sampler;
+
+		if (isSimulated) {
+			renderSimulatedJobs(jobs, nextJob, count, cells);
+			return;
+		}
+
+		for (int j = nextJob++; j < jobs.size(); j = nextJob++) {
+			const std::vector<int>& job = jobs[j];
+			Harmonograph* harmonograph = createCell(job.front() % columns, job.front() / columns);
+
+			sampler.load(harmonograph);
+			sampler.sample(0, settings.parameters.timeStep, count, baseX.data(), ys.data());
+
+			if (job.size() > 1 || phaseOffset(job.front() % columns, job.front() / columns) != 0) {
+				harmonograph->rotateXAxis(-pi / 2);
+				sampler.load(harmonograph);
+				sampler.sample(0, settings.parameters.timeStep, count, shiftedX.data(), xs.data());
+			}
+
+			for (Pendulum* p : harmonograph->getPendulums()) {
+				delete p;
+			}
+			delete harmonograph;
+
+			for (int cellIndex : job) {
+				const float offset = phaseOffset(cellIndex % columns, cellIndex / columns);
+
+				if (offset == 0) {
+					std::copy(baseX.begin(), baseX.end(), xs.begin());
+				}
+				else {
+					const float c = cos(offset), s = sin(offset);
+					for (int i = 0; i < count; i++) {
+						xs[i] = c * baseX[i] - s * shiftedX[i];
+					}
+				}
+
+				cells[cellIndex] = QImage(settings.cellSize, settings.cellSize, QImage::Format_ARGB32_Premultiplied);
+				drawCell(cells[cellIndex], xs, ys);
+			}
+		}
+	};
+
+	const int threadsCount = std::max(1u, std::thread::hardware_concurrency());
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threadsCount; i++) {
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& t : workers) {
+		t.join();
+	}
+
+	const int cellHeight = settings.cellSize + settings.labelHeight;
+	QImage sheet(columns * settings.cellSize, rows * cellHeight, QImage::Format_ARGB32_Premultiplied);
+	sheet.fill(settings.parameters.backgroundColor);
+
+	QPainter painter(&sheet);
+	painter.setPen(QColor(128, 128, 128));
+
+	for (int row = 0; row < rows; row++) {
+		for (int column = 0; column < columns; column++) {
+			const int x = column * settings.cellSize;
+			const int y = row * cellHeight;
+
+			painter.drawImage(x, y, cells[row * columns + column]);
+			painter.drawText(QRect(x, y + settings.cellSize, settings.cellSize, settings.labelHeight), Qt::AlignCenter,
+				settings.columns.label(column) + "  " + settings.rows.label(row));
+		}
+	}
+	painter.end();
+
+	if (!ImageEncoder::save(sheet, settings.filename, ImageEncoders::parallelPng, 6)) return false;
+
+	return writeIndex(settings.filename);
+}
+
+void HarmonographSweeper::renderSimulatedJobs(const std::vector<std::vector<int>>& jobs, std::atomic<int>& nextJob, int count, std::vector<QImage>& cells) {
+	const int columns = settings.columns.steps;
+	std::vector<std::vector<float>> xs(simulatedCellsPerJob, std::vector<float>(count));
+	std::vector<std::vector<float>> ys(simulatedCellsPerJob, std::vector<float>(count));
+	PendulumSimulator simulator;
+
+	for (int j = nextJob++; j < jobs.size(); j = nextJob++) {
+		const std::vector<int>& job = jobs[j];
+		std::vector<Harmonograph*> harmonographs;
+		std::vector<float*> xPointers, yPointers;
+
+		for (int i = 0; i < job.size(); i++) {
+			const int column = job[i] % columns, row = job[i] / columns;
+			Harmonograph* harmonograph = createCell(column, row);
+			harmonograph->rotateXAxis(phaseOffset(column, row));
+			harmonographs.push_back(harmonograph);
+			xPointers.push_back(xs[i].data());
+			yPointers.push_back(ys[i].data());
+		}
+
+		simulator.load(harmonographs);
+		simulator.sampleBatch(settings.parameters.timeStep, count, xPointers, yPointers);
+
+		for (int i = 0; i < job.size(); i++) {
+			for (Pendulum* p : harmonographs[i]->getPendulums()) {
+				delete p;
+			}
+			delete harmonographs[i];
+
+			cells[job[i]] = QImage(settings.cellSize, settings.cellSize, QImage::Format_ARGB32_Premultiplied);
+			drawCell(cells[job[i]], xs[i], ys[i]);
+		}
+	}
+}
+
+void HarmonographSweeper::drawCell(QImage& cell, const std::vector<float>& xs, const std::vector<float>& ys) {
+	cell.fill(settings.parameters.backgroundColor);
+
+	float maxAbs = 0;
+	for (int i = 0; i < xs.size(); i++) {
+		maxAbs = std::max(maxAbs, std::max(std::abs(xs[i]), std::abs(ys[i])));
+	}
+	if (maxAbs <= 0) return;
+
+	const float center = settings.cellSize / 2.0f;
+	const float zoom = center * 0.95f / maxAbs;
+
+	QPainter painter(&cell);
+	painter.setRenderHint(QPainter::Antialiasing, settings.parameters.useAntiAliasing);
+	QPen pen(settings.parameters.primaryColor, 1);
+
+	//the gradient is split into bands, each drawn with one polyline
+	const int bandsCount = settings.parameters.useTwoColors ? 64 : 1;
+	const int bandSize = (xs.size() + bandsCount - 1) / bandsCount;
+	const QColor& first = settings.parameters.primaryColor;
+	const QColor& second = settings.parameters.secondColor;
+	std::vector<QPointF> points;
+
+	for (int band = 0; band < bandsCount; band++) {
+		const int begin = band * bandSize;
+		const int end = std::min<int>(xs.size(), begin + bandSize + 1);
+		if (begin >= end) break;
+
+		points.clear();
+		for (int i = begin; i < end; i++) {
+			points.push_back(QPointF(center + xs[i] * zoom, center - ys[i] * zoom));
+		}
+
+		const float k = bandsCount > 1 ? static_cast<float>(band) / (bandsCount - 1) : 0;
+		pen.setColor(QColor(first.red() + (second.red() - first.red()) * k,
+			first.green() + (second.green() - first.green()) * k,
+			first.blue() + (second.blue() - first.blue()) * k));
+		painter.setPen(pen);
+
+		if (settings.parameters.drawMode == DrawModes::linesMode) painter.drawPolyline(points.data(), points.size());
+		else painter.drawPoints(points.data(), points.size());
+	}
+}
+
+bool HarmonographSweeper::writeIndex(const QString& imageFilename) {
+	QFileInfo fileInfo(imageFilename);
+	QFile indexFile(fileInfo.dir().filePath(fileInfo.completeBaseName() + ".json"));
+	if (!indexFile.open(QIODevice::WriteOnly)) return false;
+
+	const int cellHeight = settings.cellSize + settings.labelHeight;
+	QJsonArray cellsArray;
+
+	for (int row = 0; row < settings.rows.steps; row++) {
+		for (int column = 0; column < settings.columns.steps; column++) {
+			Harmonograph* cell = createCell(column, row);
+
+			QJsonObject parametersObject;
+			parametersObject.insert("frequencyPoint", cell->frequencyPoint);
+			parametersObject.insert("frequencyRatio", QString("%1:%2").arg(cell->firstRatioValue).arg(cell->secondRatioValue));
+			parametersObject.insert("isStar", cell->isStar);
+			parametersObject.insert("isCircle", cell->isCircle);
+			parametersObject.insert(SweepAxis::parameterName(settings.columns.parameter), settings.columns.valueAt(column));
+			parametersObject.insert(SweepAxis::parameterName(settings.rows.parameter), settings.rows.valueAt(row));
+
+			for (Pendulum* p : cell->getPendulums()) {
+				delete p;
+			}
+			delete cell;
+
+			QJsonObject cellObject;
+			cellObject.insert("row", row);
+			cellObject.insert("column", column);
+			cellObject.insert("x", column * settings.cellSize);
+			cellObject.insert("y", row * cellHeight);
+			cellObject.insert("width", settings.cellSize);
+			cellObject.insert("height", settings.cellSize);
+			cellObject.insert("parameters", parametersObject);
+			cellsArray.append(cellObject);
+		}
+	}
+
+	QJsonObject root;
+	root.insert("image", fileInfo.fileName());
+	root.insert("columns", QString("%1:%2:%3:%4").arg(SweepAxis::parameterName(settings.columns.parameter))
+		.arg(settings.columns.from).arg(settings.columns.to).arg(settings.columns.steps));
+	root.insert("rows", QString("%1:%2:%3:%4").arg(SweepAxis::parameterName(settings.rows.parameter))
+		.arg(settings.rows.from).arg(settings.rows.to).arg(settings.rows.steps));
+	root.insert("cells", cellsArray);
+
+	indexFile.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+	indexFile.close();
+	return true;
+}
+
+SweepTask::SweepTask(Harmonograph* baseHarmonograph, SweepSettings settings) {
+	sweeper = new HarmonographSweeper(baseHarmonograph, settings);
+}
+
+SweepTask::~SweepTask() {
+	delete sweeper;
+}
+
+void SweepTask::run() {
+	sweeper->render();
+}
@@ -0,0 +1,127 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "ImageEncoder.h"
+#include "PngEncoder.h"
+
+bool ImageEncoder::save(const QImage& image, const QString& filename, ImageEncoders encoder, int compressionLevel) {
+	switch (encoder) {
+	case ImageEncoders::qtPng:
+		//Qt maps quality 100..0 to zlib levels 0..9
+		return image.save(filename, "PNG", 100 - compressionLevel * 100 / 9);
+	case ImageEncoders::parallelPng:
+		return saveParallelPng(image, filename, compressionLevel);
+	case ImageEncoders::ppm:
+		return saveNetpbm(image, filename, false);
+	case ImageEncoders::pam:
+		return saveNetpbm(image, filename, true);
+	case ImageEncoders::rawRGBA:
+		return saveRawRGBA(image, filename);
+	default:
+		return false;
+	}
+}
+
+QString ImageEncoder::fileFilter(ImageEncoders encoder) {
+	switch (encoder) {
+	case ImageEncoders::ppm:
+		return "ppm image (*.ppm);;All Files (*)";
+	case ImageEncoders::pam:
+		return "pam image (*.pam);;All Files (*)";
+	case ImageEncoders::rawRGBA:
+		return "raw RGBA (*.rgba);;All Files (*)";
+	case ImageEncoders::svg:
+		return "svg image (*.svg);;All Files (*)";
+	case ImageEncoders::pdf:
+		return "pdf document (*.pdf);;All Files (*)";
+	default:
+		return "png image (*.png);;All Files (*)";
+	}
+}
+
+bool ImageEncoder::saveParallelPng(const QImage& image, const QString& filename, int compressionLevel) {
+	const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+
+	std::vector<unsigned char> png;
+	if (!PngEncoder::encode(rgba.constBits(), rgba.width(), rgba.height(), rgba.bytesPerLine(), compressionLevel, png)) return false;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	const bool isWritten = file.write(reinterpret_cast<const char*>(png.data()), png.size()) == static_cast<qint64>(png.size());
+	file.close();
+	return isWritten;
+}
+
+bool ImageEncoder::saveNetpbm(const QImage& image, const QString& filename, bool isPam) {
+	const QImage converted = image.convertToFormat(isPam ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+	const int rowBytes = converted.width() * (isPam ? 4 : 3);
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	QByteArray header;
+	if (isPam) {
+		header = QString("P7\nWIDTH %1\nHEIGHT %2\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n")
+			.arg(converted.width()).arg(converted.height()).toLatin1();
+	}
+	else {
+		header = QString("P6\n%1 %2\n255\n").arg(converted.width()).arg(converted.height()).toLatin1();
+	}
+
+	bool isWritten = file.write(header) == header.size();
+	for (int y = 0; y < converted.height() && isWritten; y++) {
+		isWritten = file.write(reinterpret_cast<const char*>(converted.constScanLine(y)), rowBytes) == rowBytes;
+	}
+
+	file.close();
+	return isWritten;
+}
+
+bool ImageEncoder::saveRawRGBA(const QImage& image, const QString& filename) {
+	const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+	const int rowBytes = rgba.width() * 4;
+
+	QFile file(filename);
+	if (!file.open(QIODevice::WriteOnly)) return false;
+
+	bool isWritten = true;
+	for (int y = 0; y < rgba.height() && isWritten; y++) {
+		isWritten = file.write(reinterpret_cast<const char*>(rgba.constScanLine(y)), rowBytes) == rowBytes;
+	}
+	file.close();
+
+	QJsonObject root;
+	root.insert("width", rgba.width());
+	root.insert("height", rgba.height());
+	root.insert("format", "RGBA8888");
+	root.insert("bytesPerPixel", 4);
+	root.insert("stride", rowBytes);
+	root.insert("premultiplied", false);
+
+	QFile sidecarFile(filename + ".json");
+	if (!sidecarFile.open(QIODevice::WriteOnly)) return false;
+
+	isWritten = sidecarFile.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) > 0 && isWritten;
+	sidecarFile.close();
+
+	return isWritten;
+}
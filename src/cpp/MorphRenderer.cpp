@@ -0,0 +1,104 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "MorphRenderer.h"
+#include "ExportCanvas.h"
+#include "FramePipeline.h"
+#include "HarmonographSampler.h"
+#include "ImageEncoder.h"
+#include "SoftwareRasterizer.h"
+#include "Tracer.h"
+
+static void deleteHarmonograph(Harmonograph* harmonograph) {
+	for (Pendulum* p : harmonograph->getPendulums()) {
+		delete p;
+	}
+	delete harmonograph;
+}
+
+MorphRenderer::MorphRenderer(const MorphTimeline& timeline, DrawParameters parameters, int width, int height, int borderPercentage) {
+	this->timeline = timeline;
+	this->parameters = parameters;
+	this->width = width;
+	this->height = height;
+
+	TraceSpan boundsSpan("morph bounds", "export");
+	Harmonograph* harmonograph = timeline.createHarmonograph();
+	HarmonographSampler sampler;
+	float maxX = 0, maxY = 0;
+
+	for (int frame = 0; frame < timeline.getFrameCount(); frame++) {
+		timeline.applyFrame(frame, harmonograph);
+		sampler.load(harmonograph);
+
+		float frameX, frameY;
+		SoftwareRasterizer::computeExtent(sampler, frameX, frameY);
+		maxX = std::max(maxX, frameX);
+		maxY = std::max(maxY, frameY);
+	}
+	deleteHarmonograph(harmonograph);
+
+	saveZoom = SoftwareRasterizer::computeScale(maxX, maxY, width, height, borderPercentage / 100.0);
+}
+
+QImage MorphRenderer::renderFrame(int frame) const {
+	TraceSpan frameSpan("morph frame", "export");
+	int const samplesChunkSize = 1 << 16;
+
+	Harmonograph* harmonograph = timeline.createHarmonograph();
+	timeline.applyFrame(frame, harmonograph);
+
+	//frames are rendered side by side, one thread each is enough
+	HarmonographSampler sampler(harmonograph);
+	sampler.setMaxThreads(1);
+	std::vector<float> xs(samplesChunkSize), ys(samplesChunkSize);
+
+	QImage image(width, height, QImage::Format_ARGB32);
+	ExportCanvas canvas(&image, parameters, saveZoom);
+	const float tStep = canvas.getTimeStep();
+	const int samplesCount = ExportCanvas::getSamplesCount(parameters);
+
+	for (int first = 0; first < samplesCount; first += samplesChunkSize) {
+		const int count = std::min(samplesChunkSize, samplesCount - first);
+		sampler.sample(first * (double)tStep, tStep, count, xs.data(), ys.data());
+		canvas.drawSamples(xs.data(), ys.data(), first, count);
+	}
+	canvas.finish();
+
+	deleteHarmonograph(harmonograph);
+	return image;
+}
+
+bool MorphRenderer::renderToFiles(const QString& dirPath) {
+	TraceSpan sequenceSpan("morph sequence", "export");
+	if (!QDir().mkpath(dirPath)) return false;
+	const QDir dir(dirPath);
+
+	FramePipeline pipeline(getFrameCount());
+	return pipeline.run(
+		[this](int frame) {
+			return renderFrame(frame);
+		},
+		[&dir](int frame, const QImage& image) {
+			const QString filename = dir.filePath(QString("frame-%1.png").arg(frame, 5, 10, QChar('0')));
+			return ImageEncoder::save(image, filename, ImageEncoders::parallelPng, 6);
+		});
+}
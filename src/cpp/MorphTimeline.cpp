@@ -0,0 +1,157 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "MorphTimeline.h"
+#include <cmath>
+
+static const Dimension dimensions[] = { Dimension::x, Dimension::y };
+static const EquationParameter parameters[] = { EquationParameter::amplitude, EquationParameter::dumping,
+	EquationParameter::frequency, EquationParameter::phase };
+static const int phaseIndex = 3;
+
+bool MorphTimeline::addKeyframe(Harmonograph* harmonograph, int framesToNext, MorphEasings easing, std::string& error) {
+	const std::vector<Pendulum*>& pendulums = harmonograph->getPendulums();
+	if (!keyframes.empty() && pendulums.size() != numOfPendulums) {
+		error = "keyframe " + std::to_string(keyframes.size() + 1) + " has " + std::to_string(pendulums.size()) +
+			" pendulums, the first one has " + std::to_string(numOfPendulums);
+		return false;
+	}
+	if (!keyframes.empty() && harmonograph->engine != engine) {
+		error = "keyframe " + std::to_string(keyframes.size() + 1) + " uses another engine than the first one";
+		return false;
+	}
+	if (!keyframes.empty() && engine == HarmonographEngines::simulated && harmonograph->simulation.integrator != integrator) {
+		error = "keyframe " + std::to_string(keyframes.size() + 1) + " uses another integrator than the first one";
+		return false;
+	}
+	if (framesToNext < 1) {
+		error = "a transition needs at least one frame";
+		return false;
+	}
+
+	Keyframe keyframe;
+	keyframe.framesToNext = framesToNext;
+	keyframe.easing = easing;
+	for (Pendulum* p : pendulums) {
+		for (Dimension dimension : dimensions) {
+			for (EquationParameter parameter : parameters) {
+				keyframe.parameters.push_back(p->getEquationParameter(dimension, parameter));
+			}
+		}
+	}
+	keyframe.parameters.push_back(harmonograph->simulation.swingAngle);
+	keyframe.parameters.push_back(harmonograph->simulation.coupling);
+
+	numOfPendulums = pendulums.size();
+	engine = harmonograph->engine;
+	integrator = harmonograph->simulation.integrator;
+	keyframes.push_back(keyframe);
+	return true;
+}
+
+void MorphTimeline::buildSchedule() {
+	const float pi = atan(1) * 4;
+	const int parametersCount = getParametersCount();
+
+	//every phase moves to within half a turn of the previous keyframe
+	std::vector<Keyframe> unwrapped = keyframes;
+	for (int k = 1; k < unwrapped.size(); k++) {
+		for (int i = phaseIndex; i < numOfPendulums * parametersPerPendulum; i += 4) {
+			const float previous = unwrapped[k - 1].parameters[i];
+			unwrapped[k].parameters[i] = previous + remainder(unwrapped[k].parameters[i] - previous, 2 * pi);
+		}
+	}
+
+	frameCount = unwrapped.empty() ? 0 : 1;
+	for (int k = 0; k + 1 < unwrapped.size(); k++) {
+		frameCount += unwrapped[k].framesToNext;
+	}
+
+	schedule.resize((size_t)frameCount * parametersCount);
+	float* frameParameters = schedule.data();
+
+	for (int k = 0; k + 1 < unwrapped.size(); k++) {
+		const Keyframe& from = unwrapped[k];
+		const Keyframe& to = unwrapped[k + 1];
+
+		for (int frame = 0; frame < from.framesToNext; frame++) {
+			const float weight = ease(from.easing, (float)frame / from.framesToNext);
+			for (int i = 0; i < parametersCount; i++) {
+				frameParameters[i] = from.parameters[i] + (to.parameters[i] - from.parameters[i]) * weight;
+			}
+			frameParameters += parametersCount;
+		}
+	}
+	if (!unwrapped.empty()) std::copy(unwrapped.back().parameters.begin(), unwrapped.back().parameters.end(), frameParameters);
+}
+
+Harmonograph* MorphTimeline::createHarmonograph() const {
+	std::vector<Pendulum*> pendulums;
+	for (int i = 0; i < numOfPendulums; i++) {
+		std::vector<PendulumDimension*> pendulumDimensions;
+		for (int d = 0; d < 2; d++) {
+			pendulumDimensions.push_back(new PendulumDimension(1, 0, 0, 0, 0));
+		}
+		pendulums.push_back(new Pendulum(pendulumDimensions));
+	}
+	Harmonograph* harmonograph = new Harmonograph(pendulums, 1, 1, false, false, 2);
+	harmonograph->engine = engine;
+	harmonograph->simulation.integrator = integrator;
+	return harmonograph;
+}
+
+void MorphTimeline::applyFrame(int frame, Harmonograph* harmonograph) const {
+	const float* frameParameters = schedule.data() + (size_t)frame * getParametersCount();
+
+	for (Pendulum* p : harmonograph->getPendulums()) {
+		for (Dimension dimension : dimensions) {
+			for (EquationParameter parameter : parameters) {
+				p->setEquationParameter(dimension, parameter, *frameParameters++);
+			}
+		}
+	}
+	harmonograph->simulation.swingAngle = frameParameters[0];
+	harmonograph->simulation.coupling = frameParameters[1];
+}
+
+bool MorphTimeline::easingFromString(const std::string& name, MorphEasings& easing) {
+	const char* names[] = { "linear", "easeIn", "easeOut", "easeInOut" };
+	for (int i = 0; i < 4; i++) {
+		if (name == names[i]) {
+			easing = static_cast<MorphEasings>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+float MorphTimeline::ease(MorphEasings easing, float x) {
+	switch (easing) {
+	case MorphEasings::easeIn:
+		return x * x * x;
+	case MorphEasings::easeOut:
+		return 1 - (1 - x) * (1 - x) * (1 - x);
+	case MorphEasings::easeInOut:
+		return x < 0.5f ? 4 * x * x * x : 1 - 4 * (1 - x) * (1 - x) * (1 - x);
+	default:
+		return x;
+	}
+}
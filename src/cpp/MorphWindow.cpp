@@ -0,0 +1,121 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "MorphWindow.h"
+
+MorphWindow::MorphWindow(MorphRenderer* renderer, int fps, QWidget* parent) : QWidget(parent) {
+	this->renderer = renderer;
+
+	frameTimer = new QTimer(this);
+	frameTimer->setTimerType(Qt::PreciseTimer);
+	frameTimer->setInterval(1000 / std::max(1, fps));
+	connect(frameTimer, SIGNAL(timeout()), this, SLOT(showNextFrame()));
+
+	play();
+}
+
+MorphWindow::~MorphWindow() {
+	stop();
+	delete renderer;
+}
+
+void MorphWindow::play() {
+	stop();
+
+	isStopped = false;
+	shownFrames = 0;
+	pipeline = new FramePipeline(renderer->getFrameCount());
+	renderThread = std::thread([this] {
+		pipeline->run(
+			[this](int frame) {
+				return renderer->renderFrame(frame);
+			},
+			[this](int frame, const QImage& image) {
+				return enqueueFrame(image);
+			});
+	});
+	frameTimer->start();
+}
+
+void MorphWindow::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isStopped = true;
+		queuedFrames.clear();
+		queueChanged.notify_all();
+	}
+	if (pipeline != nullptr) pipeline->cancel();
+	if (renderThread.joinable()) renderThread.join();
+
+	delete pipeline;
+	pipeline = nullptr;
+	frameTimer->stop();
+}
+
+bool MorphWindow::enqueueFrame(const QImage& image) {
+	//the pipeline thread waits here while the screen is behind
+	std::unique_lock<std::mutex> lock(mutex);
+	queueChanged.wait(lock, [this] {
+		return isStopped || queuedFrames.size() < maxQueuedFrames;
+	});
+	if (isStopped) return false;
+
+	queuedFrames.push_back(image);
+	return true;
+}
+
+void MorphWindow::showNextFrame() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		//a frame that is not rendered yet is shown late, never skipped
+		if (queuedFrames.empty()) return;
+
+		currentFrame = queuedFrames.front();
+		queuedFrames.pop_front();
+		queueChanged.notify_all();
+	}
+
+	shownFrames++;
+	setWindowTitle(tr("Morph - frame %1 of %2").arg(shownFrames).arg(renderer->getFrameCount()));
+	if (shownFrames == renderer->getFrameCount()) frameTimer->stop();
+	update();
+}
+
+void MorphWindow::paintEvent(QPaintEvent* event) {
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+	if (currentFrame.isNull()) return;
+
+	const QSize size = currentFrame.size().scaled(this->size(), Qt::KeepAspectRatio);
+	const QRect target((width() - size.width()) / 2, (height() - size.height()) / 2, size.width(), size.height());
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, true);
+	painter.drawImage(target, currentFrame);
+}
+
+void MorphWindow::keyPressEvent(QKeyEvent* event) {
+	if (event->key() == Qt::Key_Space) play();
+	else QWidget::keyPressEvent(event);
+}
+
+void MorphWindow::closeEvent(QCloseEvent* event) {
+	stop();
+	QWidget::closeEvent(event);
+}
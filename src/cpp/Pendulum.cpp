@@ -19,6 +19,9 @@
  */
 
 #include "Pendulum.h"
+#include <stdexcept>
+
+const char* const Pendulum::allocationType = "Pendulum";
 
 std::vector<PendulumDimension*> Pendulum::getDimensionsCopy() {
 	std::vector<PendulumDimension*> dimensionsCopy;
@@ -31,23 +34,29 @@ std::vector<PendulumDimension*> Pendulum::getDimensionsCopy() {
 }
 
 float Pendulum::getCoordinateByTime(Dimension dimension, float t) {
-	const int index = static_cast<std::underlying_type<Dimension>::type>(dimension);
-
-	PendulumDimension* currentDimension = dimensions.at(index);
-
-	if(index%2==0){
-		return exp(-currentDimension->dumping * t) * cos(currentDimension->frequency * t + currentDimension->phase);
+	switch (dimension) {
+	case Dimension::x: return getCoordinateByTime<Dimension::x>(t);
+	case Dimension::y: return getCoordinateByTime<Dimension::y>(t);
+	case Dimension::z: return getCoordinateByTime<Dimension::z>(t);
+	default: throw std::out_of_range("unknown dimension");
 	}
-	else{
-		return exp(-currentDimension->dumping * t) * sin(currentDimension->frequency * t + currentDimension->phase);
+}
+float Pendulum::getDerivativeByTime(Dimension dimension, float t) {
+	switch (dimension) {
+	case Dimension::x: return getDerivativeByTime<Dimension::x>(t);
+	case Dimension::y: return getDerivativeByTime<Dimension::y>(t);
+	case Dimension::z: return getDerivativeByTime<Dimension::z>(t);
+	default: throw std::out_of_range("unknown dimension");
 	}
-
-	
 }
 void Pendulum::update(float frequencyPoint, bool isCircle) {
-	int r = rand();
+	CounterRandom random(CounterRandom::nextSeed(), 0);
+	update(frequencyPoint, isCircle, random);
+}
+void Pendulum::update(float frequencyPoint, bool isCircle, CounterRandom& random) {
+	int r = random.bounded(RAND_MAX);
 	for (PendulumDimension* dimension : dimensions) {
-		dimension->update(frequencyPoint, isCircle, r);
+		dimension->update(frequencyPoint, isCircle, r, random);
 	}
 }
 void Pendulum::changeDimensionEquationPhase(Dimension dimension, float radians) {
@@ -126,3 +135,9 @@ Pendulum::Pendulum(int dimensionsCount, float frequencyPoint, bool isCircle) {
 	}
 	this->update(frequencyPoint, isCircle);
 }
+
+Pendulum::~Pendulum() {
+	for (PendulumDimension* d : dimensions) {
+		delete d;
+	}
+}
@@ -20,6 +20,8 @@
 
 #include "PendulumDimension.h"
 
+const char* const PendulumDimension::allocationType = "PendulumDimension";
+
 PendulumDimension::PendulumDimension(float frequencyPoint, bool isCircle, int circleRandomValue) {
 	update(frequencyPoint, isCircle, circleRandomValue );
 }
@@ -34,10 +36,15 @@ PendulumDimension::PendulumDimension(float amplitude, float frequency, float pha
 }
 
 void PendulumDimension::update(float frequencyPoint, bool isCircle, int circleRandomValue) {
+	CounterRandom random(CounterRandom::nextSeed(), 0);
+	update(frequencyPoint, isCircle, circleRandomValue, random);
+}
+
+void PendulumDimension::update(float frequencyPoint, bool isCircle, int circleRandomValue, CounterRandom& random) {
 	if (!isCircle) {
-		dumping = QRandomGenerator::global()->bounded(1e-02);
-		phase = QRandomGenerator::global()->bounded(pi);
-		frequencyNoise = QRandomGenerator::global()->bounded(1e-02 - 1e-01);
+		dumping = random.bounded(1e-02);
+		phase = random.bounded((double)pi);
+		frequencyNoise = random.bounded(1e-02 - 1e-01);
 		frequency = frequencyPoint + frequencyNoise;
 		amplitude = 1;
 	}
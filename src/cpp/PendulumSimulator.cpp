@@ -0,0 +1,453 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "PendulumSimulator.h"
+#include "FastMath.h"
+#include <algorithm>
+
+void PendulumSimulator::load(Harmonograph* harmonograph) {
+	load(std::vector<Harmonograph*>{ harmonograph });
+}
+
+void PendulumSimulator::load(const std::vector<Harmonograph*>& harmonographs) {
+	harmonographsCount = harmonographs.size();
+	integrator = harmonographs.empty() ? Integrators::symplectic : harmonographs.front()->simulation.integrator;
+
+	stiffness.clear();
+	dumping.clear();
+	swing.clear();
+	inverseSwing.clear();
+	coupling.clear();
+	initialPosition.clear();
+	initialVelocity.clear();
+	coordinate.clear();
+	coordinateLanes.assign(harmonographsCount * 2, 0);
+
+	for (int h = 0; h < harmonographsCount; h++) {
+		const SimulationSettings& settings = harmonographs[h]->simulation;
+
+		for (Pendulum* p : harmonographs[h]->getPendulums()) {
+			for (int dimension = 0; dimension < 2; dimension++) {
+				const Dimension d = dimension == 0 ? Dimension::x : Dimension::y;
+				const double f = p->getEquationParameter(d, EquationParameter::frequency);
+				const double damping = p->getEquationParameter(d, EquationParameter::dumping);
+				const double phase = p->getEquationParameter(d, EquationParameter::phase);
+
+				stiffness.push_back(f * f + damping * damping);
+				dumping.push_back(damping);
+				swing.push_back(settings.swingAngle);
+				inverseSwing.push_back(settings.swingAngle > 0 ? 1 / settings.swingAngle : 0);
+				coupling.push_back(settings.coupling);
+				coordinate.push_back(h * 2 + dimension);
+
+				//x is exp(-dt) cos(ft + p) and y the sine, their value and slope at t = 0
+				if (dimension == 0) {
+					initialPosition.push_back(cos(phase));
+					initialVelocity.push_back(-damping * cos(phase) - f * sin(phase));
+				}
+				else {
+					initialPosition.push_back(sin(phase));
+					initialVelocity.push_back(-damping * sin(phase) + f * cos(phase));
+				}
+			}
+		}
+	}
+
+	lanesCount = stiffness.size();
+	isCoupled = std::any_of(coupling.begin(), coupling.end(), [](double k) { return k != 0; });
+	for (int lane = 0; lane < lanesCount; lane++) {
+		coordinateLanes[coordinate[lane]]++;
+	}
+	coordinateSums.assign(harmonographsCount * 2, 0);
+	coordinateMeans.assign(harmonographsCount * 2, 0);
+	hasState = false;
+}
+
+void PendulumSimulator::reset(double tStep) {
+	position = initialPosition;
+	velocity = initialVelocity;
+	acceleration.assign(lanesCount, 0);
+	rkPosition.assign(lanesCount, 0);
+	rkVelocity.assign(lanesCount, 0);
+	rkPositionSum.assign(lanesCount, 0);
+	rkVelocitySum.assign(lanesCount, 0);
+
+	double maxFrequency = 0;
+	for (int lane = 0; lane < lanesCount; lane++) {
+		maxFrequency = std::max(maxFrequency, sqrt(stiffness[lane] + coupling[lane]));
+	}
+	substeps = std::max(1, (int)ceil(maxFrequency * tStep / maxPhasePerStep));
+	step = tStep / substeps;
+
+	//half a step of u' = -2d u' is exact as a factor
+	decay.resize(lanesCount);
+	for (int lane = 0; lane < lanesCount; lane++) {
+		decay[lane] = exp(-dumping[lane] * step);
+	}
+
+	computeAcceleration(position.data(), acceleration.data());
+
+	released = 0;
+	sampleStep = tStep;
+	sampleIndex = 0;
+	hasState = true;
+
+	diagnostics = SimulationDiagnostics();
+	diagnostics.initialEnergy = computeEnergy();
+}
+
+void PendulumSimulator::sample(double tStart, double tStep, int count, float* xs, float* ys) {
+	const bool isContinued = hasState && tStep == sampleStep && std::abs(sampleIndex * tStep - tStart) < tStep * 1e-3;
+	if (!isContinued) {
+		reset(tStep);
+		const long long skipped = (long long)floor(tStart / tStep + 0.5);
+		for (long long i = 0; i < skipped; i++) {
+			advanceSample();
+		}
+	}
+
+	if (integrator == Integrators::rungeKutta4 && harmonographsCount == 1) {
+		switch (lanesCount / 2) {
+		case 1: sampleRungeKuttaFixed<1>(count, xs, ys); return;
+		case 2: sampleRungeKuttaFixed<2>(count, xs, ys); return;
+		case 3: sampleRungeKuttaFixed<3>(count, xs, ys); return;
+		case 4: sampleRungeKuttaFixed<4>(count, xs, ys); return;
+		case 5: sampleRungeKuttaFixed<5>(count, xs, ys); return;
+		case 6: sampleRungeKuttaFixed<6>(count, xs, ys); return;
+		case 7: sampleRungeKuttaFixed<7>(count, xs, ys); return;
+		case 8: sampleRungeKuttaFixed<8>(count, xs, ys); return;
+		default: break;
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		computeCoordinateSums(position.data());
+		xs[i] = coordinateSums[0];
+		ys[i] = coordinateSums[1];
+		advanceSample();
+	}
+	updateDiagnostics();
+}
+
+template<int N>
+void PendulumSimulator::sampleRungeKuttaFixed(int count, float* xs, float* ys) {
+	//the steps of advanceRungeKutta for one harmonograph, whose lanes share swing and coupling;
+	//the state is on the stack and goes back to the members every diagnosticInterval samples
+	//for the energy check
+	const int L = N * 2;
+	const bool isNonlinear = swing[0] > 0;
+
+	for (int blockStart = 0; blockStart < count;) {
+		const int blockEnd = (int)std::min<long long>(count, blockStart + diagnosticInterval - sampleIndex % diagnosticInterval);
+		double u[L], v[L];
+		double blockReleased = 0;
+
+		std::copy(position.begin(), position.end(), u);
+		std::copy(velocity.begin(), velocity.end(), v);
+
+		//the amplitude of a linear swing with this state; wide swings go straight to the full sine,
+		//so they do not pay for a block that would only be thrown away
+		double maxAmplitude = 0;
+		for (int lane = 0; lane < L; lane++) {
+			maxAmplitude = std::max(maxAmplitude, sqrt(u[lane] * u[lane] + v[lane] * v[lane] / stiffness[lane]));
+		}
+		const bool isLikelyInRange = isNonlinear && swing[0] * maxAmplitude < 0.9 * FastMath::maxInRangeArgument;
+		const bool isInRange = isLikelyInRange &&
+			advanceRungeKuttaFixed<N, true>(blockEnd - blockStart, u, v, xs + blockStart, ys + blockStart, blockReleased);
+
+		//a swing left the range of the unreduced sine, the block starts over with the full one
+		if (!isInRange) {
+			blockReleased = 0;
+			std::copy(position.begin(), position.end(), u);
+			std::copy(velocity.begin(), velocity.end(), v);
+			advanceRungeKuttaFixed<N, false>(blockEnd - blockStart, u, v, xs + blockStart, ys + blockStart, blockReleased);
+		}
+
+		std::copy(u, u + L, position.begin());
+		std::copy(v, v + L, velocity.begin());
+		released += blockReleased;
+		diagnostics.steps += (long long)substeps * (blockEnd - blockStart);
+		sampleIndex += blockEnd - blockStart;
+		blockStart = blockEnd;
+		updateDiagnostics();
+	}
+}
+
+//every lane loop has constant length, so the compiler unrolls it; with isInRange the sine runs
+//without range reduction and false is returned when an argument turns out to need it
+template<int N, bool isInRange>
+bool PendulumSimulator::advanceRungeKuttaFixed(int count, double* u, double* v, float* xs, float* ys, double& blockReleased) {
+	const int L = N * 2;
+	const double inverseN = 1.0 / N;
+	const double a = swing[0];
+	const double inverseA = inverseSwing[0];
+	const double k = coupling[0];
+	const bool isNonlinear = a > 0;
+	const double weights[] = { 1, 2, 2, 1 };
+	const double offsets[] = { 0.5 * step, 0.5 * step, step, 0 };
+	double maxArgument = 0;
+
+	double w2[L], d2[L];
+	for (int lane = 0; lane < L; lane++) {
+		w2[lane] = stiffness[lane];
+		d2[lane] = 2 * dumping[lane];
+	}
+
+	//lanes alternate x and y, the table pulls towards the mean of each
+	auto accelerate = [&](const double* positions, double* accelerations) {
+		double xMean = 0, yMean = 0;
+		for (int p = 0; p < N; p++) {
+			xMean += positions[p * 2];
+			yMean += positions[p * 2 + 1];
+		}
+		xMean *= inverseN;
+		yMean *= inverseN;
+
+#pragma omp simd reduction(max:maxArgument)
+		for (int lane = 0; lane < L; lane++) {
+			const double x = positions[lane];
+			double restoring = x;
+			if (isInRange) {
+				const double argument = a * x;
+				maxArgument = std::max(maxArgument, std::abs(argument));
+				restoring = FastMath::sinInRange<MathAccuracy::precise>(static_cast<float>(argument)) * inverseA;
+			}
+			else if (isNonlinear) {
+				restoring = FastMath::sin<MathAccuracy::precise>(a * x) * inverseA;
+			}
+			accelerations[lane] = -w2[lane] * restoring - k * (x - (lane & 1 ? yMean : xMean));
+		}
+	};
+
+	for (int i = 0; i < count; i++) {
+		double x = 0, y = 0;
+		for (int p = 0; p < N; p++) {
+			x += u[p * 2];
+			y += u[p * 2 + 1];
+		}
+		xs[i] = x;
+		ys[i] = y;
+
+		for (int s = 0; s < substeps; s++) {
+			double stageU[L], stageV[L], sumU[L] = {}, sumV[L] = {}, accelerations[L];
+			double releasedSum = 0;
+			std::copy(u, u + L, stageU);
+			std::copy(v, v + L, stageV);
+
+			for (int stage = 0; stage < 4; stage++) {
+				accelerate(stageU, accelerations);
+
+				double power = 0;
+				for (int lane = 0; lane < L; lane++) {
+					const double du = stageV[lane];
+					const double dv = accelerations[lane] - d2[lane] * stageV[lane];
+					power += d2[lane] * stageV[lane] * stageV[lane];
+
+					sumU[lane] += weights[stage] * du;
+					sumV[lane] += weights[stage] * dv;
+					stageU[lane] = u[lane] + offsets[stage] * du;
+					stageV[lane] = v[lane] + offsets[stage] * dv;
+				}
+				releasedSum += weights[stage] * power;
+			}
+
+			for (int lane = 0; lane < L; lane++) {
+				u[lane] += step / 6 * sumU[lane];
+				v[lane] += step / 6 * sumV[lane];
+			}
+			blockReleased += step / 6 * releasedSum;
+		}
+	}
+	return maxArgument < FastMath::maxInRangeArgument;
+}
+
+void PendulumSimulator::sampleBatch(double tStep, int count, const std::vector<float*>& xs, const std::vector<float*>& ys) {
+	reset(tStep);
+
+	for (int i = 0; i < count; i++) {
+		computeCoordinateSums(position.data());
+		for (int h = 0; h < harmonographsCount; h++) {
+			xs[h][i] = coordinateSums[h * 2];
+			ys[h][i] = coordinateSums[h * 2 + 1];
+		}
+		advanceSample();
+	}
+	updateDiagnostics();
+}
+
+void PendulumSimulator::advanceSample() {
+	for (int s = 0; s < substeps; s++) {
+		if (integrator == Integrators::symplectic) advanceSymplectic();
+		else advanceRungeKutta();
+	}
+	diagnostics.steps += substeps;
+
+	sampleIndex++;
+	if (sampleIndex % diagnosticInterval == 0) updateDiagnostics();
+}
+
+void PendulumSimulator::advanceSymplectic() {
+	const int n = lanesCount;
+	const double halfStep = step / 2;
+	double* u = position.data();
+	double* v = velocity.data();
+	double* a = acceleration.data();
+	const double* k = decay.data();
+	double removed = 0;
+
+	//damp half, kick half, drift, kick half, damp half; the force at the end is kept for the next step
+#pragma omp simd reduction(+:removed)
+	for (int lane = 0; lane < n; lane++) {
+		const double damped = v[lane] * k[lane];
+		removed += (v[lane] * v[lane] - damped * damped) / 2;
+		v[lane] = damped + halfStep * a[lane];
+		u[lane] += step * v[lane];
+	}
+
+	computeAcceleration(u, a);
+
+#pragma omp simd reduction(+:removed)
+	for (int lane = 0; lane < n; lane++) {
+		const double kicked = v[lane] + halfStep * a[lane];
+		const double damped = kicked * k[lane];
+		removed += (kicked * kicked - damped * damped) / 2;
+		v[lane] = damped;
+	}
+
+	released += removed;
+}
+
+void PendulumSimulator::advanceRungeKutta() {
+	const int n = lanesCount;
+	double* u = position.data();
+	double* v = velocity.data();
+	double* a = acceleration.data();
+	double* stageU = rkPosition.data();
+	double* stageV = rkVelocity.data();
+	double* sumU = rkPositionSum.data();
+	double* sumV = rkVelocitySum.data();
+	const double* d = dumping.data();
+
+	//the energy taken out by damping, W' = sum of 2d u'^2, is integrated as one more variable
+	const double weights[] = { 1, 2, 2, 1 };
+	const double offsets[] = { 0.5, 0.5, 1, 0 };
+	double releasedSum = 0;
+
+	std::copy(u, u + n, stageU);
+	std::copy(v, v + n, stageV);
+	std::fill(sumU, sumU + n, 0.0);
+	std::fill(sumV, sumV + n, 0.0);
+
+	for (int stage = 0; stage < 4; stage++) {
+		computeAcceleration(stageU, a);
+
+		const double weight = weights[stage];
+		const double offset = offsets[stage] * step;
+		double power = 0;
+
+#pragma omp simd reduction(+:power)
+		for (int lane = 0; lane < n; lane++) {
+			const double du = stageV[lane];
+			const double dv = a[lane] - 2 * d[lane] * stageV[lane];
+			power += 2 * d[lane] * stageV[lane] * stageV[lane];
+
+			sumU[lane] += weight * du;
+			sumV[lane] += weight * dv;
+			stageU[lane] = u[lane] + offset * du;
+			stageV[lane] = v[lane] + offset * dv;
+		}
+		releasedSum += weight * power;
+	}
+
+#pragma omp simd
+	for (int lane = 0; lane < n; lane++) {
+		u[lane] += step / 6 * sumU[lane];
+		v[lane] += step / 6 * sumV[lane];
+	}
+	released += step / 6 * releasedSum;
+}
+
+void PendulumSimulator::computeCoordinateSums(const double* positions) {
+	double* sums = coordinateSums.data();
+	const int* c = coordinate.data();
+
+	std::fill(sums, sums + harmonographsCount * 2, 0.0);
+	for (int lane = 0; lane < lanesCount; lane++) {
+		sums[c[lane]] += positions[lane];
+	}
+}
+
+void PendulumSimulator::computeAcceleration(const double* positions, double* accelerations) {
+	const int n = lanesCount;
+	const double* w2 = stiffness.data();
+	const double* a = swing.data();
+	const double* inverseA = inverseSwing.data();
+
+#pragma omp simd
+	for (int lane = 0; lane < n; lane++) {
+		const double u = positions[lane];
+		accelerations[lane] = -w2[lane] * (a[lane] > 0 ? FastMath::sin<MathAccuracy::precise>(a[lane] * u) * inverseA[lane] : u);
+	}
+
+	if (!isCoupled) return;
+
+	computeCoordinateSums(positions);
+	for (int i = 0; i < harmonographsCount * 2; i++) {
+		coordinateMeans[i] = coordinateSums[i] / coordinateLanes[i];
+	}
+
+	const double* k = coupling.data();
+	const int* c = coordinate.data();
+	const double* means = coordinateMeans.data();
+
+#pragma omp simd
+	for (int lane = 0; lane < n; lane++) {
+		accelerations[lane] -= k[lane] * (positions[lane] - means[c[lane]]);
+	}
+}
+
+double PendulumSimulator::computeEnergy() {
+	computeCoordinateSums(position.data());
+
+	double energy = 0;
+	for (int lane = 0; lane < lanesCount; lane++) {
+		const double u = position[lane];
+
+		//(1 - cos(a*u)) / a^2 without the cancellation of 1 - cos
+		double potential = u * u / 2;
+		if (swing[lane] > 0) {
+			const double half = sin(swing[lane] * u / 2) * inverseSwing[lane];
+			potential = 2 * half * half;
+		}
+
+		const double mean = coordinateSums[coordinate[lane]] / coordinateLanes[coordinate[lane]];
+		energy += velocity[lane] * velocity[lane] / 2 + stiffness[lane] * potential + coupling[lane] * (u - mean) * (u - mean) / 2;
+	}
+	return energy;
+}
+
+void PendulumSimulator::updateDiagnostics() {
+	if (diagnostics.initialEnergy <= 0) return;
+
+	const double drift = std::abs(computeEnergy() + released - diagnostics.initialEnergy) / diagnostics.initialEnergy;
+	diagnostics.maxRelativeDrift = std::max(diagnostics.maxRelativeDrift, drift);
+	diagnostics.finalRelativeDrift = drift;
+}
@@ -0,0 +1,111 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "PendulumsTableModel.h"
+
+PendulumsTableModel::PendulumsTableModel(HarmonographManager* manager, QObject* parent) : QAbstractTableModel(parent) {
+	this->manager = manager;
+
+	connect(manager, SIGNAL(parameterChanged(int, Dimension, EquationParameter, float)),
+		this, SLOT(pendulumParameterChanged(int, Dimension, EquationParameter, float)));
+	connect(manager, SIGNAL(pendulumsChanged()), this, SLOT(pendulumsChanged()));
+}
+
+int PendulumsTableModel::rowCount(const QModelIndex& parent) const {
+	return parent.isValid() ? 0 : manager->getNumOfPendulums();
+}
+
+int PendulumsTableModel::columnCount(const QModelIndex& parent) const {
+	return parent.isValid() ? 0 : 2 * parametersPerDimension;
+}
+
+QVariant PendulumsTableModel::data(const QModelIndex& index, int role) const {
+	if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole)) return QVariant();
+
+	return manager->getEquationParameter(index.row(), columnDimension(index.column()), columnParameter(index.column()));
+}
+
+bool PendulumsTableModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+	if (!index.isValid() || role != Qt::EditRole) return false;
+
+	bool isNumber = false;
+	const float number = value.toFloat(&isNumber);
+	if (!isNumber) return false;
+
+	//an edited cell is a single change, not a drag
+	manager->setEquationParameter(index.row(), columnDimension(index.column()), columnParameter(index.column()), number);
+	manager->finishInteraction();
+	return true;
+}
+
+QVariant PendulumsTableModel::headerData(int section, Qt::Orientation orientation, int role) const {
+	if (role != Qt::DisplayRole) return QVariant();
+
+	if (orientation == Qt::Vertical) return section + 1;
+
+	const QString dimension = columnDimension(section) == Dimension::x ? "X" : "Y";
+
+	switch (columnParameter(section)) {
+	case EquationParameter::dumping:
+		return dimension + " damping";
+	case EquationParameter::frequency:
+		return dimension + " frequency";
+	case EquationParameter::phase:
+		return dimension + " phase";
+	default:
+		return QVariant();
+	}
+}
+
+Qt::ItemFlags PendulumsTableModel::flags(const QModelIndex& index) const {
+	return QAbstractTableModel::flags(index) | Qt::ItemIsEditable;
+}
+
+Dimension PendulumsTableModel::columnDimension(int column) const {
+	return column < parametersPerDimension ? Dimension::x : Dimension::y;
+}
+
+EquationParameter PendulumsTableModel::columnParameter(int column) const {
+	switch (column % parametersPerDimension) {
+	case 0:
+		return EquationParameter::dumping;
+	case 1:
+		return EquationParameter::frequency;
+	default:
+		return EquationParameter::phase;
+	}
+}
+
+void PendulumsTableModel::pendulumParameterChanged(int pendulumNum, Dimension dimension, EquationParameter parameter, float value) {
+	if (dimension == Dimension::z) return;
+
+	for (int column = 0; column < 2 * parametersPerDimension; column++) {
+		if (columnDimension(column) == dimension && columnParameter(column) == parameter) {
+			const QModelIndex changed = index(pendulumNum, column);
+			emit dataChanged(changed, changed, { Qt::DisplayRole, Qt::EditRole });
+		}
+	}
+}
+
+void PendulumsTableModel::pendulumsChanged() {
+	beginResetModel();
+	endResetModel();
+}
@@ -0,0 +1,235 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "PngEncoder.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+static void appendUInt32(std::vector<unsigned char>& out, unsigned long value) {
+	out.push_back((value >> 24) & 0xFF);
+	out.push_back((value >> 16) & 0xFF);
+	out.push_back((value >> 8) & 0xFF);
+	out.push_back(value & 0xFF);
+}
+
+//filter types: 0 none, 1 sub, 2 up, 3 average, 4 paeth
+static int predictByte(int filter, int a, int b, int c) {
+	switch (filter) {
+	case 1:
+		return a;
+	case 2:
+		return b;
+	case 3:
+		return (a + b) / 2;
+	case 4: {
+		const int p = a + b - c;
+		const int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+		if (pa <= pb && pa <= pc) return a;
+		return pb <= pc ? b : c;
+	}
+	default:
+		return 0;
+	}
+}
+
+bool PngEncoder::encode(const unsigned char* rgba, int width, int height, int stride, int compressionLevel, std::vector<unsigned char>& png) {
+	if (width <= 0 || height <= 0) return false;
+	compressionLevel = std::max(0, std::min(9, compressionLevel));
+
+	const int rowsPerBlock = std::max(1, blockSize / (width * 4 + 1));
+
+	std::vector<Block> blocks;
+	for (int row = 0; row < height; row += rowsPerBlock) {
+		Block block;
+		block.firstRow = row;
+		block.rowsCount = std::min(rowsPerBlock, height - row);
+		blocks.push_back(block);
+	}
+
+	const int blocksCount = blocks.size();
+	const int threadsCount = std::max(1, std::min<int>(std::thread::hardware_concurrency(), blocksCount));
+
+	auto worker = [&](int threadIndex) {
+		for (int i = threadIndex; i < blocksCount; i += threadsCount) {
+			compressBlock(rgba, width, stride, compressionLevel, i == blocksCount - 1, blocks[i]);
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threadsCount; i++) {
+		workers.emplace_back(worker, i);
+	}
+	worker(0);
+	for (std::thread& t : workers) {
+		t.join();
+	}
+
+	png.clear();
+	const unsigned char signature[] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	png.insert(png.end(), signature, signature + sizeof(signature));
+
+	std::vector<unsigned char> header;
+	appendUInt32(header, width);
+	appendUInt32(header, height);
+	header.push_back(8);	//bit depth
+	header.push_back(6);	//color type RGBA
+	header.push_back(0);	//deflate
+	header.push_back(0);	//adaptive filtering
+	header.push_back(0);	//no interlace
+	appendChunk(png, "IHDR", header.data(), header.size());
+
+	//zlib stream header, FLEVEL is what zlib itself writes for the level
+	const unsigned char zlibLevelFlags[] = { 0x01, 0x01, 0x5E, 0x5E, 0x5E, 0x5E, 0x9C, 0xDA, 0xDA, 0xDA };
+	unsigned long adler = adler32(0L, Z_NULL, 0);
+
+	std::vector<unsigned char> idat;
+	for (int i = 0; i < blocksCount; i++) {
+		Block& block = blocks[i];
+		if (!block.isOk) return false;
+
+		idat.clear();
+		if (i == 0) {
+			idat.push_back(0x78);
+			idat.push_back(zlibLevelFlags[compressionLevel]);
+		}
+		idat.insert(idat.end(), block.data.begin(), block.data.end());
+
+		adler = adler32_combine(adler, block.adler, block.length);
+		if (i == blocksCount - 1) appendUInt32(idat, adler);
+
+		appendChunk(png, "IDAT", idat.data(), idat.size());
+
+		std::vector<unsigned char>().swap(block.data);
+	}
+
+	appendChunk(png, "IEND", nullptr, 0);
+	return true;
+}
+
+void PngEncoder::filterRow(const unsigned char* row, const unsigned char* previousRow, int rowBytes, bool useFilters, unsigned char* out) {
+	const int bpp = 4;
+	int bestFilter = 0;
+
+	if (useFilters) {
+		//pick the filter with the smallest sum of absolute differences, the same heuristic libpng uses
+		long long bestSum = -1;
+
+		for (int filter = 0; filter <= 4; filter++) {
+			long long sum = 0;
+			for (int i = 0; i < rowBytes; i++) {
+				const int a = i >= bpp ? row[i - bpp] : 0;
+				const int b = previousRow != nullptr ? previousRow[i] : 0;
+				const int c = (i >= bpp && previousRow != nullptr) ? previousRow[i - bpp] : 0;
+
+				sum += abs(static_cast<signed char>(row[i] - predictByte(filter, a, b, c)));
+			}
+
+			if (bestSum < 0 || sum < bestSum) {
+				bestSum = sum;
+				bestFilter = filter;
+			}
+		}
+	}
+
+	out[0] = bestFilter;
+	for (int i = 0; i < rowBytes; i++) {
+		const int a = i >= bpp ? row[i - bpp] : 0;
+		const int b = previousRow != nullptr ? previousRow[i] : 0;
+		const int c = (i >= bpp && previousRow != nullptr) ? previousRow[i - bpp] : 0;
+
+		out[i + 1] = static_cast<unsigned char>(row[i] - predictByte(bestFilter, a, b, c));
+	}
+}
+
+void PngEncoder::filterRows(const unsigned char* rgba, int width, int stride, int firstRow, int rowsCount, bool useFilters, std::vector<unsigned char>& out) {
+	const int rowBytes = width * 4;
+	out.resize(static_cast<size_t>(rowsCount) * (rowBytes + 1));
+
+	for (int i = 0; i < rowsCount; i++) {
+		const int row = firstRow + i;
+		const unsigned char* previousRow = row > 0 ? rgba + static_cast<size_t>(row - 1) * stride : nullptr;
+
+		filterRow(rgba + static_cast<size_t>(row) * stride, previousRow, rowBytes, useFilters, out.data() + static_cast<size_t>(i) * (rowBytes + 1));
+	}
+}
+
+void PngEncoder::compressBlock(const unsigned char* rgba, int width, int stride, int compressionLevel, bool isLast, Block& block) {
+	const bool useFilters = compressionLevel > 0;
+	const int rowBytes = width * 4 + 1;
+
+	std::vector<unsigned char> filtered;
+	filterRows(rgba, width, stride, block.firstRow, block.rowsCount, useFilters, filtered);
+
+	block.length = filtered.size();
+	block.adler = adler32(adler32(0L, Z_NULL, 0), filtered.data(), filtered.size());
+
+	z_stream stream;
+	memset(&stream, 0, sizeof(stream));
+	if (deflateInit2(&stream, compressionLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) return;
+
+	//prime with the tail of the previous block, filtered again here so blocks stay independent
+	if (block.firstRow > 0 && compressionLevel > 0) {
+		const int dictionaryRows = std::min(block.firstRow, (dictionarySize + rowBytes - 1) / rowBytes);
+
+		std::vector<unsigned char> dictionary;
+		filterRows(rgba, width, stride, block.firstRow - dictionaryRows, dictionaryRows, useFilters, dictionary);
+
+		const size_t dictionaryLength = std::min<size_t>(dictionary.size(), dictionarySize);
+		deflateSetDictionary(&stream, dictionary.data() + dictionary.size() - dictionaryLength, dictionaryLength);
+	}
+
+	block.data.resize(deflateBound(&stream, filtered.size()) + 16);
+
+	stream.next_in = filtered.data();
+	stream.avail_in = filtered.size();
+	stream.next_out = block.data.data();
+	stream.avail_out = block.data.size();
+
+	const int flush = isLast ? Z_FINISH : Z_SYNC_FLUSH;
+	int result = Z_OK;
+	do {
+		if (stream.avail_out == 0) {
+			const size_t used = block.data.size();
+			block.data.resize(used * 2);
+			stream.next_out = block.data.data() + used;
+			stream.avail_out = block.data.size() - used;
+		}
+		result = deflate(&stream, flush);
+	} while (result == Z_OK && (stream.avail_in > 0 || stream.avail_out == 0));
+
+	block.data.resize(block.data.size() - stream.avail_out);
+	block.isOk = isLast ? result == Z_STREAM_END : (result == Z_OK || result == Z_BUF_ERROR);
+
+	deflateEnd(&stream);
+}
+
+void PngEncoder::appendChunk(std::vector<unsigned char>& png, const char* type, const unsigned char* data, unsigned long length) {
+	appendUInt32(png, length);
+
+	const size_t typeStart = png.size();
+	png.insert(png.end(), type, type + 4);
+	if (length > 0) png.insert(png.end(), data, data + length);
+
+	appendUInt32(png, crc32(crc32(0L, Z_NULL, 0), png.data() + typeStart, length + 4));
+}
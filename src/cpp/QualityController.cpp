@@ -0,0 +1,64 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "QualityController.h"
+#include <algorithm>
+
+//level 0 is full quality, level 1 drops only multisampling
+static const float timeStepScales[QualityController::levelsCount] = { 1, 1, 1.5f, 2, 3, 4 };
+
+QualityController::QualityController(int targetFps) {
+	setTargetFps(targetFps);
+}
+
+void QualityController::setTargetFps(int targetFps) {
+	budget = 1000.0 / std::max(1, targetFps);
+}
+
+void QualityController::reset() {
+	averageCost = 0;
+	changeLevel(0);
+}
+
+float QualityController::getTimeStepScale() const {
+	return timeStepScales[level];
+}
+
+void QualityController::addFrameCost(double milliseconds) {
+	averageCost = framesAtLevel == 0 ? milliseconds : averageCost + smoothing * (milliseconds - averageCost);
+	framesAtLevel++;
+
+	if (framesAtLevel >= degradeFrames && averageCost > budget * degradeRatio && level < levelsCount - 1) {
+		changeLevel(level + 1);
+		return;
+	}
+
+	if (framesAtLevel >= settleFrames && level > 0) {
+		//sampling and vertex count grow with the density of samples
+		const double costFactor = level == 1 ? antiAliasingCostFactor : timeStepScales[level] / timeStepScales[level - 1];
+		if (averageCost * costFactor < budget * refineRatio) changeLevel(level - 1);
+	}
+}
+
+void QualityController::changeLevel(int newLevel) {
+	level = newLevel;
+	framesAtLevel = 0;
+}
@@ -0,0 +1,100 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "RenderScheduler.h"
+#include "Tracer.h"
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QRunnable>
+#include <QScreen>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+
+class PrepareFrameTask : public QRunnable {
+public:
+	PrepareFrameTask(RenderClient* client, int samplingThreads) {
+		this->client = client;
+		this->samplingThreads = samplingThreads;
+	}
+
+	void run() override {
+		client->prepareFrame(samplingThreads);
+	}
+
+private:
+	RenderClient* client;
+	int samplingThreads;
+};
+
+RenderScheduler* RenderScheduler::instance() {
+	//owned by the application, so the timer is gone before QCoreApplication is
+	static RenderScheduler* scheduler = new RenderScheduler(QCoreApplication::instance());
+	return scheduler;
+}
+
+RenderScheduler::RenderScheduler(QObject* parent) : QObject(parent) {
+	QScreen* screen = QGuiApplication::primaryScreen();
+	if (screen != nullptr && screen->refreshRate() >= 1) tickRate = qRound(screen->refreshRate());
+
+	tickTimer = new QTimer(this);
+	tickTimer->setTimerType(Qt::PreciseTimer);
+	tickTimer->setInterval(qRound(1000.0 / tickRate));
+	connect(tickTimer, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+void RenderScheduler::addClient(RenderClient* client) {
+	if (std::find(clients.begin(), clients.end(), client) != clients.end()) return;
+
+	clients.push_back(client);
+	if (!tickTimer->isActive()) tickTimer->start();
+}
+
+void RenderScheduler::removeClient(RenderClient* client) {
+	clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
+	if (clients.empty()) tickTimer->stop();
+}
+
+void RenderScheduler::tick() {
+	TraceSpan tickSpan("schedulerTick", "flex");
+	tickIndex++;
+
+	std::vector<RenderClient*> dueClients;
+	for (RenderClient* client : clients) {
+		const int divider = std::max(1, (int)std::lround((double)tickRate / std::max(1, client->getFrameRate())));
+		if (tickIndex % divider != 0) continue;
+		if (client->advanceFrame()) dueClients.push_back(client);
+	}
+	if (dueClients.empty()) return;
+
+	const int samplingThreads = std::max(1, QThread::idealThreadCount() / (int)dueClients.size());
+	pool.setMaxThreadCount(std::max(1, (int)dueClients.size() - 1));
+
+	for (int i = 1; i < dueClients.size(); i++) {
+		pool.start(new PrepareFrameTask(dueClients[i], samplingThreads));
+	}
+	dueClients.front()->prepareFrame(samplingThreads);
+	pool.waitForDone();
+
+	for (RenderClient* client : dueClients) {
+		client->submitFrame();
+	}
+}
@@ -24,6 +24,8 @@ SaveImageDialog::SaveImageDialog(QWidget *parent): QDialog(parent){
 	ui.setupUi(this);
 	saveWidth = 1920;
 	saveHeight = 1080;
+
+	connect(ui.encoderComboBox, SIGNAL(currentIndexChanged(int)), this, SLOT(encoderChanged(int)));
 }
 
 SaveImageDialog::~SaveImageDialog(){
@@ -45,9 +47,44 @@ void SaveImageDialog::accept() {
 
 	transpBack = ui.transpBackCheckBox->checkState() == 2;
 
+	useGpuRenderer = ui.gpuRendererCheckBox->checkState() == 2;
+
 	penWidth = ui.penWidthSpinBox->value();
 
 	borderPercentage = ui.borderPercentageSpinBox->value();
 
+	switch (ui.encoderComboBox->currentIndex()) {
+	case 1:
+		encoder = ImageEncoders::qtPng;
+		break;
+	case 2:
+		encoder = ImageEncoders::ppm;
+		break;
+	case 3:
+		encoder = ImageEncoders::pam;
+		break;
+	case 4:
+		encoder = ImageEncoders::rawRGBA;
+		break;
+	case 5:
+		encoder = ImageEncoders::svg;
+		break;
+	case 6:
+		encoder = ImageEncoders::pdf;
+		break;
+	default:
+		encoder = ImageEncoders::parallelPng;
+		break;
+	}
+
+	compressionLevel = ui.compressionLevelSpinBox->value();
+
 	QDialog::accept();
+}
+
+void SaveImageDialog::encoderChanged(int index) {
+	//only PNG encoders compress
+	ui.compressionLevelSpinBox->setEnabled(index <= 1);
+	//vector formats are not rasterized
+	ui.gpuRendererCheckBox->setEnabled(index <= 4);
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "SimulationDialog.h"
+
+SimulationDialog::SimulationDialog(QWidget* parent) : QDialog(parent)
+{
+	ui.setupUi(this);
+	ui.integratorComboBox->addItem(tr("Symplectic (Verlet)"), static_cast<int>(Integrators::symplectic));
+	ui.integratorComboBox->addItem(tr("Runge-Kutta 4"), static_cast<int>(Integrators::rungeKutta4));
+}
+
+SimulationDialog::~SimulationDialog() {
+}
+
+void SimulationDialog::setValues(HarmonographEngines engine, const SimulationSettings& settings) {
+	ui.simulatedCheckBox->setChecked(engine == HarmonographEngines::simulated);
+	ui.integratorComboBox->setCurrentIndex(ui.integratorComboBox->findData(static_cast<int>(settings.integrator)));
+	ui.swingAngleDoubleSpinBox->setValue(settings.swingAngle);
+	ui.couplingDoubleSpinBox->setValue(settings.coupling);
+	simulatedCheckBoxClicked(engine == HarmonographEngines::simulated);
+}
+
+void SimulationDialog::accept() {
+	engine = ui.simulatedCheckBox->isChecked() ? HarmonographEngines::simulated : HarmonographEngines::closedForm;
+	settings.integrator = static_cast<Integrators>(ui.integratorComboBox->currentData().toInt());
+	settings.swingAngle = ui.swingAngleDoubleSpinBox->value();
+	settings.coupling = ui.couplingDoubleSpinBox->value();
+
+	QDialog::accept();
+}
+
+void SimulationDialog::simulatedCheckBoxClicked(bool checked) {
+	ui.integratorComboBox->setEnabled(checked);
+	ui.swingAngleDoubleSpinBox->setEnabled(checked);
+	ui.couplingDoubleSpinBox->setEnabled(checked);
+}
@@ -0,0 +1,71 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "SoakTest.h"
+#include "AllocationTracker.h"
+#include <algorithm>
+#include <cstdio>
+
+SoakTest::SoakTest(HarmonographApp* app, int minutes, QObject* parent) : QObject(parent) {
+	this->app = app;
+	this->minutes = minutes;
+
+	checkpointTimer = new QTimer(this);
+	checkpointTimer->setInterval(checkpointMs);
+	connect(checkpointTimer, SIGNAL(timeout()), this, SLOT(checkpoint()));
+}
+
+void SoakTest::start() {
+	app->startAutoRotation();
+	app->openFlexWindow(FlexModes::phaseBased, true, 60);
+
+	const int durationMs = minutes * 60 * 1000;
+	QTimer::singleShot(std::min(warmUpMs, durationMs / 5), this, SLOT(warmedUp()));
+	QTimer::singleShot(durationMs, this, SLOT(finish()));
+}
+
+long long SoakTest::getGrowthBytes() {
+	return static_cast<long long>(AllocationTracker::getResidentBytes()) - baselineBytes;
+}
+
+void SoakTest::warmedUp() {
+	baselineBytes = AllocationTracker::getResidentBytes();
+	fprintf(stderr, "soak: baseline resident memory %lld KB\n", baselineBytes / 1024);
+	checkpointTimer->start();
+}
+
+void SoakTest::checkpoint() {
+	fprintf(stderr, "soak: resident memory %+lld KB since baseline\n", getGrowthBytes() / 1024);
+}
+
+void SoakTest::finish() {
+	checkpointTimer->stop();
+
+	const long long growthBytes = getGrowthBytes();
+	const bool isPassed = baselineBytes > 0 && growthBytes <= maxGrowthBytes;
+
+	fprintf(stderr, "%s", AllocationTracker::getReport().c_str());
+	if (baselineBytes == 0) fprintf(stderr, "soak: FAILED, resident memory can not be read on this platform\n");
+	else fprintf(stderr, "soak: %s, resident memory grew by %lld KB (limit %lld KB)\n",
+		isPassed ? "passed" : "FAILED", growthBytes / 1024, maxGrowthBytes / 1024);
+
+	QCoreApplication::exit(isPassed ? 0 : 1);
+}
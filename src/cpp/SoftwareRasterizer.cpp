@@ -0,0 +1,181 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "SoftwareRasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+int SoftwareRasterizer::computeScale(const HarmonographSampler& sampler, int width, int height, float borderPercentage) {
+	float maxX, maxY;
+	computeExtent(sampler, maxX, maxY);
+	return computeScale(maxX, maxY, width, height, borderPercentage);
+}
+
+void SoftwareRasterizer::computeExtent(const HarmonographSampler& sampler, float& maxX, float& maxY) {
+	float const boundsStep = 1e-02;
+
+	const int boundsCount = (int)ceil(maxT / boundsStep);
+	std::vector<float> xs(boundsCount), ys(boundsCount);
+	sampler.sample(0, boundsStep, boundsCount, xs.data(), ys.data());
+
+	maxX = 0;
+	maxY = 0;
+	for (int j = 0; j < boundsCount; j++) {
+		float x = std::abs(xs[j]);
+		float y = std::abs(ys[j]);
+		if (x > maxX) maxX = x;
+		if (y > maxY) maxY = y;
+	}
+}
+
+int SoftwareRasterizer::computeScale(float maxX, float maxY, int width, int height, float borderPercentage) {
+	//an extent of 0 (or NaN) puts no limit on the zoom, instead of dividing by it
+	const float xZoom = maxX > 0 ? (width / 2.0) / maxX : maxScale;
+	const float yZoom = maxY > 0 ? (height / 2.0) / maxY : maxScale;
+
+	int scale = static_cast<int>(std::min({ xZoom, yZoom, static_cast<float>(maxScale) }));
+	scale -= scale * borderPercentage;
+	return scale;
+}
+
+SoftwareRasterizer::SoftwareRasterizer(const RasterSettings& settings) {
+	this->settings = settings;
+	radius = settings.penWidth / 2.0f;
+	//a hairline still has to connect neighbouring pixels when it is not anti-aliased
+	if (!settings.useAntiAliasing) radius = std::max(radius, 0.7071f);
+}
+
+std::uint32_t SoftwareRasterizer::getGradientColor(int index, int stepCount) const {
+	const std::uint32_t first = settings.primaryColor;
+	if (!settings.useTwoColors) return first;
+
+	std::uint32_t color = first & 0xff000000;
+	for (int shift = 0; shift < 24; shift += 8) {
+		const int from = (first >> shift) & 0xff;
+		const int to = (settings.secondColor >> shift) & 0xff;
+		const int channel = from + static_cast<int>((float)(to - from) / stepCount * index);
+		color |= static_cast<std::uint32_t>(std::min(255, std::max(0, channel))) << shift;
+	}
+	return color;
+}
+
+void SoftwareRasterizer::render(const HarmonographSampler& sampler, std::uint32_t* pixels, int stride) {
+	this->pixels = pixels;
+	this->stride = stride;
+	const int width = settings.width, height = settings.height;
+
+	for (int y = 0; y < height; y++) {
+		std::uint32_t* row = reinterpret_cast<std::uint32_t*>(reinterpret_cast<char*>(pixels) + (std::size_t)y * stride);
+		std::fill(row, row + width, settings.backgroundColor);
+	}
+	if (settings.useAntiAliasing) {
+		strokeStamps.assign((std::size_t)width * height, 0);
+		strokeCoverage.assign((std::size_t)width * height, 0);
+	}
+
+	const float scale = computeScale(sampler, width, height, settings.borderPercentage);
+	const float xCenter = width / 2.0f, yCenter = height / 2.0f;
+
+	const bool isLines = settings.drawMode == DrawModes::linesMode;
+	const float tStep = isLines ? linesTimeStep : settings.timeStep;
+	const int samplesCount = (int)ceil(maxT / tStep);
+	//the same gradient length as image exports, so both paths give the same colors
+	const int stepCount = (int)(maxT / tStep) + 10;
+
+	std::vector<float> xs(samplesChunkSize), ys(samplesChunkSize);
+	float xLast = 0, yLast = 0;
+
+	for (int first = 0; first < samplesCount; first += samplesChunkSize) {
+		const int count = std::min(samplesChunkSize, samplesCount - first);
+		sampler.sample(first * (double)tStep, tStep, count, xs.data(), ys.data());
+
+		for (int j = 0; j < count; j++) {
+			const int i = first + j;
+			const float x = xs[j] * scale + xCenter;
+			const float y = -ys[j] * scale + yCenter;
+
+			if (!isLines) drawSegment(x, y, x, y, getGradientColor(i + 1, stepCount), i);
+			else if (i > 0) drawSegment(xLast, yLast, x, y, getGradientColor(i, stepCount), i);
+
+			xLast = x;
+			yLast = y;
+		}
+	}
+
+	strokeStamps = std::vector<std::uint32_t>();
+	strokeCoverage = std::vector<std::uint8_t>();
+}
+
+void SoftwareRasterizer::drawSegment(float x0, float y0, float x1, float y1, std::uint32_t color, std::uint32_t index) {
+	const float reach = radius + 0.5f;
+	const int xMin = std::max(0, (int)floor(std::min(x0, x1) - reach));
+	const int xMax = std::min(settings.width - 1, (int)ceil(std::max(x0, x1) + reach));
+	const int yMin = std::max(0, (int)floor(std::min(y0, y1) - reach));
+	const int yMax = std::min(settings.height - 1, (int)ceil(std::max(y0, y1) + reach));
+
+	const float dx = x1 - x0, dy = y1 - y0;
+	const float lengthSquared = dx * dx + dy * dy;
+	const float inverseLength = lengthSquared > 0 ? 1 / lengthSquared : 0;
+
+	for (int py = yMin; py <= yMax; py++) {
+		for (int px = xMin; px <= xMax; px++) {
+			//distance from the pixel center to the closest point of the segment
+			const float cx = px + 0.5f - x0, cy = py + 0.5f - y0;
+			const float along = std::min(1.0f, std::max(0.0f, (cx * dx + cy * dy) * inverseLength));
+			const float ex = cx - along * dx, ey = cy - along * dy;
+			const float distance = sqrt(ex * ex + ey * ey);
+
+			if (settings.useAntiAliasing) {
+				const float coverage = std::min(1.0f, radius + 0.5f - distance);
+				if (coverage > 0) blendPixel(px, py, (int)(coverage * 255 + 0.5f), color, index);
+			}
+			else if (distance <= radius) {
+				pixels[(std::size_t)py * (stride / 4) + px] = color;
+			}
+		}
+	}
+}
+
+void SoftwareRasterizer::blendPixel(int x, int y, int coverage, std::uint32_t color, std::uint32_t index) {
+	const std::size_t strokeIndex = (std::size_t)y * settings.width + x;
+	const std::uint32_t stamp = strokeStamps[strokeIndex];
+	int alpha = coverage;
+
+	if (stamp != 0 && index + 1 - stamp <= strokeGap) {
+		//1 - (1 - previous) * (1 - alpha) = coverage, so the stroke as a whole covers the pixel once
+		const int previous = strokeCoverage[strokeIndex];
+		strokeStamps[strokeIndex] = index + 1;
+		if (coverage <= previous) return;
+		alpha = previous == 255 ? 255 : (coverage - previous) * 255 / (255 - previous);
+	}
+	strokeStamps[strokeIndex] = index + 1;
+	strokeCoverage[strokeIndex] = static_cast<std::uint8_t>(coverage);
+	if (alpha == 0) return;
+
+	std::uint32_t& pixel = pixels[(std::size_t)y * (stride / 4) + x];
+	std::uint32_t blended = 0;
+	for (int shift = 0; shift < 32; shift += 8) {
+		const int destination = (pixel >> shift) & 0xff;
+		const int source = (color >> shift) & 0xff;
+		blended |= static_cast<std::uint32_t>(destination + ((source - destination) * alpha + 127) / 255) << shift;
+	}
+	pixel = blended;
+}
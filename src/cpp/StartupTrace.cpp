@@ -0,0 +1,51 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "StartupTrace.h"
+#include <cstdio>
+
+bool StartupTrace::isEnabled = false;
+QElapsedTimer StartupTrace::timer;
+qint64 StartupTrace::lastMark = 0;
+
+void StartupTrace::start(bool isEnabled) {
+	StartupTrace::isEnabled = isEnabled;
+	if (isEnabled) {
+		timer.start();
+		lastMark = 0;
+	}
+}
+
+void StartupTrace::mark(const char* phase) {
+	if (!isEnabled) return;
+
+	const qint64 now = timer.nsecsElapsed();
+	fprintf(stderr, "startup: %-28s %8.2f ms  (total %8.2f ms)\n", phase, (now - lastMark) / 1e6, now / 1e6);
+	fflush(stderr);
+	lastMark = now;
+}
+
+void StartupTrace::firstFrame() {
+	if (!isEnabled) return;
+
+	mark("first frame");
+	isEnabled = false;
+}
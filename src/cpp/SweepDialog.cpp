@@ -0,0 +1,46 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "SweepDialog.h"
+
+SweepDialog::SweepDialog(QWidget* parent) : QDialog(parent)
+{
+	ui.setupUi(this);
+}
+
+SweepDialog::~SweepDialog() {
+}
+
+void SweepDialog::accept() {
+	columns.parameter = static_cast<SweepParameters>(ui.columnsParameterComboBox->currentIndex());
+	columns.from = ui.columnsFromSpinBox->value();
+	columns.to = ui.columnsToSpinBox->value();
+	columns.steps = ui.columnsStepsSpinBox->value();
+
+	rows.parameter = static_cast<SweepParameters>(ui.rowsParameterComboBox->currentIndex());
+	rows.from = ui.rowsFromSpinBox->value();
+	rows.to = ui.rowsToSpinBox->value();
+	rows.steps = ui.rowsStepsSpinBox->value();
+
+	cellSize = ui.cellSizeSpinBox->value();
+
+	QDialog::accept();
+}
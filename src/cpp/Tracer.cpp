@@ -0,0 +1,134 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+class ThreadTraceBuffer {
+public:
+	int threadId;
+	std::atomic<std::uint64_t> written;
+	std::vector<TraceEvent> events;
+
+	ThreadTraceBuffer(int threadId) : threadId(threadId), written(0), events(Tracer::ringCapacity) {
+	}
+};
+
+//buffers are never freed, a thread that has exited still has spans to write
+static std::mutex buffersMutex;
+static std::vector<ThreadTraceBuffer*> buffers;
+static thread_local ThreadTraceBuffer* threadBuffer = nullptr;
+static const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+std::atomic<bool> Tracer::enabled(false);
+std::atomic<bool> Tracer::isFlushRequested(false);
+std::string Tracer::filePath;
+
+void Tracer::start(const std::string& filePath) {
+	Tracer::filePath = filePath;
+	enabled.store(true);
+
+	std::atexit(flushAtExit);
+#ifdef SIGUSR1
+	std::signal(SIGUSR1, requestFlush);
+#endif
+}
+
+std::int64_t Tracer::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+}
+
+void Tracer::record(const char* name, const char* category, std::int64_t start, std::int64_t end) {
+	if (threadBuffer == nullptr) {
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		threadBuffer = new ThreadTraceBuffer(static_cast<int>(buffers.size()) + 1);
+		buffers.push_back(threadBuffer);
+	}
+
+	//single writer per ring: fill the slot, then publish it with the counter
+	const std::uint64_t index = threadBuffer->written.load(std::memory_order_relaxed);
+	TraceEvent& event = threadBuffer->events[index % ringCapacity];
+	event.name = name;
+	event.category = category;
+	event.start = start;
+	event.duration = end - start;
+	threadBuffer->written.store(index + 1, std::memory_order_release);
+
+	//a signal handler may not do I/O, the next finished span writes the file instead
+	if (isFlushRequested.load(std::memory_order_relaxed) && isFlushRequested.exchange(false)) flush();
+}
+
+bool Tracer::flush() {
+	static std::mutex flushMutex;
+	std::lock_guard<std::mutex> flushLock(flushMutex);
+
+	std::vector<ThreadTraceBuffer*> snapshot;
+	{
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		snapshot = buffers;
+	}
+
+	FILE* file = fopen(filePath.c_str(), "w");
+	if (file == nullptr) return false;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool isFirst = true;
+	std::vector<TraceEvent> events;
+
+	for (ThreadTraceBuffer* buffer : snapshot) {
+		const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+		const std::uint64_t first = written > ringCapacity ? written - ringCapacity : 0;
+
+		events.clear();
+		for (std::uint64_t i = first; i < written; i++) {
+			events.push_back(buffer->events[i % ringCapacity]);
+		}
+
+		//the owner kept recording while we copied, slots it reached again may be torn, and so may the
+		//slot of event writtenAfter, which it can be writing right now without having published it
+		const std::uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+		const std::uint64_t firstValid = std::max(first, writtenAfter + 1 > ringCapacity ? writtenAfter + 1 - ringCapacity : 0);
+
+		for (std::uint64_t i = firstValid; i < written; i++) {
+			const TraceEvent& event = events[i - first];
+			fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				isFirst ? "" : ",\n", event.name, event.category, buffer->threadId, event.start / 1e3, event.duration / 1e3);
+			isFirst = false;
+		}
+	}
+
+	fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
+
+void Tracer::requestFlush(int) {
+	isFlushRequested.store(true);
+}
+
+void Tracer::flushAtExit() {
+	flush();
+}
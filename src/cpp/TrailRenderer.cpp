@@ -0,0 +1,169 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "TrailRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+bool TrailRenderer::initialize() {
+	initializeOpenGLFunctions();
+
+	//age 0 is the newest vertex, the extra slot at capacity is a copy of slot 0
+	program.addShaderFromSourceCode(QOpenGLShader::Vertex,
+		"#version 130\n"
+		"in vec2 position;\n"
+		"uniform mat4 matrix;\n"
+		"uniform vec2 bounds;\n"
+		"uniform vec3 headColor;\n"
+		"uniform vec3 tailColor;\n"
+		"uniform vec3 backgroundColor;\n"
+		"uniform int head;\n"
+		"uniform int capacity;\n"
+		"uniform float size;\n"
+		"out vec3 color;\n"
+		"void main() {\n"
+		"	int slot = gl_VertexID == capacity ? 0 : gl_VertexID;\n"
+		"	float fade = 1.0 - float((head - 1 - slot + capacity) % capacity) / size;\n"
+		"	gl_Position = matrix * vec4(position * bounds, 0.0, 1.0);\n"
+		"	color = mix(backgroundColor, mix(tailColor, headColor, fade), fade);\n"
+		"}\n");
+	program.addShaderFromSourceCode(QOpenGLShader::Fragment,
+		"#version 130\n"
+		"in vec3 color;\n"
+		"void main() {\n"
+		"	gl_FragColor = vec4(color, 1.0);\n"
+		"}\n");
+	program.bindAttributeLocation("position", positionLocation);
+	if (!program.link()) return false;
+
+	vertexBuffer.create();
+	vertexBuffer.setUsagePattern(QOpenGLBuffer::DynamicDraw);
+	return true;
+}
+
+void TrailRenderer::reset(int capacity, float xBound, float yBound) {
+	this->capacity = capacity;
+	this->xBound = xBound;
+	this->yBound = yBound;
+	head = 0;
+	size = 0;
+	ringXs.assign(capacity, 0);
+	ringYs.assign(capacity, 0);
+
+	vertexBuffer.bind();
+	vertexBuffer.allocate((capacity + 1) * sizeof(PackedVertex));
+	vertexBuffer.release();
+}
+
+void TrailRenderer::append(const float* xs, const float* ys, int count) {
+	if (capacity == 0 || count <= 0) return;
+
+	//more than the ring holds would only be overwritten
+	if (count > capacity) {
+		xs += count - capacity;
+		ys += count - capacity;
+		count = capacity;
+	}
+
+	const int firstPart = std::min(count, capacity - head);
+	std::copy(xs, xs + firstPart, ringXs.begin() + head);
+	std::copy(ys, ys + firstPart, ringYs.begin() + head);
+	std::copy(xs + firstPart, xs + count, ringXs.begin());
+	std::copy(ys + firstPart, ys + count, ringYs.begin());
+
+	float xMax = 0, yMax = 0;
+	for (int i = 0; i < count; i++) {
+		xMax = std::max(xMax, std::abs(xs[i]));
+		yMax = std::max(yMax, std::abs(ys[i]));
+	}
+	const int oldHead = head;
+	head = (head + count) % capacity;
+	size = std::min(capacity, size + count);
+
+	//packing against a bound the samples left would clamp the trail to its edge; the headroom
+	//keeps a slowly growing swing from repacking every frame
+	if (xMax > xBound || yMax > yBound) {
+		xBound = std::max(xBound, xMax * 1.25f);
+		yBound = std::max(yBound, yMax * 1.25f);
+		repack();
+		return;
+	}
+
+	vertices.resize(count);
+	VertexPacker::pack(xs, ys, count, xBound, yBound, vertices.data());
+
+	vertexBuffer.bind();
+	write(oldHead, vertices.data(), firstPart);
+	if (firstPart < count) write(0, vertices.data() + firstPart, count - firstPart);
+	vertexBuffer.release();
+}
+
+void TrailRenderer::repack() {
+	vertices.resize(capacity);
+	VertexPacker::pack(ringXs.data(), ringYs.data(), capacity, xBound, yBound, vertices.data());
+
+	vertexBuffer.bind();
+	write(0, vertices.data(), capacity);
+	vertexBuffer.release();
+}
+
+void TrailRenderer::write(int slot, const PackedVertex* data, int count) {
+	vertexBuffer.write(slot * sizeof(PackedVertex), data, count * sizeof(PackedVertex));
+	if (slot == 0) vertexBuffer.write(capacity * sizeof(PackedVertex), data, sizeof(PackedVertex));
+}
+
+void TrailRenderer::draw(const QMatrix4x4& matrix, const DrawParameters& parameters) {
+	if (size < 2) return;
+
+	const QColor& tail = parameters.useTwoColors ? parameters.secondColor : parameters.primaryColor;
+
+	glLineWidth(parameters.penWidth);
+	//not part of the ES function set, desktop GL 1.0 entry point
+	::glPointSize(parameters.penWidth);
+
+	program.bind();
+	program.setUniformValue("matrix", matrix);
+	program.setUniformValue("bounds", QVector2D(xBound, yBound));
+	program.setUniformValue("headColor", QVector3D(parameters.primaryColor.redF(), parameters.primaryColor.greenF(), parameters.primaryColor.blueF()));
+	program.setUniformValue("tailColor", QVector3D(tail.redF(), tail.greenF(), tail.blueF()));
+	program.setUniformValue("backgroundColor", QVector3D(parameters.backgroundColor.redF(), parameters.backgroundColor.greenF(), parameters.backgroundColor.blueF()));
+	program.setUniformValue("head", head);
+	program.setUniformValue("capacity", capacity);
+	program.setUniformValue("size", (float)size);
+
+	vertexBuffer.bind();
+	glEnableVertexAttribArray(positionLocation);
+	glVertexAttribPointer(positionLocation, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), nullptr);
+
+	const GLenum mode = parameters.drawMode == DrawModes::pointsMode ? GL_POINTS : GL_LINE_STRIP;
+	if (size < capacity) {
+		glDrawArrays(mode, 0, size);
+	}
+	else {
+		//oldest to the end of the ring, through the copy of slot 0 when the newest part follows
+		glDrawArrays(mode, head, capacity - head + (head > 0 ? 1 : 0));
+		if (head > 0) glDrawArrays(mode, 0, head);
+	}
+
+	glDisableVertexAttribArray(positionLocation);
+	vertexBuffer.release();
+	program.release();
+}
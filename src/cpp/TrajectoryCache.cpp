@@ -0,0 +1,232 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "TrajectoryCache.h"
+#include <cstring>
+
+static const quint32 diskMagic = 0x48544A43; //"HTJC"
+
+class DiskEntryHeader {
+public:
+	quint32 magic;
+	qint32 count;
+	quint64 key;
+};
+
+static void hashBytes(std::uint64_t& hash, const void* data, size_t size) {
+	//FNV-1a
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ull;
+	}
+}
+
+static void hashFloat(std::uint64_t& hash, float value) {
+	//+0 and -0 sample the same curve
+	if (value == 0) value = 0;
+	hashBytes(hash, &value, sizeof(value));
+}
+
+TrajectoryCache::TrajectoryCache(long long memoryLimitBytes) {
+	this->memoryLimitBytes = memoryLimitBytes;
+}
+
+std::uint64_t TrajectoryCache::computeKey(Harmonograph* harmonograph, double tStart, double tStep, int count) {
+	std::uint64_t hash = 0xCBF29CE484222325ull;
+	const Dimension dimensions[] = { Dimension::x, Dimension::y };
+	const EquationParameter parameters[] = { EquationParameter::dumping, EquationParameter::frequency, EquationParameter::phase };
+
+	const int numOfPendulums = harmonograph->getPendulums().size();
+	hashBytes(hash, &numOfPendulums, sizeof(numOfPendulums));
+
+	for (Pendulum* p : harmonograph->getPendulums()) {
+		for (Dimension dimension : dimensions) {
+			for (EquationParameter parameter : parameters) {
+				hashFloat(hash, p->getEquationParameter(dimension, parameter));
+			}
+		}
+	}
+
+	//closed-form keys stay as they were, so caches kept on disk remain valid
+	if (harmonograph->engine == HarmonographEngines::simulated) {
+		const int integrator = static_cast<int>(harmonograph->simulation.integrator);
+		hashBytes(hash, &integrator, sizeof(integrator));
+		hashFloat(hash, harmonograph->simulation.swingAngle);
+		hashFloat(hash, harmonograph->simulation.coupling);
+	}
+
+	hashBytes(hash, &tStart, sizeof(tStart));
+	hashBytes(hash, &tStep, sizeof(tStep));
+	hashBytes(hash, &count, sizeof(count));
+	return hash;
+}
+
+bool TrajectoryCache::lookup(std::uint64_t key, int count, float* xs, float* ys) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto found = index.find(key);
+	if (found != index.end() && found->second->xs.size() == count) {
+		entries.splice(entries.begin(), entries, found->second);
+		std::memcpy(xs, found->second->xs.data(), count * sizeof(float));
+		std::memcpy(ys, found->second->ys.data(), count * sizeof(float));
+		statistics.memoryHits++;
+		return true;
+	}
+
+	if (!diskDirPath.isEmpty() && readFromDisk(key, count, xs, ys)) {
+		insertToMemory(key, count, xs, ys);
+		statistics.diskHits++;
+		return true;
+	}
+
+	statistics.misses++;
+	return false;
+}
+
+bool TrajectoryCache::contains(std::uint64_t key) {
+	std::lock_guard<std::mutex> lock(mutex);
+	return index.count(key) > 0;
+}
+
+void TrajectoryCache::insert(std::uint64_t key, int count, const float* xs, const float* ys, bool isPersistent) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	insertToMemory(key, count, xs, ys);
+	if (isPersistent && !diskDirPath.isEmpty()) writeToDisk(key, count, xs, ys);
+}
+
+void TrajectoryCache::persist(std::uint64_t key) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto found = index.find(key);
+	if (found == index.end() || diskDirPath.isEmpty()) return;
+
+	const Entry& entry = *found->second;
+	writeToDisk(key, entry.xs.size(), entry.xs.data(), entry.ys.data());
+}
+
+void TrajectoryCache::setDiskTier(const QString& dirPath, long long diskLimitBytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	diskDirPath = dirPath;
+	this->diskLimitBytes = diskLimitBytes;
+	if (diskDirPath.isEmpty()) return;
+
+	QDir().mkpath(diskDirPath);
+	statistics.diskBytes = 0;
+	for (const QFileInfo& fileInfo : QDir(diskDirPath).entryInfoList({ "*.traj" }, QDir::Files)) {
+		statistics.diskBytes += fileInfo.size();
+	}
+	trimDisk();
+}
+
+void TrajectoryCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	entries.clear();
+	index.clear();
+	statistics.memoryBytes = 0;
+}
+
+TrajectoryCacheStatistics TrajectoryCache::getStatistics() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return statistics;
+}
+
+void TrajectoryCache::insertToMemory(std::uint64_t key, int count, const float* xs, const float* ys) {
+	const long long entryBytes = 2ll * count * sizeof(float);
+	if (entryBytes > memoryLimitBytes) return;
+
+	auto found = index.find(key);
+	if (found != index.end()) {
+		statistics.memoryBytes -= 2ll * found->second->xs.size() * sizeof(float);
+		entries.erase(found->second);
+		index.erase(found);
+	}
+
+	while (!entries.empty() && statistics.memoryBytes + entryBytes > memoryLimitBytes) {
+		const Entry& last = entries.back();
+		statistics.memoryBytes -= 2ll * last.xs.size() * sizeof(float);
+		index.erase(last.key);
+		entries.pop_back();
+		statistics.evictions++;
+	}
+
+	entries.push_front(Entry{ key, std::vector<float>(xs, xs + count), std::vector<float>(ys, ys + count) });
+	index[key] = entries.begin();
+	statistics.memoryBytes += entryBytes;
+}
+
+bool TrajectoryCache::readFromDisk(std::uint64_t key, int count, float* xs, float* ys) {
+	QFile file(diskFilePath(key));
+	const qint64 expectedSize = sizeof(DiskEntryHeader) + 2ll * count * sizeof(float);
+	if (!file.open(QIODevice::ReadOnly) || file.size() != expectedSize) return false;
+
+	uchar* data = file.map(0, expectedSize);
+	if (data == nullptr) return false;
+
+	DiskEntryHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	const bool isValid = header.magic == diskMagic && header.count == count && header.key == key;
+
+	if (isValid) {
+		std::memcpy(xs, data + sizeof(header), count * sizeof(float));
+		std::memcpy(ys, data + sizeof(header) + count * sizeof(float), count * sizeof(float));
+	}
+
+	file.unmap(data);
+	return isValid;
+}
+
+void TrajectoryCache::writeToDisk(std::uint64_t key, int count, const float* xs, const float* ys) {
+	const QString filePath = diskFilePath(key);
+	if (QFile::exists(filePath)) return;
+
+	//written under a temporary name so a crash never leaves a truncated entry behind
+	QSaveFile file(filePath);
+	if (!file.open(QIODevice::WriteOnly)) return;
+
+	DiskEntryHeader header{ diskMagic, count, key };
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(xs), count * sizeof(float));
+	file.write(reinterpret_cast<const char*>(ys), count * sizeof(float));
+
+	if (file.commit()) {
+		statistics.diskBytes += sizeof(header) + 2ll * count * sizeof(float);
+		trimDisk();
+	}
+}
+
+void TrajectoryCache::trimDisk() {
+	if (statistics.diskBytes <= diskLimitBytes) return;
+
+	//oldest files go first
+	QFileInfoList files = QDir(diskDirPath).entryInfoList({ "*.traj" }, QDir::Files, QDir::Time | QDir::Reversed);
+	for (const QFileInfo& fileInfo : files) {
+		if (statistics.diskBytes <= diskLimitBytes) break;
+		if (QFile::remove(fileInfo.filePath())) statistics.diskBytes -= fileInfo.size();
+	}
+}
+
+QString TrajectoryCache::diskFilePath(std::uint64_t key) {
+	return QDir(diskDirPath).filePath(QString("%1.traj").arg(key, 16, 16, QChar('0')));
+}
@@ -0,0 +1,107 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "TrajectoryRenderer.h"
+
+bool TrajectoryRenderer::initialize() {
+	initializeOpenGLFunctions();
+
+	//gl_VertexID needs GLSL 1.30
+	program.addShaderFromSourceCode(QOpenGLShader::Vertex,
+		"#version 130\n"
+		"in vec2 position;\n"
+		"uniform mat4 matrix;\n"
+		"uniform vec2 bounds;\n"
+		"uniform vec3 primaryColor;\n"
+		"uniform vec3 colorStep;\n"
+		"uniform float colorOffset;\n"
+		"uniform float colorScale;\n"
+		"out vec3 color;\n"
+		"void main() {\n"
+		"	gl_Position = matrix * vec4(position * bounds, 0.0, 1.0);\n"
+		"	color = primaryColor + colorStep * (colorOffset + colorScale * float(gl_VertexID));\n"
+		"}\n");
+	program.addShaderFromSourceCode(QOpenGLShader::Fragment,
+		"#version 130\n"
+		"in vec3 color;\n"
+		"void main() {\n"
+		"	gl_FragColor = vec4(color, 1.0);\n"
+		"}\n");
+	program.bindAttributeLocation("position", positionLocation);
+	if (!program.link()) return false;
+
+	vertexBuffer.create();
+	vertexBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+	return true;
+}
+
+void TrajectoryRenderer::upload(const float* xs, const float* ys, int count, float xBound, float yBound) {
+	this->xBound = xBound;
+	this->yBound = yBound;
+	vertexCount = count;
+
+	vertices.resize(count);
+	VertexPacker::pack(xs, ys, count, xBound, yBound, vertices.data());
+
+	vertexBuffer.bind();
+	vertexBuffer.allocate(vertices.data(), count * sizeof(PackedVertex));
+	vertexBuffer.release();
+}
+
+void TrajectoryRenderer::draw(const QMatrix4x4& matrix, const DrawParameters& parameters, int colorStepCount) {
+	DrawRange range;
+	range.count = vertexCount;
+	drawRanges(matrix, parameters, colorStepCount, std::vector<DrawRange>(1, range), 1);
+}
+
+void TrajectoryRenderer::drawRanges(const QMatrix4x4& matrix, const DrawParameters& parameters, int colorStepCount,
+	const std::vector<DrawRange>& ranges, float colorScale) {
+	QVector3D colorStep(0, 0, 0);
+	if (parameters.useTwoColors) {
+		colorStep = QVector3D(parameters.secondColor.redF() - parameters.primaryColor.redF(),
+			parameters.secondColor.greenF() - parameters.primaryColor.greenF(),
+			parameters.secondColor.blueF() - parameters.primaryColor.blueF()) / colorStepCount;
+	}
+
+	glLineWidth(parameters.penWidth);
+	//not part of the ES function set, desktop GL 1.0 entry point
+	::glPointSize(parameters.penWidth);
+
+	program.bind();
+	program.setUniformValue("matrix", matrix);
+	program.setUniformValue("bounds", QVector2D(xBound, yBound));
+	program.setUniformValue("primaryColor", QVector3D(parameters.primaryColor.redF(), parameters.primaryColor.greenF(), parameters.primaryColor.blueF()));
+	program.setUniformValue("colorStep", colorStep);
+	program.setUniformValue("colorScale", colorScale);
+
+	vertexBuffer.bind();
+	glEnableVertexAttribArray(positionLocation);
+	glVertexAttribPointer(positionLocation, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), nullptr);
+
+	for (const DrawRange& range : ranges) {
+		program.setUniformValue("colorOffset", range.colorOffset);
+		glDrawArrays(parameters.drawMode == DrawModes::pointsMode ? GL_POINTS : GL_LINE_STRIP, range.first, range.count);
+	}
+
+	glDisableVertexAttribArray(positionLocation);
+	vertexBuffer.release();
+	program.release();
+}
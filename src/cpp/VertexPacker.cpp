@@ -0,0 +1,36 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "VertexPacker.h"
+#include <algorithm>
+#include <cmath>
+
+void VertexPacker::pack(const float* xs, const float* ys, int count, float xBound, float yBound, PackedVertex* vertices) {
+	const float xScale = xBound > 0 ? 32767 / xBound : 0;
+	const float yScale = yBound > 0 ? 32767 / yBound : 0;
+
+	#pragma omp simd
+	for (int i = 0; i < count; i++) {
+		//the bound is analytic, clamping only guards against float rounding at the very edge
+		vertices[i].x = static_cast<std::int16_t>(std::lrint(std::min(32767.0f, std::max(-32767.0f, xs[i] * xScale))));
+		vertices[i].y = static_cast<std::int16_t>(std::lrint(std::min(32767.0f, std::max(-32767.0f, ys[i] * yScale))));
+	}
+}
@@ -0,0 +1,150 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#include "ViewportSampler.h"
+#include <algorithm>
+#include <cmath>
+
+void ViewportSampler::load(Harmonograph* harmonograph) {
+	sampler.load(harmonograph);
+	//far from the center the 2e-7 of the fast tiers would already be visible
+	sampler.setAccuracy(MathAccuracy::precise);
+
+	xOscillators.clear();
+	yOscillators.clear();
+	for (Pendulum* p : harmonograph->getPendulums()) {
+		xOscillators.push_back({ p->getEquationParameter(Dimension::x, EquationParameter::dumping),
+			p->getEquationParameter(Dimension::x, EquationParameter::frequency),
+			p->getEquationParameter(Dimension::x, EquationParameter::phase) });
+		yOscillators.push_back({ p->getEquationParameter(Dimension::y, EquationParameter::dumping),
+			p->getEquationParameter(Dimension::y, EquationParameter::frequency),
+			p->getEquationParameter(Dimension::y, EquationParameter::phase) });
+	}
+}
+
+double ViewportSampler::evaluate(const std::vector<Oscillator>& oscillators, double t, bool isCosine) {
+	double c = 0;
+	for (const Oscillator& o : oscillators) {
+		const double angle = o.frequency * t + o.phase;
+		c += exp(-o.dumping * t) * (isCosine ? cos(angle) : sin(angle));
+	}
+	return c;
+}
+
+double ViewportSampler::speedBound(const std::vector<Oscillator>& oscillators, double tStart, double tEnd) {
+	double bound = 0;
+	for (const Oscillator& o : oscillators) {
+		const double envelope = std::max(exp(-o.dumping * tStart), exp(-o.dumping * tEnd));
+		bound += envelope * sqrt(o.dumping * o.dumping + o.frequency * o.frequency);
+	}
+	return bound;
+}
+
+double ViewportSampler::accelerationBound(const std::vector<Oscillator>& oscillators, double t) {
+	double bound = 0;
+	for (const Oscillator& o : oscillators) {
+		bound += exp(-o.dumping * t) * (o.dumping * o.dumping + o.frequency * o.frequency);
+	}
+	return bound;
+}
+
+void ViewportSampler::findVisibleIntervals(const Viewport& viewport) {
+	pending.clear();
+	visible.clear();
+
+	const double coarseLength = maxT / coarseIntervalsCount;
+	for (int i = coarseIntervalsCount - 1; i >= 0; i--) {
+		pending.push_back({ i * coarseLength, (i + 1) * coarseLength });
+	}
+
+	while (!pending.empty()) {
+		const TimeInterval interval = pending.back();
+		pending.pop_back();
+
+		const double middle = (interval.tStart + interval.tEnd) / 2;
+		const double halfLength = (interval.tEnd - interval.tStart) / 2;
+		const double xReach = speedBound(xOscillators, interval.tStart, interval.tEnd) * halfLength;
+		const double yReach = speedBound(yOscillators, interval.tStart, interval.tEnd) * halfLength;
+
+		if (std::abs(evaluate(xOscillators, middle, true) - viewport.centerX) > viewport.halfWidth + xReach) continue;
+		if (std::abs(evaluate(yOscillators, middle, false) - viewport.centerY) > viewport.halfHeight + yReach) continue;
+
+		if (xReach <= viewport.halfWidth && yReach <= viewport.halfHeight) {
+			//intervals come off the stack in time order, neighbours become one run
+			if (!visible.empty() && visible.back().tEnd == interval.tStart) visible.back().tEnd = interval.tEnd;
+			else visible.push_back(interval);
+			continue;
+		}
+
+		pending.push_back({ middle, interval.tEnd });
+		pending.push_back({ interval.tStart, middle });
+	}
+}
+
+void ViewportSampler::sample(const Viewport& viewport, double maxTimeStep, ViewportSamples& samples) {
+	findVisibleIntervals(viewport);
+
+	samples.runs.clear();
+	samples.xBound = samples.yBound = 0;
+	if (visible.empty()) {
+		samples.xs.clear();
+		samples.ys.clear();
+		return;
+	}
+
+	//the curve bends the most at the earliest visible moment
+	const double acceleration = std::max(accelerationBound(xOscillators, visible.front().tStart),
+		accelerationBound(yOscillators, visible.front().tStart));
+	double timeStep = maxTimeStep;
+	if (acceleration > 0) timeStep = std::min(timeStep, sqrt(8 * maxScreenError * viewport.pixelSize / acceleration));
+
+	double visibleLength = 0;
+	for (const TimeInterval& interval : visible) {
+		visibleLength += interval.tEnd - interval.tStart;
+	}
+	const double runsOverhead = 2.0 * visible.size();
+	if (visibleLength / timeStep + runsOverhead > maxSamplesCount) {
+		timeStep = visibleLength / std::max(1.0, maxSamplesCount - runsOverhead);
+	}
+	samples.timeStep = timeStep;
+
+	int total = 0;
+	for (const TimeInterval& interval : visible) {
+		ViewportRun run;
+		run.tStart = interval.tStart;
+		run.first = total;
+		run.count = static_cast<int>(ceil((interval.tEnd - interval.tStart) / timeStep)) + 1;
+		samples.runs.push_back(run);
+		total += run.count;
+	}
+
+	samples.xs.resize(total);
+	samples.ys.resize(total);
+	sampler.setOrigin(viewport.centerX, viewport.centerY);
+	for (const ViewportRun& run : samples.runs) {
+		sampler.sample(run.tStart, timeStep, run.count, samples.xs.data() + run.first, samples.ys.data() + run.first);
+	}
+
+	for (int i = 0; i < total; i++) {
+		samples.xBound = std::max(samples.xBound, std::abs(samples.xs[i]));
+		samples.yBound = std::max(samples.yBound, std::abs(samples.ys[i]));
+	}
+}
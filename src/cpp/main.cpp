@@ -18,13 +18,516 @@
  *
  */
 
+#include "AllocationTracker.h"
+#include "ExportCache.h"
+#include "ExportCanvas.h"
+#include "FastMath.h"
+#include "GpuImageExporter.h"
 #include "HarmonographApp.h"
+#include "HarmonographExplorer.h"
+#include "HarmonographSampler.h"
+#include "HarmonographSaver.h"
+#include "HarmonographSweeper.h"
+#include "MorphRenderer.h"
+#include "MorphWindow.h"
+#include "PendulumSimulator.h"
+#include "SoakTest.h"
+#include "SoftwareRasterizer.h"
+#include "StartupTrace.h"
+#include "Tracer.h"
+#include "VertexPacker.h"
 #include <QtWidgets/QApplication>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static Harmonograph* loadTemplate(const QCommandLineParser& parser)
+{
+    if (!parser.isSet("template")) return new Harmonograph(3);
+
+    HarmonographSaver saver;
+    return saver.loadParametersFromFile(parser.value("template"));
+}
+
+static int runExploration(const QCommandLineParser& parser)
+{
+    ExplorationSettings settings;
+    settings.seed = parser.value("explore-seed").toULongLong();
+
+    bool isCountValid = false, isTopValid = false;
+    settings.candidatesCount = parser.value("explore-count").toLongLong(&isCountValid);
+    const long long topCount = parser.value("explore-top").toLongLong(&isTopValid);
+    if (!isCountValid || settings.candidatesCount <= 0) {
+        fprintf(stderr, "--explore-count must be a positive number, not %s\n", qPrintable(parser.value("explore-count")));
+        return 1;
+    }
+    if (!isTopValid || topCount <= 0) {
+        fprintf(stderr, "--explore-top must be a positive number, not %s\n", qPrintable(parser.value("explore-top")));
+        return 1;
+    }
+    settings.topCount = static_cast<std::size_t>(topCount);
+    settings.outputDirPath = parser.value("explore-dir");
+
+    Harmonograph* templateHarmonograph = loadTemplate(parser);
+    if (templateHarmonograph == nullptr) return 1;
+
+    HarmonographExplorer explorer(templateHarmonograph, settings);
+    return explorer.writeTopCandidates(explorer.explore()) ? 0 : 1;
+}
+
+static int runSweep(const QCommandLineParser& parser)
+{
+    SweepSettings settings;
+    if (!SweepAxis::fromString(parser.value("sweep-columns"), settings.columns)) return 1;
+    if (!SweepAxis::fromString(parser.value("sweep-rows"), settings.rows)) return 1;
+    settings.cellSize = parser.value("sweep-cell").toInt();
+    settings.filename = parser.value("sweep-output");
+
+    Harmonograph* baseHarmonograph = loadTemplate(parser);
+    if (baseHarmonograph == nullptr) return 1;
+
+    HarmonographSweeper sweeper(baseHarmonograph, settings);
+    return sweeper.render() ? 0 : 1;
+}
+
+//"WxH[@border],..." to one target per size, several sizes get the size and border appended to the file name
+static bool parseExportTargets(const QCommandLineParser& parser, std::vector<ExportTarget>& targets)
+{
+    const QStringList sizes = parser.value("export-size").split(",");
+    const QFileInfo file(parser.value("export-image"));
+
+    for (const QString& entry : sizes) {
+        const QStringList sizeAndBorder = entry.split("@");
+        const QStringList size = sizeAndBorder.at(0).split("x");
+        if (size.size() != 2 || sizeAndBorder.size() > 2) return false;
+
+        ExportTarget target;
+        target.width = size.at(0).toInt();
+        target.height = size.at(1).toInt();
+        if (sizeAndBorder.size() == 2) target.borderPercentage = sizeAndBorder.at(1).toInt();
+        if (target.width <= 0 || target.height <= 0) return false;
+
+        //two entries of one size differ only in the border, which then goes into the name too
+        QString name = QString("%1-%2x%3").arg(file.completeBaseName()).arg(target.width).arg(target.height);
+        if (sizeAndBorder.size() == 2) name += QString("-border%1").arg(target.borderPercentage);
+
+        if (sizes.size() == 1) target.filename = file.filePath();
+        else target.filename = file.dir().filePath(QString("%1.%2").arg(name).arg(file.suffix()));
+
+        for (const ExportTarget& other : targets) {
+            if (other.filename != target.filename) continue;
+
+            fprintf(stderr, "%s is listed twice in --export-size\n", qPrintable(entry));
+            return false;
+        }
+        targets.push_back(target);
+    }
+    return true;
+}
+
+static int runExport(const QCommandLineParser& parser)
+{
+    std::vector<ExportTarget> targets;
+    if (!parseExportTargets(parser, targets)) return 1;
+
+    Harmonograph* harmonograph = loadTemplate(parser);
+    if (harmonograph == nullptr) return 1;
+
+    ImageSettings* settings = new ImageSettings();
+    settings->encoder = ImageEncoders::parallelPng;
+    settings->useGpuRenderer = parser.isSet("gpu");
+
+    QElapsedTimer timer;
+    timer.start();
+    HarmonographSaver saver;
+    saver.saveImages(harmonograph, settings, targets);
+    //GPU renders queue their encoding on the global pool, so they are waited for first
+    GpuImageExporter::waitForDone();
+    QThreadPool::globalInstance()->waitForDone();
+    printf("%d image(s) exported in %lld ms\n", (int)targets.size(), timer.elapsed());
+    return 0;
+}
+
+//keyframes from saved parameter files, written as numbered images or played in a window
+static int runMorph(const QCommandLineParser& parser, QWidget*& window)
+{
+    MorphEasings easing;
+    if (!MorphTimeline::easingFromString(parser.value("morph-easing").toStdString(), easing)) {
+        fprintf(stderr, "unknown easing %s\n", qPrintable(parser.value("morph-easing")));
+        return 1;
+    }
+    const QStringList size = parser.value("morph-size").split("x");
+    const int width = size.size() == 2 ? size.at(0).toInt() : 0;
+    const int height = size.size() == 2 ? size.at(1).toInt() : 0;
+    const int framesToNext = parser.value("morph-frames").toInt();
+    if (width <= 0 || height <= 0 || framesToNext <= 0) return 1;
+
+    MorphTimeline timeline;
+    HarmonographSaver saver;
+    for (const QString& filename : parser.value("morph").split(",")) {
+        Harmonograph* harmonograph = saver.loadParametersFromFile(filename);
+        if (harmonograph == nullptr) return 1;
+
+        std::string error;
+        const bool isAdded = timeline.addKeyframe(harmonograph, framesToNext, easing, error);
+        for (Pendulum* p : harmonograph->getPendulums()) {
+            delete p;
+        }
+        delete harmonograph;
+
+        if (!isAdded) {
+            fprintf(stderr, "%s: %s\n", qPrintable(filename), error.c_str());
+            return 1;
+        }
+    }
+    timeline.buildSchedule();
+
+    MorphRenderer* renderer = new MorphRenderer(timeline, DrawParameters(), width, height, 5);
+    if (parser.isSet("morph-output")) {
+        const bool isWritten = renderer->renderToFiles(parser.value("morph-output"));
+        delete renderer;
+        return isWritten ? 0 : 1;
+    }
+
+    window = new MorphWindow(renderer, parser.value("morph-fps").toInt());
+    window->resize(width, height);
+    return 0;
+}
+
+static int runMathAccuracy()
+{
+    //highest frequency point of the main window, ten times the largest random damping and the
+    //full trajectory length
+    const char* accuracyNames[] = { "coarse", "medium", "precise" };
+    bool isWithinTolerance = true;
+
+    for (const FastMathError& error : FastMath::measureAccuracy(61, 0.1, 255)) {
+        const bool isPassed = error.maxError <= error.tolerance;
+        isWithinTolerance = isWithinTolerance && isPassed;
+
+        printf("%s %-8s max error %.3g (tolerance %.0e) at %.6g %s\n", error.function,
+            accuracyNames[static_cast<int>(error.accuracy)], error.maxError, error.tolerance,
+            error.worstArgument, isPassed ? "ok" : "FAILED");
+    }
+    return isWithinTolerance ? 0 : 1;
+}
+
+static int runSimulationReport(const QCommandLineParser& parser)
+{
+    Harmonograph* harmonograph = loadTemplate(parser);
+    if (harmonograph == nullptr) return 1;
+
+    //the time step of image exports over the full trajectory
+    const double tStep = 1e-4;
+    const int count = 2550000;
+    std::vector<float> xs(count), ys(count);
+    const char* integratorNames[] = { "symplectic", "rungeKutta4" };
+
+    for (Integrators integrator : { Integrators::symplectic, Integrators::rungeKutta4 }) {
+        harmonograph->simulation.integrator = integrator;
+
+        PendulumSimulator simulator;
+        simulator.load(harmonograph);
+        QElapsedTimer timer;
+        timer.start();
+        simulator.sample(0, tStep, count, xs.data(), ys.data());
+        const qint64 elapsed = timer.elapsed();
+
+        const SimulationDiagnostics& diagnostics = simulator.getDiagnostics();
+        printf("%-12s %d samples, %lld steps in %lld ms, energy drift max %.3g final %.3g\n",
+            integratorNames[static_cast<int>(integrator)], count, diagnostics.steps, elapsed,
+            diagnostics.maxRelativeDrift, diagnostics.finalRelativeDrift);
+    }
+
+    for (Pendulum* p : harmonograph->getPendulums()) {
+        delete p;
+    }
+    delete harmonograph;
+    return 0;
+}
+
+static int runSamplerBenchmark()
+{
+    //about 2^26 pendulum evaluations per measurement, full exports for small harmonographs
+    const long long work = 1 << 26;
+    const double tStep = 1e-4;
+    const int hardwareThreads = std::max(1, QThread::idealThreadCount());
+
+    std::vector<int> threadCounts;
+    for (int threads = 1; threads < hardwareThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+
+    printf("pendulums threads   ns/sample  ns/pendulum  vs 1 thread  vs scalar\n");
+    for (int numOfPendulums : { 1, 3, 8, 64, 256, 1024 }) {
+        Harmonograph* harmonograph = new Harmonograph(numOfPendulums);
+        const int count = (int)std::min<long long>(2550000, std::max<long long>(1 << 18, work / numOfPendulums));
+        std::vector<float> xs(count), ys(count);
+
+        //one pendulum after the other per sample, as the curve was evaluated before the sampler
+        const int scalarCount = count / 16;
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < scalarCount; i++) {
+            xs[i] = harmonograph->getCoordinateByTime<Dimension::x>(i * tStep);
+            ys[i] = harmonograph->getCoordinateByTime<Dimension::y>(i * tStep);
+        }
+        const double scalarNs = (double)timer.nsecsElapsed() / scalarCount;
+
+        HarmonographSampler sampler(harmonograph);
+        double singleThreadNs = 0;
+        for (int threads : threadCounts) {
+            sampler.setMaxThreads(threads);
+            timer.restart();
+            sampler.sample(0, tStep, count, xs.data(), ys.data());
+            const double sampleNs = (double)timer.nsecsElapsed() / count;
+            if (threads == 1) singleThreadNs = sampleNs;
+
+            printf("%9d %7d %11.2f %12.3f %11.2fx %9.1fx\n", numOfPendulums, threads, sampleNs,
+                sampleNs / numOfPendulums, singleThreadNs / sampleNs, scalarNs / sampleNs);
+        }
+
+        for (Pendulum* p : harmonograph->getPendulums()) {
+            delete p;
+        }
+        delete harmonograph;
+    }
+    return 0;
+}
+
+//draws the curve into an export image in batches of batchSize segments of one color
+static QImage drawExportImage(const HarmonographSampler& sampler, const DrawParameters& parameters, int saveZoom, int batchSize, qint64& elapsedMs)
+{
+    const int samplesChunkSize = 1 << 16;
+    const float tStep = ExportCanvas::getTimeStep(parameters);
+    const int samplesCount = ExportCanvas::getSamplesCount(parameters);
+    std::vector<float> xs(samplesChunkSize), ys(samplesChunkSize);
+
+    QImage image(1920, 1080, QImage::Format_ARGB32);
+    QElapsedTimer timer;
+    timer.start();
+    ExportCanvas canvas(&image, parameters, saveZoom, batchSize);
+    for (int first = 0; first < samplesCount; first += samplesChunkSize) {
+        const int count = std::min(samplesChunkSize, samplesCount - first);
+        sampler.sample(first * (double)tStep, tStep, count, xs.data(), ys.data());
+        canvas.drawSamples(xs.data(), ys.data(), first, count);
+    }
+    canvas.finish();
+    elapsedMs = timer.elapsed();
+    return image;
+}
+
+static int runExportBatchingCheck(const QCommandLineParser& parser)
+{
+    //one drawLines call strokes its segments as one path, so where anti-aliased segments overlap
+    //the edge is blended once instead of once per segment and a few pixels may differ slightly
+    const double minPsnr = 40;
+
+    Harmonograph* harmonograph = loadTemplate(parser);
+    if (harmonograph == nullptr) return 1;
+
+    HarmonographSampler sampler(harmonograph);
+    const int saveZoom = SoftwareRasterizer::computeScale(sampler, 1920, 1080, 0.03f);
+    const char* modeNames[] = { "lines", "points" };
+    bool isEquivalent = true;
+
+    for (DrawModes mode : { DrawModes::linesMode, DrawModes::pointsMode }) {
+        DrawParameters parameters;
+        parameters.drawMode = mode;
+
+        qint64 segmentMs, batchedMs;
+        const QImage reference = drawExportImage(sampler, parameters, saveZoom, 1, segmentMs);
+        const QImage batched = drawExportImage(sampler, parameters, saveZoom, ExportCanvas::maxBatchSize, batchedMs);
+
+        long long differentPixels = 0;
+        int maxDifference = 0;
+        double squaredErrorSum = 0;
+        for (int y = 0; y < reference.height(); y++) {
+            const QRgb* referenceRow = reinterpret_cast<const QRgb*>(reference.constScanLine(y));
+            const QRgb* batchedRow = reinterpret_cast<const QRgb*>(batched.constScanLine(y));
+            for (int x = 0; x < reference.width(); x++) {
+                if (referenceRow[x] == batchedRow[x]) continue;
+
+                differentPixels++;
+                for (int shift = 0; shift < 24; shift += 8) {
+                    const int difference = std::abs((int)((referenceRow[x] >> shift) & 0xff) - (int)((batchedRow[x] >> shift) & 0xff));
+                    maxDifference = std::max(maxDifference, difference);
+                    squaredErrorSum += difference * difference;
+                }
+            }
+        }
+
+        //PSNR over the RGB channels, infinite when both images are the same
+        const double meanSquaredError = squaredErrorSum / (3.0 * reference.width() * reference.height());
+        const double psnr = meanSquaredError > 0 ? 10 * log10(255.0 * 255.0 / meanSquaredError) : INFINITY;
+        const bool isPassed = psnr >= minPsnr;
+        isEquivalent = isEquivalent && isPassed;
+
+        printf("%-6s per segment %lld ms, batched %lld ms (%.1fx), %lld pixels differ, max channel difference %d, PSNR %.1f dB (min %.0f) %s\n",
+            modeNames[static_cast<int>(mode)], segmentMs, batchedMs, (double)segmentMs / std::max<qint64>(1, batchedMs),
+            differentPixels, maxDifference, psnr, minPsnr, isPassed ? "ok" : "FAILED");
+    }
+
+    for (Pendulum* p : harmonograph->getPendulums()) {
+        delete p;
+    }
+    delete harmonograph;
+    return isEquivalent ? 0 : 1;
+}
+
+//packs the preview samples the way the widget uploads them and measures the position error in pixels
+static int runVertexPackingCheck(const QCommandLineParser& parser)
+{
+    Harmonograph* harmonograph = loadTemplate(parser);
+    if (harmonograph == nullptr) return 1;
+
+    const DrawParameters parameters;
+    const int count = static_cast<int>(ceil(255 / parameters.timeStep));
+    std::vector<float> xs(count), ys(count);
+    HarmonographSampler sampler(harmonograph);
+    sampler.sample(0, parameters.timeStep, count, xs.data(), ys.data());
+
+    //the widget bounds a simulated curve by the samples it drew and a closed-form one by the envelopes
+    float xBound = 0, yBound = 0;
+    if (harmonograph->engine == HarmonographEngines::simulated) {
+        for (int i = 0; i < count; i++) {
+            xBound = std::max(xBound, std::abs(xs[i]));
+            yBound = std::max(yBound, std::abs(ys[i]));
+        }
+    }
+    else {
+        xBound = harmonograph->getCoordinateBound(Dimension::x, 0, 255);
+        yBound = harmonograph->getCoordinateBound(Dimension::y, 0, 255);
+    }
+
+    std::vector<PackedVertex> vertices(count);
+    VertexPacker::pack(xs.data(), ys.data(), count, xBound, yBound, vertices.data());
+
+    double maxError = 0;
+    int clampedCount = 0;
+    for (int i = 0; i < count; i++) {
+        const double x = vertices[i].x / 32767.0 * xBound;
+        const double y = vertices[i].y / 32767.0 * yBound;
+        maxError = std::max(maxError, std::max(std::abs(x - xs[i]), std::abs(y - ys[i])));
+        if (std::abs(xs[i]) > xBound || std::abs(ys[i]) > yBound) clampedCount++;
+    }
+
+    printf("%d vertices, %d bytes each instead of %d, bound %.4g x %.4g, %d clamped\n", count,
+        VertexPacker::packedVertexBytes, VertexPacker::unpackedVertexBytes, xBound, yBound, clampedCount);
+
+    //at the largest zoom before deep zoom, where a unit of the curve covers zoom * height / 2 pixels
+    const double maxZoom = 0.75;
+    bool isWithinTolerance = clampedCount == 0;
+    for (int height : { 1080, 2160, 4320 }) {
+        const double pixelError = maxError * maxZoom * height / 2;
+        isWithinTolerance = isWithinTolerance && pixelError < 0.5;
+        printf("%5dx%-5d max error %.4f px %s\n", height * 16 / 9, height, pixelError, pixelError < 0.5 ? "ok" : "FAILED");
+    }
+
+    for (Pendulum* p : harmonograph->getPendulums()) {
+        delete p;
+    }
+    delete harmonograph;
+    return isWithinTolerance ? 0 : 1;
+}
+
+//registered with atexit, so the application is gone and what is still live has leaked
+static void printMemoryReport()
+{
+    fprintf(stderr, "%s", AllocationTracker::getReport().c_str());
+}
+
+static void printExportCacheReport()
+{
+    fprintf(stderr, "%s", qPrintable(ExportCache::instance().getReport()));
+}
 
 int main(int argc, char *argv[])
 {
+    //the trace has to start before QApplication, so the flag is looked up before the parser runs
+    bool isStartupTraced = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--startup-trace") == 0) isStartupTraced = true;
+    }
+    StartupTrace::start(isStartupTraced);
+
     QApplication a(argc, argv);
+    StartupTrace::mark("application");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOptions({
+        { "explore", "Generate random harmonographs without opening the window and keep the best ones." },
+        { "explore-seed", "Seed of the exploration.", "seed", "0" },
+        { "explore-count", "Number of candidates to generate.", "count", "10000" },
+        { "explore-top", "Number of best candidates to save.", "count", "50" },
+        { "explore-dir", "Folder for the saved parameter files.", "dir", "./Exploration" },
+        { "template", "Parameter file used as the base of exploration or sweep.", "file" },
+        { "sweep", "Render a contact sheet of parameter variations without opening the window." },
+        { "sweep-columns", "Parameter varied across columns as parameter:from:to:steps.", "axis", "firstRatio:1:12:12" },
+        { "sweep-rows", "Parameter varied across rows as parameter:from:to:steps.", "axis", "secondRatio:1:12:12" },
+        { "sweep-cell", "Size of one cell in pixels.", "size", "256" },
+        { "sweep-output", "Contact sheet file, the index is saved next to it as JSON.", "file", "sweep.png" },
+        { "export-image", "Render the template (or a default harmonograph) to a PNG file without opening the window.", "file" },
+        { "export-size", "Size of the exported image, or a comma-separated list of sizes rendered from one sampling pass, each with an optional border in percent.", "WxH[@border],...", "1920x1080" },
+        { "gpu", "Render the export in an OpenGL framebuffer instead of with QPainter." },
+        { "startup-trace", "Print how long every startup phase takes until the first frame is rendered." },
+        { "trajectory-cache", "Folder where sampled trajectories of saved and loaded presets are kept between runs.", "dir" },
+        { "trace", "Record spans of painting, exports, file I/O and flex animation as Chrome trace-event JSON, written at exit and on SIGUSR1.", "file" },
+        { "mem-report", "Count live model objects and images per type and allocation site and print what is left at exit." },
+        { "soak", "Run auto-rotation and a flex window for the given minutes and exit with 1 if resident memory grows.", "minutes" },
+        { "math-accuracy", "Compare the fast exp/sin/cos tiers with the C library and exit with 1 if one is out of tolerance." },
+        { "export-batching-check", "Draw the template (or a default harmonograph) into a 1920x1080 export with one pen change per segment and with color batches, print both times, how many pixels differ and the PSNR, and exit with 1 if it is below 40 dB." },
+        { "vertex-packing-check", "Pack the preview samples of the template (or a default harmonograph) into 16-bit vertices, print the largest position error in pixels at 1080p, 4K and 8K and exit with 1 if it reaches half a pixel." },
+        { "sampler-benchmark", "Time the sampler for 1 to 1024 pendulums on 1 to all hardware threads and print the speedup over one thread and over evaluating one pendulum at a time." },
+        { "simulation-report", "Simulate the template (or a default harmonograph) with both integrators at the export time step and print the time and energy drift." },
+        { "export-cache", "Keep exported images in this folder by a digest of their parameters and link repeated exports instead of rendering them again.", "dir" },
+        { "morph", "Morph between a comma-separated list of saved parameter files with the same number of pendulums and engine.", "files" },
+        { "morph-frames", "Number of frames of every transition.", "count", "60" },
+        { "morph-easing", "Easing of the transitions: linear, easeIn, easeOut or easeInOut.", "easing", "easeInOut" },
+        { "morph-output", "Folder for the numbered frames, without it the morph is played in a window.", "dir" },
+        { "morph-size", "Size of the morph frames.", "WxH", "1280x720" },
+        { "morph-fps", "Frame rate of the morph window.", "fps", "30" },
+        { "control", "Accept line-delimited JSON commands on a local socket and render frames into shared memory for other processes.", "path" },
+    });
+    parser.process(a);
+    if (parser.isSet("trace")) Tracer::start(parser.value("trace").toStdString());
+    StartupTrace::mark("command line");
+
+    AllocationTracker::setEnabled(parser.isSet("mem-report") || parser.isSet("soak"));
+    if (parser.isSet("mem-report")) std::atexit(printMemoryReport);
+    if (parser.isSet("export-cache")) {
+        ExportCache::instance().setDirectory(parser.value("export-cache"));
+        std::atexit(printExportCacheReport);
+    }
+
+    if (parser.isSet("math-accuracy")) return runMathAccuracy();
+    if (parser.isSet("simulation-report")) return runSimulationReport(parser);
+    if (parser.isSet("sampler-benchmark")) return runSamplerBenchmark();
+    if (parser.isSet("export-batching-check")) return runExportBatchingCheck(parser);
+    if (parser.isSet("vertex-packing-check")) return runVertexPackingCheck(parser);
+    if (parser.isSet("explore")) return runExploration(parser);
+    if (parser.isSet("sweep")) return runSweep(parser);
+    if (parser.isSet("export-image")) return runExport(parser);
+    if (parser.isSet("morph")) {
+        QWidget* morphWindow = nullptr;
+        const int result = runMorph(parser, morphWindow);
+        if (morphWindow == nullptr) return result;
+
+        morphWindow->setAttribute(Qt::WA_DeleteOnClose);
+        morphWindow->show();
+        return a.exec();
+    }
+
     HarmonographApp w;
+    if (parser.isSet("trajectory-cache")) w.setTrajectoryCacheDir(parser.value("trajectory-cache"));
+    if (parser.isSet("control") && !w.startControlServer(parser.value("control"))) return 1;
     w.show();
+    StartupTrace::mark("show");
+
+    SoakTest soakTest(&w, parser.value("soak").toInt());
+    if (parser.isSet("soak")) soakTest.start();
     return a.exec();
-}
\ No newline at end of file
+}
@@ -0,0 +1,77 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+
+/*
+ * Live object accounting for --mem-report and --soak. Tracked objects are counted per type
+ * and per allocation site: the outermost AllocationSite on the constructing thread, so the
+ * pendulums copied for an undo entry count as "history" and not as "getPundlumsCopy".
+ * Sizes are shallow, heap buffers owned by an object are not followed. When tracking is off
+ * constructors and destructors only do one relaxed load.
+ */
+class AllocationTracker {
+public:
+	static void setEnabled(bool isEnabled);
+	static bool isEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	//for objects that can not derive from TrackedObject, both return at once when tracking is off
+	static void track(const void* object, const char* type, std::size_t bytes);
+	static void untrack(const void* object);
+
+	static std::string getReport();
+	/*resident set size of the process, 0 where it can not be read*/
+	static std::size_t getResidentBytes();
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+class AllocationSite {
+public:
+	AllocationSite(const char* site);
+	~AllocationSite();
+
+	static const char* getCurrent();
+
+private:
+	bool isOutermost;
+};
+
+/*base of the counted model classes, T names itself with a static allocationType*/
+template<class T>
+class TrackedObject {
+protected:
+	TrackedObject() {
+		if (AllocationTracker::isEnabled()) AllocationTracker::track(this, T::allocationType, sizeof(T));
+	}
+	TrackedObject(const TrackedObject&) : TrackedObject() {
+	}
+	~TrackedObject() {
+		if (AllocationTracker::isEnabled()) AllocationTracker::untrack(this);
+	}
+};
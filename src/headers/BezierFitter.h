@@ -0,0 +1,58 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <vector>
+#include "Harmonograph.h"
+
+class CubicSegment {
+public:
+	float tStart = 0, tEnd = 0;
+	float x0 = 0, y0 = 0;
+	float x1 = 0, y1 = 0;
+	float x2 = 0, y2 = 0;
+	float x3 = 0, y3 = 0;
+};
+
+/*
+ * Approximates the harmonograph curve with cubic Bezier segments for vector output.
+ * Control points come from the analytic first derivative (cubic Hermite interpolation),
+ * and a segment is halved until it deviates from the real curve by less than the tolerance.
+ * Coordinates are mapped to the output as x * scale + xOffset, -y * scale + yOffset.
+ */
+class BezierFitter {
+public:
+	static const int maxDepth = 16;
+
+	BezierFitter(Harmonograph* harmonograph, float scale, float xOffset, float yOffset, float tolerance);
+
+	void fit(float tStart, float tEnd, float initialStep, std::vector<CubicSegment>& segments);
+
+private:
+	Harmonograph* harmonograph;
+	float scale, xOffset, yOffset;
+	float tolerance;
+
+	void fitInterval(float t0, float t1, int depth, std::vector<CubicSegment>& segments);
+	void getPoint(float t, float& x, float& y);
+	void getVelocity(float t, float& dx, float& dy);
+};
@@ -34,9 +34,12 @@ public:
 	QString preferencesDirPath = "./Preferences";
 	QString userTemplatesFileName = "UserTemplates.json";
 	
-	ColorTemplatesDialog(QWidget *parent = Q_NULLPTR);
+	ColorTemplatesDialog(std::vector<NamedColorTemplate*> templates, QWidget *parent = Q_NULLPTR);
 	~ColorTemplatesDialog();
 
+	/*creates the user templates file if needed and reads every template file, safe to call off the GUI thread*/
+	static std::vector<NamedColorTemplate*> loadTemplates(QString preferencesDirPath, QString userTemplatesFileName);
+
 	ColorTemplate pickedTemplate, currentTemplate;
 private:
 	Ui::ColorTemplatesDialog ui;
@@ -46,7 +49,7 @@ private:
 	int selectedRow = 0;
 	long long maxTemplateID = 0;
 
-	void readTemplatesFromFile(QString filename, std::vector<NamedColorTemplate*> & templates);
+	static void readTemplatesFromFile(QString filename, std::vector<NamedColorTemplate*> & templates);
 	void insertNewColorRow(int numOfRow, NamedColorTemplate namedTemplate);
 	void writeTemplatesToFile(QString filename, std::vector<NamedColorTemplate*> templates);
 	
@@ -0,0 +1,75 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <vector>
+#include "Harmonograph.h"
+#include "HarmonographSampler.h"
+
+/*
+ * Pen position of the comet-trail animation. The animation time runs at speed curve seconds per
+ * second, and every frame only the samples between the last one and the current time are computed,
+ * so a frame costs as much as the time it advances, never the whole window. The samples wait in
+ * pending until the view has appended them to its ring. At the end of the curve the pen starts
+ * over from t = 0 with an empty trail.
+ */
+class CometTrail {
+public:
+	static constexpr double maxT = 255;
+
+	CometTrail(double timeStep, double windowLength, double speed);
+
+	/*GUI thread*/
+	void addTime(double seconds);
+	void setSpeed(double speed) {
+		this->speed = speed;
+	}
+	double getSpeed() const {
+		return speed;
+	}
+
+	/*may run on a worker thread while the view waits*/
+	void sampleNew(Harmonograph* harmonograph);
+
+	int getCapacity() const {
+		return capacity;
+	}
+	double getTimeStep() const {
+		return timeStep;
+	}
+
+	/*the ring has to be cleared before the pending samples are appended*/
+	bool isRestarted = true;
+	std::vector<float> pendingXs, pendingYs;
+	void clearPending();
+
+private:
+	double timeStep;
+	double speed;
+	int capacity;
+	double targetTime = 0;
+	long long nextIndex = 0;
+	bool isLoaded = false;
+	HarmonographSampler sampler;
+
+	void restart();
+};
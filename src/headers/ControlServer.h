@@ -0,0 +1,91 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonObject>
+#include <QImage>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include "HarmonographManager.h"
+#include "FrameRing.h"
+
+/*
+ * Controls the harmonograph of the main window from other processes. Clients connect to a local
+ * socket (a Unix domain socket, a named pipe on Windows) and send one JSON object per line:
+ *
+ *   {"id": 1, "command": "setParameter", "pendulum": 0, "dimension": "x", "parameter": "frequency", "value": 2.5}
+ *
+ * and get one JSON line back with the same id and "ok". Rendered frames are not sent over the
+ * socket, they are drawn directly into a shared memory FrameRing and only their sequence
+ * number is reported. A subscribed client gets a {"event": "frame"} line for every frame
+ * rendered after a change of the parameters.
+ */
+class ControlServer : public QObject {
+	Q_OBJECT
+
+public:
+	static const int maxLatencies = 1024;
+
+	ControlServer(HarmonographManager* manager, QObject* parent = Q_NULLPTR);
+	~ControlServer();
+
+	bool listen(QString socketPath);
+	QString getErrorString();
+
+signals:
+	/*parameters or colors were changed by a client, the main window has to redraw*/
+	void stateChanged();
+
+private:
+	HarmonographManager* manager;
+	QLocalServer* server;
+	FrameRing frameRing;
+	std::vector<QLocalSocket*> subscribers;
+
+	//samples of the curve are kept between frames to avoid an allocation per frame
+	std::vector<float> xs, ys;
+
+	bool isRenderScheduled = false;
+	std::uint64_t pendingCommandNs = 0;
+	std::deque<double> latencies;
+
+	QJsonObject execute(QLocalSocket* socket, const QJsonObject& request, std::uint64_t receivedNs);
+	QJsonObject executeChange(const QString& command, const QJsonObject& request, bool& isChanged);
+	QJsonObject getState();
+	QJsonObject getStatistics();
+	QJsonObject renderFrame(std::uint64_t commandReceivedNs);
+	void drawFrame(QImage& image);
+	void scheduleRender(std::uint64_t commandReceivedNs);
+	void send(QLocalSocket* socket, const QJsonObject& object);
+
+	static QJsonObject error(const QString& message);
+	static bool parseDimension(const QJsonValue& value, Dimension& dimension);
+	static bool parseParameter(const QJsonValue& value, EquationParameter& parameter);
+
+private slots:
+	void acceptConnection();
+	void readCommands();
+	void removeSubscriber();
+	void renderScheduledFrame();
+};
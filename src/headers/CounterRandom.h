@@ -0,0 +1,79 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+/*
+ * Counter-based random generator: the n-th value of a stream is a pure function of
+ * (seed, stream, n), so every candidate can draw from its own stream on any thread
+ * and the results do not depend on scheduling. Mixing is the SplitMix64 finalizer.
+ */
+class CounterRandom {
+public:
+	CounterRandom(std::uint64_t seed, std::uint64_t stream) {
+		key = mix(seed ^ mix(stream + golden));
+	}
+
+	std::uint64_t generate64() {
+		return mix(key + golden * ++counter);
+	}
+
+	double generateDouble() {
+		return (generate64() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	double bounded(double highest) {
+		return generateDouble() * highest;
+	}
+
+	int bounded(int highest) {
+		return static_cast<int>(((generate64() >> 32) * static_cast<std::uint64_t>(highest)) >> 32);
+	}
+
+	/*a different seed on every call, for generators that do not have to be reproducible*/
+	static std::uint64_t nextSeed() {
+		static std::atomic<std::uint64_t> sequence(initialSeed());
+		return mix(sequence.fetch_add(golden, std::memory_order_relaxed));
+	}
+
+private:
+	static const std::uint64_t golden = 0x9E3779B97F4A7C15ull;
+
+	std::uint64_t key = 0;
+	std::uint64_t counter = 0;
+
+	static std::uint64_t initialSeed() {
+		std::random_device device;
+		const std::uint64_t entropy = (static_cast<std::uint64_t>(device()) << 32) | device();
+		return entropy ^ static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+	}
+
+	static std::uint64_t mix(std::uint64_t z) {
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+};
@@ -20,13 +20,9 @@
 
 #pragma once
 #include <QColor>
+#include "DrawModesEnum.h"
 
 
-enum class DrawModes {
-	linesMode,
-	pointsMode
-};
-
 class DrawParameters{
 public:
 	bool useTwoColors = true;
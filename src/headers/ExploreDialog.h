@@ -0,0 +1,44 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QDialog>
+#include <QFileDialog>
+#include <ui_ExploreDialog.h>
+#include "HarmonographExplorer.h"
+
+class ExploreDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	ExploreDialog(QWidget* parent = Q_NULLPTR);
+	~ExploreDialog();
+
+	ExplorationSettings settings;
+
+private:
+	Ui::ExploreDialog ui;
+private slots:
+	virtual void accept();
+	void browseOutputDir();
+};
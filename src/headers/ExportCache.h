@@ -0,0 +1,90 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtCore>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "Harmonograph.h"
+#include "settings.h"
+
+class ExportCacheStatistics {
+public:
+	long long requests = 0;
+	long long hits = 0;
+	long long coalesced = 0;
+	long long renders = 0;
+	long long failures = 0;
+};
+
+/*
+ * Deduplicates image exports by a digest of everything the output file depends on: the curve
+ * parameters, the draw parameters that reach the export and the image settings except the
+ * file name. Outputs are kept in a directory under their digest and a repeated request gets a
+ * hard link (or a copy across file systems) instead of a render. A request that is identical
+ * to one still rendering is attached to it and gets the file when that render completes,
+ * also when no directory is set.
+ *
+ * Rendered files are linked, not copied, into the directory, so the destination of every
+ * render is removed first: writing over an old output in place would change the cached file.
+ */
+class ExportCache {
+public:
+	static ExportCache& instance();
+
+	/*hex SHA-256 of the canonical description of the export*/
+	static QByteArray computeDigest(Harmonograph* harmonograph, const ImageSettings& settings);
+
+	/*an empty path disables the directory, in-flight requests are coalesced either way*/
+	void setDirectory(const QString& dirPath);
+
+	/*
+	 * Called before an export is rendered. Returns true when the output is already settled
+	 * without rendering; otherwise the caller renders and has to call complete.
+	 */
+	bool acquire(const QByteArray& digest, const ImageSettings& settings);
+	/*isStored false serves the waiting requests but keeps the file out of the directory, for
+	an output that is not what the digest describes*/
+	void complete(const QByteArray& digest, const QString& filename, bool isWritten, bool isStored = true);
+
+	ExportCacheStatistics getStatistics();
+	QString getReport();
+
+private:
+	class InFlightExport {
+	public:
+		bool hasSidecar = false;
+		std::vector<QString> waitingFilenames;
+	};
+
+	QString dirPath;
+	std::map<QByteArray, InFlightExport> inFlight;
+	ExportCacheStatistics statistics;
+	std::mutex mutex;
+
+	ExportCache() = default;
+
+	QString cachedFilePath(const QByteArray& digest);
+	static bool placeFile(const QString& source, const QString& destination, bool hasSidecar);
+	static bool linkFile(const QString& source, const QString& destination);
+};
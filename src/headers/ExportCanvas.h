@@ -0,0 +1,80 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtGui>
+#include <vector>
+#include "DrawParameteres.h"
+
+/*
+ * Draws sampled points of the curve into one export image with QPainter. Samples are passed
+ * in time order, in as many chunks as the caller likes.
+ */
+class ExportCanvas {
+public:
+	static const int maxT = 255;
+	static const int maxBatchSize = 1 << 14;
+
+	/*a batch size of 1 draws every segment with its own pen change, as a reference for the batching*/
+	ExportCanvas(QImage* image, const DrawParameters& parameters, int saveZoom, int batchSize = maxBatchSize);
+	~ExportCanvas();
+
+	static float getTimeStep(const DrawParameters& parameters) {
+		return parameters.drawMode == DrawModes::linesMode ? linesTimeStep : parameters.timeStep;
+	}
+	static int getSamplesCount(const DrawParameters& parameters) {
+		return (int)ceil(maxT / getTimeStep(parameters));
+	}
+	float getTimeStep() const {
+		return getTimeStep(parameters);
+	}
+
+	/*xs[0] is sample number first of the whole curve*/
+	void drawSamples(const float* xs, const float* ys, int first, int count);
+	void finish();
+
+private:
+	static constexpr float linesTimeStep = 1e-04f;
+
+	DrawParameters parameters;
+	QPainter* painter;
+	QPen pen;
+	bool isLines;
+	int saveZoom;
+	int batchSize;
+	float widthAdd, heightAdd;
+	float stepR = 0, stepG = 0, stepB = 0;
+	float xLast = 0, yLast = 0;
+
+	//the 8 bit gradient color changes only every few thousand segments, so consecutive
+	//primitives of one color are drawn with a single pen change and one drawLines/drawPoints call
+	QRgb batchColor = 0;
+	std::vector<QLine> lines;
+	std::vector<QPoint> points;
+
+	QRgb getColor(int i) const {
+		return qRgb(parameters.primaryColor.red() + stepR * i, parameters.primaryColor.green() + stepG * i, parameters.primaryColor.blue() + stepB * i);
+	}
+
+	void drawLinesBatch();
+	void drawPointsBatch();
+};
@@ -0,0 +1,159 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "MathAccuracyEnum.h"
+
+class FastMathError {
+public:
+	const char* function;
+	MathAccuracy accuracy;
+	double tolerance;
+	double maxError;
+	double worstArgument;
+};
+
+/*
+ * exp, sin and cos for the sampler at three accuracy tiers: coarse is within 1e-3, medium
+ * within 1e-5 and precise within float rounding. Arguments are reduced in double so the
+ * large phases of a long trajectory keep their precision, the minimax polynomial on the
+ * reduced argument runs in float. There are no table lookups and the quadrant is chosen with
+ * selects, so loops calling these vectorize. Errors of sin/cos are absolute, of exp relative.
+ */
+class FastMath {
+public:
+	template<MathAccuracy accuracy>
+	static void sinCos(double x, float& s, float& c) {
+		const double k = roundToInteger(x * twoOverPi);
+		const float r = static_cast<float>((x - k * piOverTwoHigh) - k * piOverTwoLow);
+		const int quadrant = static_cast<int>(k) & 3;
+
+		const float sr = sinPolynomial(r, Tier<accuracy>());
+		const float cr = cosPolynomial(r, Tier<accuracy>());
+
+		s = (quadrant & 1) ? cr : sr;
+		c = (quadrant & 1) ? sr : cr;
+		s = (quadrant & 2) ? -s : s;
+		c = ((quadrant + 1) & 2) ? -c : c;
+	}
+
+	template<MathAccuracy accuracy>
+	static float sin(double x) {
+		float s, c;
+		sinCos<accuracy>(x, s, c);
+		return s;
+	}
+
+	template<MathAccuracy accuracy>
+	static float cos(double x) {
+		float s, c;
+		sinCos<accuracy>(x, s, c);
+		return c;
+	}
+
+	//arguments below this need no range reduction, sinInRange gives the same result as sin there
+	static constexpr double maxInRangeArgument = 0.78;
+
+	template<MathAccuracy accuracy>
+	static float sinInRange(float x) {
+		return sinPolynomial(x, Tier<accuracy>());
+	}
+
+	//below exp(-87) the result is flushed to zero
+	template<MathAccuracy accuracy>
+	static float exp(double x) {
+		const double k = roundToInteger(std::min(std::max(x * log2e, -127.0), 127.0));
+		const float r = static_cast<float>(x - k * ln2);
+
+		const std::uint32_t bits = static_cast<std::uint32_t>(static_cast<int>(k) + 127) << 23;
+		float scale;
+		std::memcpy(&scale, &bits, sizeof(scale));
+
+		return expPolynomial(r, Tier<accuracy>()) * scale;
+	}
+
+	static double getTolerance(MathAccuracy accuracy);
+
+	/*compares every function and tier with libm, phases and damping exponents go up to what
+	the sampler meets for the given largest frequency, damping and time*/
+	static std::vector<FastMathError> measureAccuracy(double maxFrequency, double maxDumping, double maxTime);
+
+private:
+	static constexpr double twoOverPi = 0.63661977236758134308;
+	static constexpr double piOverTwoHigh = 1.5707963267341256;
+	static constexpr double piOverTwoLow = 6.077100506506192e-11;
+	static constexpr double log2e = 1.4426950408889634074;
+	static constexpr double ln2 = 0.69314718055994530942;
+
+	static constexpr double roundingShift = 6755399441055744.0;
+
+	template<MathAccuracy accuracy>
+	using Tier = std::integral_constant<MathAccuracy, accuracy>;
+
+	//nearest integer for |x| < 2^31 by pushing the fraction out of the mantissa; unlike floor
+	//this needs no SSE4.1, so the loops still vectorize on baseline x86-64
+	static double roundToInteger(double x) {
+		return (x + roundingShift) - roundingShift;
+	}
+
+	//odd polynomials for sin and even ones for cos on [-pi/4, pi/4]
+	static float sinPolynomial(float r, Tier<MathAccuracy::coarse>) {
+		const float r2 = r * r;
+		return r + r * r2 * -0.16225905f;
+	}
+	static float sinPolynomial(float r, Tier<MathAccuracy::medium>) {
+		const float r2 = r * r;
+		return r + r * r2 * (-0.16662834f + r2 * 0.0081529909f);
+	}
+	static float sinPolynomial(float r, Tier<MathAccuracy::precise>) {
+		const float r2 = r * r;
+		return r + r * r2 * (-0.16666651f + r2 * (0.0083319787f + r2 * -0.00019495635f));
+	}
+	static float cosPolynomial(float r, Tier<MathAccuracy::coarse>) {
+		const float r2 = r * r;
+		return 1 + r2 * (-0.49977630f + r2 * 0.040488924f);
+	}
+	static float cosPolynomial(float r, Tier<MathAccuracy::medium>) {
+		const float r2 = r * r;
+		return 1 + r2 * (-0.49999895f + r2 * (0.041656294f + r2 * -0.0013597822f));
+	}
+	static float cosPolynomial(float r, Tier<MathAccuracy::precise>) {
+		const float r2 = r * r;
+		return 1 + r2 * (-0.5f + r2 * (0.041666623f + r2 * (-0.0013886764f + r2 * 0.000024390449f)));
+	}
+
+	//exp on [-ln2/2, ln2/2]
+	static float expPolynomial(float r, Tier<MathAccuracy::coarse>) {
+		return 1 + r * (1 + r * (0.50412273f + r * 0.16767048f));
+	}
+	static float expPolynomial(float r, Tier<MathAccuracy::medium>) {
+		return 1 + r * (1 + r * (0.49998951f + r * (0.16753885f + r * 0.041921165f)));
+	}
+	static float expPolynomial(float r, Tier<MathAccuracy::precise>) {
+		return 1 + r * (1 + r * (0.5f + r * (0.16666519f + r * (0.041666206f + r * (0.0083688825f + r * 0.0013950479f)))));
+	}
+};
@@ -22,5 +22,6 @@
 
 enum class FlexModes{
 	phaseBased,
-	frequencyBased
+	frequencyBased,
+	cometTrail
 };
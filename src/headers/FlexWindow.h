@@ -30,10 +30,12 @@
 #include <random>
 #include <time.h>
 #include "HarmonographOpenGLWidget.h"
+#include "RenderScheduler.h"
 #include "SaveImageDialog.h"
+#include "ImageEncoder.h"
 #include "settings.h"
 
-class FlexWindow : public QMainWindow
+class FlexWindow : public QMainWindow, public RenderClient
 {
 	Q_OBJECT
 
@@ -42,12 +44,19 @@ public:
 	FlexWindow(FlexSettings* settings, QWidget* parent = Q_NULLPTR);
 	~FlexWindow();
 
+	int getFrameRate() override;
+	bool advanceFrame() override;
+	void prepareFrame(int samplingThreads) override;
+	void submitFrame() override;
+
 protected:
 	virtual void closeEvent(QCloseEvent* event);
 private:
 	Ui::FlexWindow ui;
 	Harmonograph* flexGraph;
-	QTimer* flexTimer;
+	FlexModes flexBaseMode;
+	CometTrail* cometTrail = nullptr;
+	QElapsedTimer trailClock;
 	HarmonographOpenGLWidget* gl;
 	HarmonographManager* manager;
 	QAction* maximizeAction, * incSpeedAction, * decSpeedAction, * pauseAction, * saveImageAction;
@@ -57,6 +66,10 @@ private:
 	float firstFreq = 2;
 	float secondFreq = 2;
 	float flexSpeedChangeFactor = 0.002;
+	//curve seconds per second and shown curve seconds of the comet trail
+	double trailSpeed = 2;
+	double trailWindow = 40;
+	double trailSpeedChangeFactor = 1.25;
 	std::vector<float> xFlexStartValues;
 	std::vector<float> yFlexStartValues;
 	std::vector<float> xSpeedValues;
@@ -69,9 +82,10 @@ private:
 		return fMin + f * (fMax - fMin);
 	}
 
-private slots:
 	void frequencyFlex();
 	void phaseFlex();
+
+private slots:
 	void maximizeWindow();
 	void increaseFlexSpeed();
 	void decreaseFlexSpeed();
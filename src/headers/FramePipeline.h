@@ -0,0 +1,62 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QImage>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+
+/*
+ * Renders numbered frames on several threads in whatever order they finish and hands them
+ * to a sink strictly in order, one at a time. Workers stay at most window frames ahead of the
+ * sink, which bounds the number of images held in memory.
+ */
+class FramePipeline {
+public:
+	typedef std::function<QImage(int frame)> RenderFunction;
+	/*returns false to stop the pipeline*/
+	typedef std::function<bool(int frame, const QImage& image)> SinkFunction;
+
+	/*0 threads uses every hardware thread, a 0 window is twice the threads*/
+	FramePipeline(int framesCount, int threadsCount = 0, int window = 0);
+
+	/*blocks until every frame reached the sink, false when it was cancelled or the sink failed*/
+	bool run(const RenderFunction& render, const SinkFunction& sink);
+	void cancel();
+
+private:
+	int framesCount;
+	int threadsCount;
+	int window;
+
+	std::mutex mutex;
+	std::condition_variable frameEmitted;
+	int nextFrame = 0;
+	int nextEmittedFrame = 0;
+	bool isEmitting = false;
+	bool isCancelled = false;
+	std::map<int, QImage> finishedFrames;
+
+	void work(const RenderFunction& render, const SinkFunction& sink);
+};
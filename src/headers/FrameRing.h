@@ -0,0 +1,115 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Layout of the shared memory for clients: a FrameRingHeader, then slotsCount slots of slotBytes
+ * each, starting at headerBytes. A slot is a FrameSlotHeader followed, at pixelsOffset, by
+ * height rows of stride bytes of premultiplied ARGB32 (BGRA bytes on little-endian machines).
+ *
+ * Frame n (counted from 1) goes to slot (n - 1) % slotsCount. Its sequence is 0 while the frame
+ * is written and n once it is complete; a reader checks that the sequence is still n after
+ * reading the pixels, otherwise the writer has lapped it. Times are CLOCK_MONOTONIC nanoseconds.
+ */
+class FrameRingHeader {
+public:
+	static constexpr char magicValue[8] = { 'H', 'G', 'F', 'R', 'A', 'M', 'E', '1' };
+
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t slotsCount;
+	std::uint32_t width;
+	std::uint32_t height;
+	std::uint32_t stride;
+	std::uint32_t pixelsOffset;
+	std::uint64_t headerBytes;
+	std::uint64_t slotBytes;
+	std::atomic<std::uint64_t> latestSequence;
+};
+
+class FrameSlotHeader {
+public:
+	std::atomic<std::uint64_t> sequence;
+	/*when the command that caused the frame arrived and when the frame was complete*/
+	std::uint64_t commandReceivedNs;
+	std::uint64_t publishedNs;
+};
+
+/*
+ * Writer side of a POSIX shared memory ring of rendered frames (shm_open + mmap). Frames are
+ * drawn directly into the mapped slot, nothing is copied on the way to the readers. The
+ * object is removed again when the ring is closed.
+ *
+ * The name and sizes come from clients of the control socket, so only new objects under
+ * namePrefix are created and the mapping is bounded.
+ */
+class FrameRing {
+public:
+	static const int alignment = 64;
+	static const int maxSize = 16384;
+	static const int maxSlotsCount = 64;
+	static constexpr std::uint64_t maxMappingBytes = 2ull << 30;
+	static constexpr const char* namePrefix = "/harmonograph-";
+
+	~FrameRing();
+
+	bool open(const std::string& name, int slotsCount, int width, int height, std::string& error);
+	void close();
+	bool isOpen() const {
+		return mapping != nullptr;
+	}
+
+	/*pixels of the next slot; the frame is not visible to readers until publishFrame*/
+	unsigned char* beginFrame(std::uint64_t& sequence);
+	void publishFrame(std::uint64_t commandReceivedNs);
+
+	int getWidth() const {
+		return width;
+	}
+	int getHeight() const {
+		return height;
+	}
+	int getStride() const {
+		return stride;
+	}
+	int getSlot(std::uint64_t sequence) const {
+		return static_cast<int>((sequence - 1) % slotsCount);
+	}
+
+	static std::uint64_t nowNs();
+
+private:
+	std::string name;
+	void* mapping = nullptr;
+	std::size_t mappingBytes = 0;
+	int slotsCount = 0, width = 0, height = 0, stride = 0;
+	std::size_t headerBytes = 0, slotBytes = 0, pixelsOffset = 0;
+	std::uint64_t writingSequence = 0;
+
+	FrameRingHeader* getHeader() const;
+	FrameSlotHeader* getSlotHeader(std::uint64_t sequence) const;
+};
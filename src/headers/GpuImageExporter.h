@@ -0,0 +1,59 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtWidgets>
+#include <QOpenGLExtraFunctions>
+#include <functional>
+#include "Harmonograph.h"
+#include "settings.h"
+
+/*
+ * Rasterizes an export on the GPU with the same pipeline as the 2D widget: the curve is drawn
+ * into a multisampled framebuffer object, resolved, and read back through two pixel buffer
+ * objects so the readback of one tile overlaps rendering of the next. Images larger than
+ * GL_MAX_RENDERBUFFER_SIZE are rendered in tiles. A QOffscreenSurface is used, so it works
+ * without a window (for example with QT_QPA_PLATFORM=offscreen on Mesa llvmpipe).
+ * A null image means no OpenGL context was available.
+ *
+ * The surface has to be created and destroyed on the GUI thread, so both functions are called
+ * there. renderAsync then renders on a thread of its own with its own context, so a large
+ * tiled export does not block input; without threaded OpenGL it renders before it returns.
+ */
+class GpuImageExporter {
+public:
+	typedef std::function<void(const QImage& image)> DoneFunction;
+
+	static QImage render(Harmonograph* harmonograph, const ImageSettings& settings);
+	/*done is called on the render thread; the harmonograph has to live until then*/
+	static void renderAsync(Harmonograph* harmonograph, const ImageSettings& settings, const DoneFunction& done);
+	static void waitForDone();
+
+private:
+	friend class GpuRenderTask;
+
+	static const int maxTileSize = 4096;
+
+	static QThreadPool* getThreadPool();
+	static QImage renderOn(QSurface* surface, Harmonograph* harmonograph, const ImageSettings& settings);
+	static QImage renderTiles(QOpenGLExtraFunctions* f, Harmonograph* harmonograph, const ImageSettings& settings);
+};
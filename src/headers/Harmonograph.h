@@ -24,16 +24,23 @@
 #include <vector>
 #include <cmath>
 #include "Dimension.h"
+#include "AllocationTracker.h"
+#include "HarmonographEnginesEnum.h"
+#include "SimulationSettings.h"
 
-class Harmonograph
+class Harmonograph : public TrackedObject<Harmonograph>
 { 
 public:
+	static const char* const allocationType;
+
 	float frequencyPoint = 2;
 	float frequenyNoise = 0.1;
 	bool isStar = false;
 	bool isCircle = false;
 	int firstRatioValue = 1;
 	int secondRatioValue = 1;
+	HarmonographEngines engine = HarmonographEngines::closedForm;
+	SimulationSettings simulation;
 
 	Harmonograph(int numOfPendulums);
 	Harmonograph(Harmonograph* harmonograph);
@@ -42,18 +49,41 @@ public:
 	~Harmonograph();
 
 	float getCoordinateByTime(Dimension demension, float t);
+	float getDerivativeByTime(Dimension dimension, float t);
+
+	template<Dimension dimension>
+	float getCoordinateByTime(float t) {
+		float c = 0;
+
+		for (Pendulum* p : pendlums) {
+			c += p->getCoordinateByTime<dimension>(t);
+		}
+		return c;
+	}
+	template<Dimension dimension>
+	float getDerivativeByTime(float t) {
+		float c = 0;
+
+		for (Pendulum* p : pendlums) {
+			c += p->getDerivativeByTime<dimension>(t);
+		}
+		return c;
+	}
+	/*upper bound of |coordinate| for t in [tStart, tEnd], every pendulum contributes at most its envelope*/
+	float getCoordinateBound(Dimension dimension, float tStart, float tEnd);
 
 	int getNumOfPendulums() {
 		return numOfPendulums;
 	}
 	std::vector<Pendulum*> getPundlumsCopy();
 	void update();
+	void update(CounterRandom& random);
 	void rotateXAxis(float radians);
 	void rotateXY(float x, float y);
 	void setNumOfPendulums(int newNum);
 	void changeFrequencyPointNoUpdate(float newFrequecnyPoint);
 
-	std::vector<Pendulum*> getPendulums() {
+	const std::vector<Pendulum*>& getPendulums() {
 		return pendlums;
 	}
 	
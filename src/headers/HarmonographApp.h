@@ -34,7 +34,15 @@
 #include "FlexWindow.h"
 #include "FlexDialog.h"
 #include "SaveImageDialog.h"
+#include "ExploreDialog.h"
+#include "SweepDialog.h"
+#include "SimulationDialog.h"
+#include "ControlServer.h"
+#include "ImageEncoder.h"
+#include "PendulumsTableModel.h"
 #include "settings.h"
+#include "StartupTrace.h"
+#include <future>
 
 class HarmonographApp : public QMainWindow {
     Q_OBJECT
@@ -43,30 +51,54 @@ public:
     HarmonographApp(QWidget* parent = Q_NULLPTR);
     ~HarmonographApp();
 
+    void setTrajectoryCacheDir(QString dirPath);
+    void startAutoRotation();
+    void openFlexWindow(FlexModes flexBaseMode, bool useAntiAliasing, int fps);
+    bool startControlServer(QString socketPath);
+
 private:
     HarmonographManager* manager;
+    PendulumsTableModel* pendulumsTableModel;
 	
     Ui::HarmonographAppClass ui;
     HarmonographOpenGLWidget* GLWidget2D;
     QTimer* autoRotationTimer;
+    ControlServer* controlServer = nullptr;
 
     QComboBox* drawModesCombo;
     QLabel* penWidthLabel, *drawModeLabel, *timeStepLabel;
+    QLabel* cacheStatisticsLabel, *vertexMemoryLabel;
 
     QDoubleSpinBox* timeSpinBox;
     QSpinBox* penWidthSpinBox;
 
-    FlexDialog* flexDialog = new FlexDialog(this);
-    SaveImageDialog* saveImageDialog = new SaveImageDialog(this);
-    ColorTemplatesDialog* colorTemplatesDialog = new ColorTemplatesDialog(this);
+    //dialogs are created on first use to keep startup short
+    FlexDialog* flexDialog = nullptr;
+    SaveImageDialog* saveImageDialog = nullptr;
+    ExploreDialog* exploreDialog = nullptr;
+    SweepDialog* sweepDialog = nullptr;
+    SimulationDialog* simulationDialog = nullptr;
+    ColorTemplatesDialog* colorTemplatesDialog = nullptr;
+    std::future<std::vector<NamedColorTemplate*>> colorTemplatesFuture;
 
     const QString preferencesDirPath = "./Preferences";
     const QString userTemplatesFileName = "UserTemplates.json";
 
-    void redrawImage();
+    FlexDialog* getFlexDialog();
+    SaveImageDialog* getSaveImageDialog();
+    ColorTemplatesDialog* getColorTemplatesDialog();
+    ExploreDialog* getExploreDialog();
+    SweepDialog* getSweepDialog();
+    SimulationDialog* getSimulationDialog();
+
     void changeParameter(int pendulumNum, EquationParameter parameter, Dimension dimension, int value);
 
+    QSlider* getParameterSlider(int pendulumNum, Dimension dimension, EquationParameter parameter);
+    void setParameterSliderValue(int pendulumNum, Dimension dimension, EquationParameter parameter, float value);
+    void refreshParameterSliders();
+
 private slots:
+    void redrawImage();
     void updateImage();
     void autoRotate();
     void undoUpdate();
@@ -75,6 +107,10 @@ private slots:
     void saveImage();
     void saveParametersToFile();
     void loadParametersFromFile();
+    void explore();
+    void sweep();
+    void changeSimulation();
+    void controlStateChanged();
     void ratioCheckBoxCliked(bool checked);
     void circleCheckBoxClicked(bool checked);
     void useTwoColorsCheckBoxChanged(bool checked);
@@ -113,4 +149,7 @@ private slots:
     void thirdYFrequencyChanged(int value);
 
     void drawModeChanged(int index);
+
+    void pendulumParameterChanged(int pendulumNum, Dimension dimension, EquationParameter parameter, float value);
+    void pendulumsChanged();
 };
\ No newline at end of file
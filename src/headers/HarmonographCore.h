@@ -0,0 +1,124 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+/*
+ * C interface of the Qt-free harmonograph core (core/HarmonographCore.pro): building a curve
+ * from parameters, batch sampling, bounds and rendering into a caller-owned pixel buffer.
+ * Only plain C types cross the boundary, so the library can be loaded from C or through any
+ * FFI, and structs are only ever extended at the end. Functions that can fail return
+ * hg_ok (0) or a negative hg_status.
+ *
+ * A handle may be sampled and rendered from several threads at once, but must not be
+ * changed (hg_set_pendulums, hg_randomize) while it is in use.
+ */
+
+#include <stdint.h>
+
+#if defined(HARMONOGRAPH_CORE_SHARED) && defined(_WIN32)
+#ifdef HARMONOGRAPH_CORE_BUILD
+#define HG_API __declspec(dllexport)
+#else
+#define HG_API __declspec(dllimport)
+#endif
+#elif defined(HARMONOGRAPH_CORE_SHARED)
+#define HG_API __attribute__((visibility("default")))
+#else
+#define HG_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HG_ABI_VERSION 1
+
+enum hg_status {
+	hg_ok = 0,
+	hg_invalid_argument = -1,
+	hg_out_of_memory = -2
+};
+
+enum hg_draw_mode {
+	hg_lines = 0,
+	hg_points = 1
+};
+
+/*
+ * one direction of a pendulum: exp(-damping * t) * cos (x) or sin (y) of frequency * t + phase.
+ * Every pendulum has unit amplitude, as in the application; amplitude is stored and read back
+ * by hg_get_pendulums but does not change hg_sample, hg_bound or hg_render.
+ */
+typedef struct hg_dimension {
+	float amplitude;
+	float frequency;
+	float phase;
+	float damping;
+} hg_dimension;
+
+typedef struct hg_pendulum {
+	hg_dimension x;
+	hg_dimension y;
+} hg_pendulum;
+
+/*colors are 0xAARRGGBB, pixels are written in the same format*/
+typedef struct hg_raster_settings {
+	int width;
+	int height;
+	float border;
+	int draw_mode;
+	int pen_width;
+	int anti_aliasing;
+	float time_step;
+	int use_two_colors;
+	uint32_t primary_color;
+	uint32_t second_color;
+	uint32_t background_color;
+} hg_raster_settings;
+
+typedef struct hg_harmonograph hg_harmonograph;
+
+HG_API int hg_abi_version(void);
+
+/*pendulums are copied, the handle is released with hg_destroy*/
+HG_API hg_harmonograph* hg_create(const hg_pendulum* pendulums, int count);
+/*random pendulums around frequency_point as the window generates them, the same seed gives the same curve*/
+HG_API hg_harmonograph* hg_create_random(int count, float frequency_point, uint64_t seed);
+HG_API void hg_destroy(hg_harmonograph* harmonograph);
+
+HG_API int hg_get_pendulum_count(const hg_harmonograph* harmonograph);
+HG_API int hg_get_pendulums(const hg_harmonograph* harmonograph, hg_pendulum* pendulums, int capacity);
+HG_API int hg_set_pendulums(hg_harmonograph* harmonograph, const hg_pendulum* pendulums, int count);
+HG_API int hg_randomize(hg_harmonograph* harmonograph, float frequency_point, uint64_t seed);
+
+/*count samples at t_start, t_start + t_step, ...*/
+HG_API int hg_sample(const hg_harmonograph* harmonograph, double t_start, double t_step, int count, float* xs, float* ys);
+/*upper bound of |x| (dimension 0) or |y| (dimension 1) for t in [t_start, t_end]*/
+HG_API float hg_bound(const hg_harmonograph* harmonograph, int dimension, float t_start, float t_end);
+
+HG_API void hg_default_raster_settings(hg_raster_settings* settings);
+/*stride is in bytes and at least 4 * width, the buffer holds settings->height rows*/
+HG_API int hg_render(const hg_harmonograph* harmonograph, const hg_raster_settings* settings, uint32_t* pixels, int stride);
+
+#ifdef __cplusplus
+}
+#endif
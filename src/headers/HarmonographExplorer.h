@@ -0,0 +1,88 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtWidgets>
+#include <QRunnable>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Harmonograph.h"
+#include "CounterRandom.h"
+
+class ExplorationScore {
+public:
+	long long candidateIndex = 0;
+	float coverage = 0;
+	float symmetry = 0;
+	float edgeDensity = 0;
+	float total = 0;
+};
+
+class ExplorationSettings {
+public:
+	std::uint64_t seed = 0;
+	long long candidatesCount = 1000;
+	std::size_t topCount = 10;
+	int resolution = 128;
+	float timeStep = 0.05;
+	QString outputDirPath = ".";
+
+	float coverageWeight = 1;
+	float symmetryWeight = 1;
+	float edgeDensityWeight = 1;
+};
+
+/*
+ * Generates many random harmonographs from one 64 bit seed, renders each one at low resolution
+ * on all hardware threads and scores it with cheap image metrics. Candidate i is generated from
+ * its own CounterRandom stream (seed, i), so a run is reproducible whatever the thread count and
+ * only scores are kept in memory; the best candidates are regenerated and written as parameter files.
+ * The explorer takes ownership of the template harmonograph.
+ */
+class HarmonographExplorer {
+public:
+	HarmonographExplorer(Harmonograph* templateHarmonograph, ExplorationSettings settings);
+	~HarmonographExplorer();
+
+	std::vector<ExplorationScore> explore();
+	bool writeTopCandidates(const std::vector<ExplorationScore>& scores);
+
+	Harmonograph* createCandidate(long long candidateIndex);
+
+private:
+	Harmonograph* templateHarmonograph;
+	ExplorationSettings settings;
+
+	ExplorationScore scoreCandidate(long long candidateIndex, std::vector<float>& xs, std::vector<float>& ys, std::vector<unsigned char>& grid);
+	void rasterize(const std::vector<float>& xs, const std::vector<float>& ys, std::vector<unsigned char>& grid);
+};
+
+class ExplorationTask : public QRunnable {
+public:
+	ExplorationTask(Harmonograph* templateHarmonograph, ExplorationSettings settings);
+	~ExplorationTask();
+	void run() override;
+
+private:
+	HarmonographExplorer* explorer;
+};
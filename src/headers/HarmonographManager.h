@@ -28,8 +28,13 @@
 #include <deque>
 #include <cmath>
 #include "DrawParameteres.h"
+#include "HarmonographSampler.h"
+#include "TrajectoryCache.h"
+#include "ViewportSampler.h"
+
+class HarmonographManager : public QObject {
+	Q_OBJECT
 
-class HarmonographManager{
 public:	
 	float const pi = atan(1) * 4;
 	float const maxDampingValue = 0.01;
@@ -61,7 +66,17 @@ public:
 	void setFrequencyPoint(float freqPt);
 	void setNumOfPendulums(int newNum);
 
+	HarmonographEngines getEngine();
+	SimulationSettings getSimulationSettings();
+	void setSimulation(HarmonographEngines engine, SimulationSettings settings);
+
 	float getCoordinateByTime(Dimension dimension, float t);
+	float getCoordinateBound(Dimension dimension, float tStart, float tEnd);
+	void sampleTrajectory(float tStart, float tStep, int count, float* xs, float* ys);
+	void setSamplingThreads(int threadsCount);
+	void sampleViewport(const Viewport& viewport, float maxTimeStep, ViewportSamples& samples);
+	void setTrajectoryCacheDir(QString dirPath);
+	TrajectoryCacheStatistics getTrajectoryCacheStatistics();
 
 	void changeParameter(int pendulumNum, EquationParameter parameter, Dimension dimension, int value);
 	
@@ -80,12 +95,44 @@ public:
 	void setTimeStep(double step);
 
 	int getHistorySize();
-	std::vector<Pendulum*> getPendulumsCopy();
+	int getNumOfPendulums();
+	float getEquationParameter(int pendulumNum, Dimension dimension, EquationParameter parameter);
+	void setEquationParameter(int pendulumNum, Dimension dimension, EquationParameter parameter, float value);
+
+public slots:
+	/*a drag, slider move or rotation has ended, the current trajectory is sampled at medium accuracy and cached again*/
+	void finishInteraction();
+
+signals:
+	/*the preview should be redrawn since the coarse trajectory of an interaction is no longer used*/
+	void interactionFinished();
+	/*single equation parameter of one pendulum dimension was changed*/
+	void parameterChanged(int pendulumNum, Dimension dimension, EquationParameter parameter, float value);
+	/*pendulums were regenerated or replaced, all parameters must be re-read*/
+	void pendulumsChanged();
 
 private:
 	Harmonograph* harmonograph;
 	HarmonographSaver* harmonographSaver;
 	std::deque<Harmonograph*> history;
 	DrawParameters drawParameters = DrawParameters();
+	HarmonographSampler sampler;
+	ViewportSampler viewportSampler;
+
+	TrajectoryCache trajectoryCache;
+	//rotation and slider drags produce a new trajectory every frame, caching them would only evict useful ones
+	bool isTrajectoryTransient = false;
+	//ends an interaction that never reports its end, such as a key press on a slider or a control command
+	QTimer* settleTimer;
+	bool isTrajectoryPersistent = false;
+	double lastSampleStart = 0, lastSampleStep = 0;
+	int lastSampleCount = 0;
+	//a simulated curve has no closed-form bound, the extent of its last samples is used instead
+	float sampledBound[2] = { 0, 0 };
+
+	float getBaseFrequency(int pendulumNum);
+	void createSettleTimer();
+	void startInteraction();
+	void cacheCurrentTrajectory(bool isPersistent);
 };
 
@@ -22,6 +22,11 @@
 #include <qopenglwidget.h>
 #include "HarmonographManager.h"
 #include "settings.h"
+#include "StartupTrace.h"
+#include "TrajectoryRenderer.h"
+#include "TrailRenderer.h"
+#include "CometTrail.h"
+#include "QualityController.h"
 #include "GL/glut.h"
 
 
@@ -34,6 +39,8 @@ public:
     float stepPhaseY = 90;
     const float piTwo = static_cast<float>(2 * atan(1) * 4);
     float minZoom = 0.1, maxZoom = 0.75;
+    //past maxZoom the view zooms by deepZoomPerNotch per wheel notch and drag pans
+    const double maxDeepZoom = 10000, deepZoomPerNotch = 1.25;
 
     HarmonographManager* manager = nullptr;
 
@@ -41,8 +48,35 @@ public:
     ~HarmonographOpenGLWidget();
 
     void setEnableAA(bool isEnabled);
+    void prepareFrame();
+    void setAdaptiveQuality(bool isEnabled, int targetFps = 60);
+    bool isOnScreen();
+    bool isDeepZoomed();
+    //nullptr draws the whole curve again
+    void setCometTrail(CometTrail* trail);
+    QString getVertexMemoryReport();
 
 protected:
+    std::vector<float> xBuffer, yBuffer;
+    float xBound = 1, yBound = 1;
+    float frameTimeStep = 0.01;
+    bool isFramePrepared = false;
+    double deepZoom = 1;
+    double centerX = 0, centerY = 0;
+    int viewHeight = 1;
+    bool isDeepFrame = false;
+    ViewportSamples viewportSamples;
+    std::vector<DrawRange> ranges;
+    float colorScale = 1;
+    bool isQualityAdaptive = false;
+    QualityController qualityController;
+    qint64 prepareNanoseconds = 0;
+    float aspect = 1;
+    TrajectoryRenderer renderer;
+    TrailRenderer trailRenderer;
+    CometTrail* cometTrail = nullptr;
+
+
     void wheelEvent(QWheelEvent* event) override;
     void mouseMoveEvent(QMouseEvent* event) override;
     void mousePressEvent(QMouseEvent* event) override;
@@ -50,5 +84,9 @@ protected:
     void initializeGL() override;
     void resizeGL(int w, int h) override;
     void paintGL() override;
+
+    double getPixelSize();
+    void paintTrail(const DrawParameters& parameters);
+    void prepareViewportFrame();
 };
 
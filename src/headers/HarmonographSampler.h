@@ -0,0 +1,91 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <vector>
+#include "Harmonograph.h"
+#include "MathAccuracyEnum.h"
+#include "PendulumSimulator.h"
+
+/*
+ * Samples a harmonograph at equally spaced moments of time.
+ *
+ * Every damped sinusoid exp(-d*t) * e^(i*(f*t + p)) is advanced from one sample to the next
+ * by multiplying it with the constant exp((-d + i*f) * dt), so no exp/sin/cos is evaluated
+ * per sample. The state of all pendulums is kept in flat arrays and the inner loop runs across
+ * pendulums, which lets the compiler vectorize it. The exact value is recomputed every
+ * anchorInterval samples so rounding errors do not accumulate. Long runs are split between
+ * hardware threads, or at most maxThreads of them when a caller shares the cores between several
+ * samplers. Up to maxSpecializedPendulums the loops are instantiated for the exact
+ * pendulum count, larger harmonographs use the generic vectorized loop.
+ *
+ * The anchors are evaluated with FastMath at the selected accuracy, the per-sample rotation
+ * is always exact since its error would grow along the whole interval.
+ *
+ * Simulated harmonographs are handed to a PendulumSimulator on the calling thread instead;
+ * consecutive calls that continue where the previous one stopped continue its state.
+ */
+class HarmonographSampler {
+public:
+	static const int anchorInterval = 256;
+	static const long long minWorkPerThread = 1 << 18;
+	static const int maxSpecializedPendulums = 8;
+
+	HarmonographSampler() = default;
+	HarmonographSampler(Harmonograph* harmonograph);
+
+	void load(Harmonograph* harmonograph);
+	void sample(double tStart, double tStep, int count, float* xs, float* ys) const;
+
+	int getNumOfPendulums() const {
+		return numOfPendulums;
+	}
+	void setAccuracy(MathAccuracy accuracy) {
+		this->accuracy = accuracy;
+	}
+	/*closed-form samples are written relative to this point, which keeps them exact in float far from the center*/
+	void setOrigin(double x, double y) {
+		xOrigin = x;
+		yOrigin = y;
+	}
+	/*0 uses every hardware thread*/
+	void setMaxThreads(int maxThreads) {
+		this->maxThreads = maxThreads;
+	}
+
+private:
+	int numOfPendulums = 0;
+	MathAccuracy accuracy = MathAccuracy::precise;
+	int maxThreads = 0;
+	double xOrigin = 0, yOrigin = 0;
+	bool isSimulated = false;
+	mutable PendulumSimulator simulator;
+
+	std::vector<double> xDumping, xFrequency, xPhase;
+	std::vector<double> yDumping, yFrequency, yPhase;
+
+	void sampleRange(double tStart, double tStep, int count, float* xs, float* ys) const;
+	void sampleRangeGeneric(double tStart, double tStep, int count, float* xs, float* ys) const;
+	template<int N>
+	void sampleRangeFixed(double tStart, double tStep, int count, float* xs, float* ys) const;
+	void computeAnchors(int n, double t, const double* dumping, const double* frequency, const double* phase, double* re, double* im) const;
+};
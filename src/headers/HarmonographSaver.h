@@ -27,11 +27,14 @@
 #include "settings.h"
 #include <QRunnable>
 #include <QThreadPool>
+#include <vector>
 
 class HarmonographSaver {
 public:
 	HarmonographSaver();
 	void saveImage(Harmonograph* harmonograph, ImageSettings* settings);
+	/*every target with the parameters and encoder of settings, the sizes and names of settings are not used*/
+	void saveImages(Harmonograph* harmonograph, ImageSettings* settings, const std::vector<ExportTarget>& targets);
 	void saveParametersToFile(QString filename, Harmonograph* harmonograph);
 	Harmonograph* loadParametersFromFile(QString filename);
 };
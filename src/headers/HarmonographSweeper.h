@@ -0,0 +1,97 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtWidgets>
+#include <QRunnable>
+#include <vector>
+#include <atomic>
+#include "Harmonograph.h"
+#include "DrawParameteres.h"
+#include "SweepParametersEnum.h"
+
+class SweepAxis {
+public:
+	SweepParameters parameter = SweepParameters::frequencyPoint;
+	float from = 1;
+	float to = 4;
+	int steps = 4;
+
+	float valueAt(int index) const;
+	QString label(int index) const;
+
+	static QString parameterName(SweepParameters parameter);
+	//"parameter:from:to:steps", for example "firstRatio:1:12:12"
+	static bool fromString(const QString& str, SweepAxis& axis);
+};
+
+class SweepSettings {
+public:
+	SweepAxis columns;
+	SweepAxis rows;
+	int cellSize = 256;
+	int labelHeight = 20;
+	DrawParameters parameters;
+	QString filename = "sweep.png";
+};
+
+/*
+ * Renders a grid of variations of one harmonograph into a single contact sheet and writes
+ * an index JSON next to it that maps every cell to its parameters. Ratio and frequency point
+ * cells are derived with changeFrequencyPointNoUpdate, so they keep the phases and noise of
+ * the base harmonograph and differ only in the swept value.
+ *
+ * A phase offset rotates the x phase of every pendulum, which is a linear combination of two
+ * basis trajectories: x(d) = cos(d) * x(0) - sin(d) * x(-pi/2). Cells that differ only in phase
+ * are therefore rendered from one set of basis samples. That does not hold for a simulated base,
+ * whose cells are integrated in batches instead. The sweeper takes ownership of the base harmonograph.
+ */
+class HarmonographSweeper {
+public:
+	HarmonographSweeper(Harmonograph* baseHarmonograph, SweepSettings settings);
+	~HarmonographSweeper();
+
+	bool render();
+
+private:
+	float const pi = atan(1) * 4;
+	static const int simulatedCellsPerJob = 8;
+
+	Harmonograph* baseHarmonograph;
+	SweepSettings settings;
+
+	Harmonograph* createCell(int column, int row);
+	float phaseOffset(int column, int row) const;
+	void renderSimulatedJobs(const std::vector<std::vector<int>>& jobs, std::atomic<int>& nextJob, int count, std::vector<QImage>& cells);
+	void drawCell(QImage& cell, const std::vector<float>& xs, const std::vector<float>& ys);
+	bool writeIndex(const QString& imageFilename);
+};
+
+class SweepTask : public QRunnable {
+public:
+	SweepTask(Harmonograph* baseHarmonograph, SweepSettings settings);
+	~SweepTask();
+	void run() override;
+
+private:
+	HarmonographSweeper* sweeper;
+};
@@ -0,0 +1,42 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtWidgets>
+#include "ImageEncodersEnum.h"
+
+/*
+ * Writes rendered images to disk with the encoder picked in the save dialog.
+ * Uncompressed formats (PPM/PAM, raw RGBA with a JSON sidecar) are meant for pipelines
+ * that recompress the image later. Vector formats are not raster encoders and are written
+ * by the vector export task instead.
+ */
+class ImageEncoder {
+public:
+	static bool save(const QImage& image, const QString& filename, ImageEncoders encoder, int compressionLevel);
+	static QString fileFilter(ImageEncoders encoder);
+
+private:
+	static bool saveParallelPng(const QImage& image, const QString& filename, int compressionLevel);
+	static bool saveNetpbm(const QImage& image, const QString& filename, bool isPam);
+	static bool saveRawRGBA(const QImage& image, const QString& filename);
+};
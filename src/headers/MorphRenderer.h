@@ -0,0 +1,50 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtWidgets>
+#include "MorphTimeline.h"
+#include "DrawParameteres.h"
+
+/*
+ * Draws the frames of a MorphTimeline the way image exports are drawn. The scale is fitted
+ * once to the extent of all frames, so the curve does not jump in size while it morphs.
+ * renderFrame is safe to call from several threads.
+ */
+class MorphRenderer {
+public:
+	MorphRenderer(const MorphTimeline& timeline, DrawParameters parameters, int width, int height, int borderPercentage);
+
+	int getFrameCount() const {
+		return timeline.getFrameCount();
+	}
+
+	QImage renderFrame(int frame) const;
+	/*frame-00000.png and so on, rendered in parallel and written in order*/
+	bool renderToFiles(const QString& dirPath);
+
+private:
+	MorphTimeline timeline;
+	DrawParameters parameters;
+	int width, height;
+	int saveZoom = 1;
+};
@@ -0,0 +1,80 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Harmonograph.h"
+#include "MorphEasingsEnum.h"
+
+/*
+ * Parameters of every frame of an animation between keyframe harmonographs. Amplitude, damping,
+ * frequency and phase of every pendulum dimension are interpolated with the easing of the
+ * keyframe a transition starts from. Phases are unwrapped first, so each one turns along the
+ * shorter arc. All keyframes have to use one engine and, when simulated, one integrator; the
+ * swing angle and coupling of a simulation are interpolated like the pendulum parameters. All
+ * frames are computed once by buildSchedule, applyFrame only copies them.
+ */
+class MorphTimeline {
+public:
+	//x then y, each amplitude, damping, frequency, phase
+	static const int parametersPerPendulum = 8;
+	//swing angle and coupling after the pendulums
+	static const int simulationParameters = 2;
+
+	/*framesToNext is the length of the transition to the next keyframe, ignored for the last one*/
+	bool addKeyframe(Harmonograph* harmonograph, int framesToNext, MorphEasings easing, std::string& error);
+	void buildSchedule();
+
+	int getFrameCount() const {
+		return frameCount;
+	}
+	int getNumOfPendulums() const {
+		return numOfPendulums;
+	}
+
+	/*a harmonograph with the pendulums and engine of the timeline, delete it and its pendulums after use*/
+	Harmonograph* createHarmonograph() const;
+	void applyFrame(int frame, Harmonograph* harmonograph) const;
+
+	static bool easingFromString(const std::string& name, MorphEasings& easing);
+	static float ease(MorphEasings easing, float x);
+
+private:
+	class Keyframe {
+	public:
+		std::vector<float> parameters;
+		int framesToNext;
+		MorphEasings easing;
+	};
+
+	std::vector<Keyframe> keyframes;
+	int numOfPendulums = 0;
+	HarmonographEngines engine = HarmonographEngines::closedForm;
+	Integrators integrator = Integrators::symplectic;
+	int frameCount = 0;
+	std::vector<float> schedule;
+
+	int getParametersCount() const {
+		return numOfPendulums * parametersPerPendulum + simulationParameters;
+	}
+};
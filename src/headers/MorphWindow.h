@@ -0,0 +1,71 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtWidgets>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "MorphRenderer.h"
+#include "FramePipeline.h"
+
+/*
+ * Plays a morph on screen. Frames are rendered ahead by a FramePipeline on background threads
+ * into a short queue, and a timer shows them in order at the frame rate. The last frame stays
+ * when the morph is over; space plays it again.
+ */
+class MorphWindow : public QWidget {
+	Q_OBJECT
+
+public:
+	static const int maxQueuedFrames = 8;
+
+	MorphWindow(MorphRenderer* renderer, int fps, QWidget* parent = Q_NULLPTR);
+	~MorphWindow();
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void keyPressEvent(QKeyEvent* event) override;
+	void closeEvent(QCloseEvent* event) override;
+
+private:
+	MorphRenderer* renderer;
+	FramePipeline* pipeline = nullptr;
+	std::thread renderThread;
+	QTimer* frameTimer;
+
+	std::mutex mutex;
+	std::condition_variable queueChanged;
+	std::deque<QImage> queuedFrames;
+	bool isStopped = false;
+
+	QImage currentFrame;
+	int shownFrames = 0;
+
+	void play();
+	void stop();
+	bool enqueueFrame(const QImage& image);
+
+private slots:
+	void showNextFrame();
+};
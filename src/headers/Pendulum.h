@@ -22,27 +22,47 @@
 
 #include <cstdlib>
 #include <cmath>
+#include <type_traits>
 #include <time.h>
 #include "Dimension.h"
 #include "PendulumDimension.h"
+#include "AllocationTracker.h"
 #include "PendulumEquationParametersEnum.h"
-#include <QRandomGenerator>
 
-class Pendulum {
+class Pendulum : public TrackedObject<Pendulum> {
 public:
+	static const char* const allocationType;
+
 	Pendulum(Pendulum* pendulum);
 	Pendulum();
 	Pendulum(std::vector<PendulumDimension*> dimensions);
 	Pendulum(int dimensionsCount, float frequencyPoint, bool isCircle);
-	~Pendulum(){
-		
-	}
+	/*the pendulum owns its dimensions, including the ones passed to the constructor*/
+	~Pendulum();
+	Pendulum(const Pendulum&) = delete;
+	Pendulum& operator=(const Pendulum&) = delete;
 
 	std::vector<PendulumDimension*> getDimensionsCopy();
 
 	float getCoordinateByTime(Dimension dimension, float t);
+	float getDerivativeByTime(Dimension dimension, float t);
+
+	/*same as above with the dimension fixed at compile time, so the cos/sin choice is not taken per call*/
+	template<Dimension dimension>
+	float getCoordinateByTime(float t) {
+		static_assert(isKnownDimension<dimension>(), "dimension has to be x, y or z");
+		const PendulumDimension* d = dimensions[static_cast<int>(dimension)];
+		return exp(-d->dumping * t) * oscillation(d->frequency * t + d->phase, IsCosine<dimension>());
+	}
+	template<Dimension dimension>
+	float getDerivativeByTime(float t) {
+		static_assert(isKnownDimension<dimension>(), "dimension has to be x, y or z");
+		const PendulumDimension* d = dimensions[static_cast<int>(dimension)];
+		return exp(-d->dumping * t) * oscillationDerivative(d->frequency * t + d->phase, d->frequency, d->dumping, IsCosine<dimension>());
+	}
 
 	void update(float frequencyPoint, bool isCircle);
+	void update(float frequencyPoint, bool isCircle, CounterRandom& random);
 
 	void changeDimensionEquationPhase(Dimension dimension, float radians);
 
@@ -53,5 +73,27 @@ public:
 
 private:
 	std::vector<PendulumDimension*> dimensions;
+
+	template<Dimension dimension>
+	static constexpr bool isKnownDimension() {
+		return dimension == Dimension::x || dimension == Dimension::y || dimension == Dimension::z;
+	}
+
+	//even dimensions swing as cosines, odd ones as sines
+	template<Dimension dimension>
+	using IsCosine = std::integral_constant<bool, static_cast<int>(dimension) % 2 == 0>;
+
+	static float oscillation(float angle, std::true_type) {
+		return cos(angle);
+	}
+	static float oscillation(float angle, std::false_type) {
+		return sin(angle);
+	}
+	static float oscillationDerivative(float angle, float frequency, float dumping, std::true_type) {
+		return -(dumping * cos(angle) + frequency * sin(angle));
+	}
+	static float oscillationDerivative(float angle, float frequency, float dumping, std::false_type) {
+		return frequency * cos(angle) - dumping * sin(angle);
+	}
 };
 
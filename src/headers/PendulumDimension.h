@@ -20,11 +20,13 @@
 
 #pragma once
 #include <cmath>
-#include <QRandomGenerator>
+#include "CounterRandom.h"
+#include "AllocationTracker.h"
 
 
-class PendulumDimension {
+class PendulumDimension : public TrackedObject<PendulumDimension> {
 public:
+	static const char* const allocationType;
 	float const pi = atan(1) * 4;
 
 	float amplitude = 1;
@@ -38,6 +40,7 @@ public:
 	PendulumDimension(float amplitude, float frequency, float phase, float dumping, float frequencyNoise);
 
 	void update(float frequencyPoint, bool isCircle, int circleRandomValue);
+	void update(float frequencyPoint, bool isCircle, int circleRandomValue, CounterRandom& random);
 	void updateFrequencyPoint(float FrequencyPoint);
 	PendulumDimension* getDimensionCopy() {
 		return new PendulumDimension(amplitude, frequency, phase, dumping, frequencyNoise);
@@ -0,0 +1,113 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <vector>
+#include "Harmonograph.h"
+#include "SimulationSettings.h"
+
+class SimulationDiagnostics {
+public:
+	long long steps = 0;
+	double initialEnergy = 0;
+	double maxRelativeDrift = 0;
+	double finalRelativeDrift = 0;
+};
+
+/*
+ * Integrates harmonographs as coupled damped pendulums instead of evaluating the closed form.
+ *
+ * Every dimension of every pendulum is one lane: u'' = -w^2 sin(a*u)/a - 2d*u' - k*(u - mean),
+ * with w^2 = f^2 + d^2 and the initial state taken from the closed form at t = 0, so at a = 0
+ * and k = 0 both engines draw the same curve. The mean runs over the lanes of one harmonograph
+ * and direction, that is the table every pendulum hangs from. All lanes of all loaded
+ * harmonographs live in flat arrays and are advanced together, which lets the compiler put
+ * them into SIMD registers.
+ *
+ * The symplectic integrator is velocity Verlet with the damping split off and applied exactly,
+ * Runge-Kutta 4 integrates the damped system directly. Either way the pen is sampled every
+ * tStep with as many substeps as keep w*h below maxPhasePerStep. Diagnostics compare the
+ * energy plus what damping has taken out with the initial energy.
+ *
+ * Runge-Kutta 4 on one harmonograph of up to maxSpecializedPendulums has a kernel per pendulum
+ * count, because its four force evaluations per step dominate and are short loops otherwise.
+ * While every swing stays below FastMath::maxInRangeArgument radians the kernel skips the range
+ * reduction of the sine; a block of samples that leaves that range is integrated again with it.
+ * With it a 2.55M sample export of up to 8 pendulums takes under 1 s on one core, wider swings
+ * up to about 1.4 s; SimulationDialog tells the user so.
+ */
+class PendulumSimulator {
+public:
+	static constexpr double maxPhasePerStep = 0.05;
+	static const int diagnosticInterval = 64;
+	static const int maxSpecializedPendulums = 8;
+
+	void load(Harmonograph* harmonograph);
+	void load(const std::vector<Harmonograph*>& harmonographs);
+
+	/*continues from the previous call when tStart is where it stopped, otherwise starts over*/
+	void sample(double tStart, double tStep, int count, float* xs, float* ys);
+	void sampleBatch(double tStep, int count, const std::vector<float*>& xs, const std::vector<float*>& ys);
+
+	const SimulationDiagnostics& getDiagnostics() const {
+		return diagnostics;
+	}
+
+private:
+	Integrators integrator = Integrators::symplectic;
+	int harmonographsCount = 0;
+	int lanesCount = 0;
+	bool isCoupled = false;
+
+	//per lane
+	std::vector<double> stiffness, dumping, swing, inverseSwing, coupling;
+	std::vector<double> initialPosition, initialVelocity;
+	std::vector<int> coordinate;
+	//per coordinate, that is harmonograph * 2 + dimension
+	std::vector<double> coordinateSums, coordinateMeans;
+	std::vector<int> coordinateLanes;
+
+	//state
+	std::vector<double> position, velocity, acceleration, decay;
+	std::vector<double> rkPosition, rkVelocity, rkPositionSum, rkVelocitySum;
+	double released = 0;
+	double step = 0;
+	double sampleStep = -1;
+	int substeps = 1;
+	long long sampleIndex = 0;
+	bool hasState = false;
+
+	SimulationDiagnostics diagnostics;
+
+	void reset(double tStep);
+	void advanceSample();
+	void advanceSymplectic();
+	void advanceRungeKutta();
+	template<int N>
+	void sampleRungeKuttaFixed(int count, float* xs, float* ys);
+	template<int N, bool isInRange>
+	bool advanceRungeKuttaFixed(int count, double* u, double* v, float* xs, float* ys, double& blockReleased);
+	void computeCoordinateSums(const double* positions);
+	void computeAcceleration(const double* positions, double* accelerations);
+	double computeEnergy();
+	void updateDiagnostics();
+};
@@ -0,0 +1,58 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include "HarmonographManager.h"
+#include "Dimension.h"
+#include "PendulumEquationParametersEnum.h"
+
+/*
+ * Table of equation parameters of every pendulum, one row per pendulum.
+ * Views request only the rows they show, so the editor stays responsive for
+ * harmonographs with hundreds of pendulums.
+ */
+class PendulumsTableModel : public QAbstractTableModel {
+	Q_OBJECT
+
+public:
+	PendulumsTableModel(HarmonographManager* manager, QObject* parent = Q_NULLPTR);
+
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+	Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+private:
+	static const int parametersPerDimension = 3;
+
+	HarmonographManager* manager;
+
+	Dimension columnDimension(int column) const;
+	EquationParameter columnParameter(int column) const;
+
+private slots:
+	void pendulumParameterChanged(int pendulumNum, Dimension dimension, EquationParameter parameter, float value);
+	void pendulumsChanged();
+};
@@ -0,0 +1,53 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <vector>
+
+/*
+ * PNG writer that deflates independent blocks of rows on all hardware threads (the way pigz does).
+ * Each block is compressed as raw deflate data primed with the last 32 KiB of the previous block
+ * and ended with a sync flush, so the concatenated blocks form one valid zlib stream.
+ */
+class PngEncoder {
+public:
+	static const int blockSize = 128 * 1024;
+	static const int dictionarySize = 32 * 1024;
+
+	/*rgba is 8 bit per channel non-premultiplied RGBA, stride is the number of bytes between rows*/
+	static bool encode(const unsigned char* rgba, int width, int height, int stride, int compressionLevel, std::vector<unsigned char>& png);
+
+private:
+	struct Block {
+		int firstRow = 0;
+		int rowsCount = 0;
+		unsigned long adler = 1;
+		unsigned long length = 0;
+		std::vector<unsigned char> data;
+		bool isOk = false;
+	};
+
+	static void filterRow(const unsigned char* row, const unsigned char* previousRow, int rowBytes, bool useFilters, unsigned char* out);
+	static void filterRows(const unsigned char* rgba, int width, int stride, int firstRow, int rowsCount, bool useFilters, std::vector<unsigned char>& out);
+	static void compressBlock(const unsigned char* rgba, int width, int stride, int compressionLevel, bool isLast, Block& block);
+	static void appendChunk(std::vector<unsigned char>& png, const char* type, const unsigned char* data, unsigned long length);
+};
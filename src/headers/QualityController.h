@@ -0,0 +1,65 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+/*
+ * Holds an animated view at a target frame rate by trading quality for time. Every frame
+ * reports how long sampling and drawing took; the averaged cost picks a level, and every
+ * level after the first draws without multisampling and samples the curve more sparsely.
+ *
+ * The controller steps down as soon as the average cost leaves degradeRatio of the frame
+ * budget and steps back up only after settleFrames at a level, when the cost predicted for
+ * the finer level stays under refineRatio of the budget, so it does not oscillate.
+ */
+class QualityController {
+public:
+	static const int levelsCount = 6;
+	static const int degradeFrames = 5;
+	static const int settleFrames = 30;
+	static constexpr double degradeRatio = 0.8;
+	static constexpr double refineRatio = 0.6;
+	static constexpr double smoothing = 0.2;
+	//multisampling is assumed to cost this much of the draw, the sample count is known exactly
+	static constexpr double antiAliasingCostFactor = 1.3;
+
+	QualityController(int targetFps = 60);
+
+	void setTargetFps(int targetFps);
+	void addFrameCost(double milliseconds);
+	void reset();
+
+	int getLevel() const {
+		return level;
+	}
+	float getTimeStepScale() const;
+	bool isAntiAliasingAllowed() const {
+		return level == 0;
+	}
+
+private:
+	double budget = 1000.0 / 60;
+	double averageCost = 0;
+	int level = 0;
+	int framesAtLevel = 0;
+
+	void changeLevel(int newLevel);
+};
@@ -0,0 +1,78 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QObject>
+#include <QThreadPool>
+#include <QTimer>
+#include <vector>
+
+/*
+ * A view animated by the RenderScheduler. advanceFrame and submitFrame run on the GUI thread,
+ * prepareFrame on a worker thread while the GUI thread waits, so it must not touch GL.
+ */
+class RenderClient {
+public:
+	virtual ~RenderClient() = default;
+
+	virtual int getFrameRate() = 0;
+	/*returns false when the view is paused and has no new frame*/
+	virtual bool advanceFrame() = 0;
+	virtual void prepareFrame(int samplingThreads) = 0;
+	virtual void submitFrame() = 0;
+};
+
+/*
+ * Ticks every animated view from one precise timer at the refresh rate of the primary screen,
+ * instead of a timer per window that drifts against the others. A view with a lower frame rate
+ * renders every n-th tick, so views with the same frame rate always render in the same tick.
+ *
+ * On a tick the due views advance their animation, then their trajectories are sampled in
+ * parallel: one view on the GUI thread, the rest on the scheduler's own pool (exports on the
+ * global pool can not delay frames), with the hardware threads divided between them. Only then
+ * is GL work submitted per context, so all windows show the same frame of their animation.
+ */
+class RenderScheduler : public QObject {
+	Q_OBJECT
+
+public:
+	static RenderScheduler* instance();
+
+	void addClient(RenderClient* client);
+	void removeClient(RenderClient* client);
+
+	int getTickRate() const {
+		return tickRate;
+	}
+
+private:
+	RenderScheduler(QObject* parent);
+
+	QTimer* tickTimer;
+	QThreadPool pool;
+	std::vector<RenderClient*> clients;
+	int tickRate = 60;
+	long long tickIndex = 0;
+
+private slots:
+	void tick();
+};
@@ -22,6 +22,7 @@
 
 #include <QDialog>
 #include <ui_SaveImageDialog.h>
+#include "ImageEncodersEnum.h"
 
 class SaveImageDialog : public QDialog
 {
@@ -34,13 +35,17 @@ public:
 	bool useAntialiasing = false;
 	bool useSquareImage = false;
 	bool transpBack = false;
+	bool useGpuRenderer = false;
 	int saveWidth = 1920;
 	int saveHeight = 1080;
 	int penWidth = 1;
 	int borderPercentage = 3;
+	ImageEncoders encoder = ImageEncoders::parallelPng;
+	int compressionLevel = 6;
 
 private:
 	Ui::SaveImageDialog ui;
 private slots:
 	virtual void accept();
+	void encoderChanged(int index);
 };
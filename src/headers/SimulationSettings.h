@@ -0,0 +1,37 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include "IntegratorsEnum.h"
+
+/*
+ * Physical model used when a harmonograph is simulated instead of evaluated in closed form.
+ * A unit coordinate of a pendulum is swingAngle radians of swing: at 0 every pendulum is
+ * linear and the simulation reproduces the closed form. coupling is the stiffness with which
+ * the shared table pulls every pendulum towards the mean of the others in the same direction.
+ */
+class SimulationSettings {
+public:
+	Integrators integrator = Integrators::symplectic;
+	float swingAngle = 0.5;
+	float coupling = 0;
+};
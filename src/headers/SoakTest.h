@@ -0,0 +1,57 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include "HarmonographApp.h"
+
+/*
+ * --soak: runs auto-rotation and a phase flex window for the given time and quits with 1 if
+ * resident memory grew by more than maxGrowthBytes. The baseline is taken after a warm-up,
+ * once caches, GL buffers and lazily created objects have settled.
+ */
+class SoakTest : public QObject {
+	Q_OBJECT
+
+public:
+	static const long long maxGrowthBytes = 8 << 20;
+	static const int warmUpMs = 60 * 1000;
+	static const int checkpointMs = 60 * 1000;
+
+	SoakTest(HarmonographApp* app, int minutes, QObject* parent = nullptr);
+
+	void start();
+
+private:
+	HarmonographApp* app;
+	int minutes;
+	long long baselineBytes = 0;
+	QTimer* checkpointTimer;
+
+	long long getGrowthBytes();
+
+private slots:
+	void warmedUp();
+	void checkpoint();
+	void finish();
+};
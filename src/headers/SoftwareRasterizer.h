@@ -0,0 +1,93 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "DrawModesEnum.h"
+#include "HarmonographSampler.h"
+
+/*
+ * Image settings of the software raster path. Colors are 0xAARRGGBB, the layout of QRgb, so
+ * the pixels can be wrapped in a QImage::Format_ARGB32 without conversion.
+ */
+class RasterSettings {
+public:
+	int width = 1280;
+	int height = 720;
+	float borderPercentage = 0.03;
+	DrawModes drawMode = DrawModes::linesMode;
+	int penWidth = 2;
+	bool useAntiAliasing = true;
+	/*sampling step of the points mode, lines are always drawn at linesTimeStep*/
+	float timeStep = 0.01;
+
+	bool useTwoColors = true;
+	std::uint32_t primaryColor = 0xff0000ff;
+	std::uint32_t secondColor = 0xffff0000;
+	std::uint32_t backgroundColor = 0xffffffff;
+};
+
+/*
+ * Draws a harmonograph the way image exports do, without Qt: the curve is fitted into the
+ * image with the border, sampled in chunks and drawn as round-capped segments with the
+ * two-color gradient along the time.
+ *
+ * With anti-aliasing the coverage of a pixel is the distance from its center to the segment.
+ * The consecutive segments of one stroke overlap heavily, so a pixel that was hit by the same
+ * stroke less than strokeGap segments ago only gets the coverage above what it already has;
+ * a later pass of the curve over the pixel blends on top as usual.
+ */
+class SoftwareRasterizer {
+public:
+	static const int maxT = 255;
+	static constexpr float linesTimeStep = 1e-04f;
+	static constexpr int samplesChunkSize = 1 << 16;
+	static const int strokeGap = 64;
+	static const int maxScale = 1 << 20;
+
+	/*pixels per curve unit that fit the whole curve into width x height minus the border;
+	a curve without extent in one direction is fitted by the other, a single point gets maxScale*/
+	static int computeScale(const HarmonographSampler& sampler, int width, int height, float borderPercentage);
+	/*the same in two steps, for several images of one curve*/
+	static void computeExtent(const HarmonographSampler& sampler, float& maxX, float& maxY);
+	static int computeScale(float maxX, float maxY, int width, int height, float borderPercentage);
+
+	SoftwareRasterizer(const RasterSettings& settings);
+
+	/*stride is in bytes, the buffer holds settings.height rows*/
+	void render(const HarmonographSampler& sampler, std::uint32_t* pixels, int stride);
+
+private:
+	RasterSettings settings;
+	std::uint32_t* pixels = nullptr;
+	int stride = 0;
+	float radius = 1;
+
+	//last segment that touched a pixel (+1, 0 is never) and the coverage it left there
+	std::vector<std::uint32_t> strokeStamps;
+	std::vector<std::uint8_t> strokeCoverage;
+
+	std::uint32_t getGradientColor(int index, int stepCount) const;
+	void drawSegment(float x0, float y0, float x1, float y1, std::uint32_t color, std::uint32_t index);
+	void blendPixel(int x, int y, int coverage, std::uint32_t color, std::uint32_t index);
+};
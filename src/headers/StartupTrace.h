@@ -0,0 +1,42 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+
+/*
+ * Startup phase timing printed with --startup-trace. Every mark prints the time spent since
+ * the previous mark and since main() started; the trace ends at the first rendered frame.
+ * When tracing is off a mark is a single branch.
+ */
+class StartupTrace {
+public:
+	static void start(bool isEnabled);
+	static void mark(const char* phase);
+	static void firstFrame();
+
+private:
+	static bool isEnabled;
+	static QElapsedTimer timer;
+	static qint64 lastMark;
+};
@@ -0,0 +1,86 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class TraceEvent {
+public:
+	const char* name;
+	const char* category;
+	std::int64_t start;
+	std::int64_t duration;
+};
+
+/*
+ * Span tracing written as Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).
+ * Every thread records into its own ring buffer, so recording takes no lock; when a ring is
+ * full the oldest spans are overwritten. The file is written at exit and, on Unix, whenever
+ * the process gets SIGUSR1. When tracing is off a span costs one relaxed load.
+ * Span names and categories must be string literals, only the pointers are stored.
+ */
+class Tracer {
+public:
+	static const int ringCapacity = 1 << 15;
+
+	static void start(const std::string& filePath);
+	static bool isEnabled() {
+		return enabled.load(std::memory_order_relaxed);
+	}
+	static std::int64_t now();
+	static void record(const char* name, const char* category, std::int64_t start, std::int64_t end);
+	static bool flush();
+
+private:
+	static std::atomic<bool> enabled;
+	static std::atomic<bool> isFlushRequested;
+	static std::string filePath;
+
+	static void requestFlush(int signal);
+	static void flushAtExit();
+};
+
+class TraceSpan {
+public:
+	TraceSpan(const char* name, const char* category) {
+		this->name = name;
+		this->category = category;
+		start = Tracer::isEnabled() ? Tracer::now() : -1;
+	}
+	~TraceSpan() {
+		finish();
+	}
+
+	//ends the span before the end of its scope, for consecutive stages of one function
+	void finish() {
+		if (start < 0) return;
+		Tracer::record(name, category, start, Tracer::now());
+		start = -1;
+	}
+
+private:
+	const char* name;
+	const char* category;
+	std::int64_t start;
+};
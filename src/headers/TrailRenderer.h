@@ -0,0 +1,64 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QMatrix4x4>
+#include <vector>
+#include "DrawParameteres.h"
+#include "VertexPacker.h"
+
+/*
+ * GPU ring of packed vertices for the comet trail. New samples overwrite the oldest ones in
+ * place, so a frame uploads only what it appended. The ring is drawn as two strips; slot 0 is
+ * also kept in an extra slot after the last one, which joins the strips without a gap. The
+ * shader fades every vertex towards the background by its age, taken from gl_VertexID and the
+ * head of the ring. The bound given to reset is a first guess: a sample outside it, which a
+ * simulation can produce, widens the bound and the whole ring is packed again from the float
+ * copy kept on the CPU. Must be used with its context current.
+ */
+class TrailRenderer : protected QOpenGLExtraFunctions {
+public:
+	static const int positionLocation = 0;
+
+	bool initialize();
+	/*drops the trail*/
+	void reset(int capacity, float xBound, float yBound);
+	void append(const float* xs, const float* ys, int count);
+	void draw(const QMatrix4x4& matrix, const DrawParameters& parameters);
+
+private:
+	QOpenGLShaderProgram program;
+	QOpenGLBuffer vertexBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	std::vector<PackedVertex> vertices;
+	std::vector<float> ringXs, ringYs;
+
+	int capacity = 0;
+	int head = 0;
+	int size = 0;
+	float xBound = 0, yBound = 0;
+
+	void write(int slot, const PackedVertex* data, int count);
+	void repack();
+};
@@ -0,0 +1,88 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QtCore>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Harmonograph.h"
+
+class TrajectoryCacheStatistics {
+public:
+	long long memoryHits = 0;
+	long long diskHits = 0;
+	long long misses = 0;
+	long long evictions = 0;
+	long long memoryBytes = 0;
+	long long diskBytes = 0;
+};
+
+/*
+ * Cache of sampled trajectories keyed by a hash of everything the samples depend on:
+ * damping, frequency and phase of every pendulum dimension plus tStart, tStep and count.
+ * The first tier keeps recently used trajectories in memory, bounded in bytes. The optional
+ * second tier stores every trajectory as a file in a directory and reads it back through
+ * a memory mapping, so presets sampled in a previous session are hits too.
+ */
+class TrajectoryCache {
+public:
+	TrajectoryCache(long long memoryLimitBytes = 64ll << 20);
+
+	static std::uint64_t computeKey(Harmonograph* harmonograph, double tStart, double tStep, int count);
+
+	bool lookup(std::uint64_t key, int count, float* xs, float* ys);
+	bool contains(std::uint64_t key);
+	//persistent entries are also written to the disk tier
+	void insert(std::uint64_t key, int count, const float* xs, const float* ys, bool isPersistent = false);
+	void persist(std::uint64_t key);
+
+	void setDiskTier(const QString& dirPath, long long diskLimitBytes = 512ll << 20);
+	void clear();
+
+	TrajectoryCacheStatistics getStatistics();
+
+private:
+	class Entry {
+	public:
+		std::uint64_t key;
+		std::vector<float> xs, ys;
+	};
+
+	long long memoryLimitBytes;
+	long long diskLimitBytes = 0;
+	QString diskDirPath;
+	TrajectoryCacheStatistics statistics;
+
+	//front is the most recently used entry
+	std::list<Entry> entries;
+	std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+	std::mutex mutex;
+
+	void insertToMemory(std::uint64_t key, int count, const float* xs, const float* ys);
+	bool readFromDisk(std::uint64_t key, int count, float* xs, float* ys);
+	void writeToDisk(std::uint64_t key, int count, const float* xs, const float* ys);
+	void trimDisk();
+	QString diskFilePath(std::uint64_t key);
+};
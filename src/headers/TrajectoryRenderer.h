@@ -0,0 +1,71 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QMatrix4x4>
+#include <vector>
+#include "DrawParameteres.h"
+#include "VertexPacker.h"
+
+/*
+ * One strip of the vertex buffer. The gradient step of vertex i is colorOffset + colorScale * i,
+ * with i counted from the start of the buffer, as gl_VertexID is.
+ */
+class DrawRange {
+public:
+	int first = 0;
+	int count = 0;
+	float colorOffset = 1;
+};
+
+/*
+ * GPU pipeline shared by the 2D widget and the framebuffer exporter. Samples are uploaded
+ * as packed 16 bit vertices and the vertex shader restores positions from the bounds and
+ * derives the gradient color from gl_VertexID. Must be used with its context current.
+ */
+class TrajectoryRenderer : protected QOpenGLExtraFunctions {
+public:
+	static const int positionLocation = 0;
+
+	bool initialize();
+	void upload(const float* xs, const float* ys, int count, float xBound, float yBound);
+	//matrix maps curve coordinates to clip space, colorStepCount is the number of gradient steps
+	void draw(const QMatrix4x4& matrix, const DrawParameters& parameters, int colorStepCount);
+	//several strips of one upload, used when only parts of the curve are sampled
+	void drawRanges(const QMatrix4x4& matrix, const DrawParameters& parameters, int colorStepCount,
+		const std::vector<DrawRange>& ranges, float colorScale);
+
+	int getVertexCount() const {
+		return vertexCount;
+	}
+
+private:
+	QOpenGLShaderProgram program;
+	QOpenGLBuffer vertexBuffer = QOpenGLBuffer(QOpenGLBuffer::VertexBuffer);
+	std::vector<PackedVertex> vertices;
+
+	int vertexCount = 0;
+	float xBound = 0, yBound = 0;
+};
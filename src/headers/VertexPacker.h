@@ -0,0 +1,43 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Vertex uploaded to the GPU: x and y as signed 16 bit values normalized to the analytic
+ * bounding box of the curve. Color is not stored, the shader derives it from the vertex index.
+ * A full float position plus color used to cost 24 bytes per vertex, this costs 4.
+ */
+class PackedVertex {
+public:
+	std::int16_t x;
+	std::int16_t y;
+};
+
+class VertexPacker {
+public:
+	static const int unpackedVertexBytes = 6 * sizeof(float);
+	static const int packedVertexBytes = sizeof(PackedVertex);
+
+	static void pack(const float* xs, const float* ys, int count, float xBound, float yBound, PackedVertex* vertices);
+};
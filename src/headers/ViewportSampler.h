@@ -0,0 +1,92 @@
+/*
+ *   Copyright 2020-2021 Artem Bakin and Dmitriy Kuperstein
+ *
+ *   This file is part of Harmonograph.
+ *
+ *   Harmonograph is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Harmonograph is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Harmonograph.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+
+#pragma once
+
+#include <vector>
+#include "Harmonograph.h"
+#include "HarmonographSampler.h"
+
+/*visible part of the curve plane, in curve units*/
+class Viewport {
+public:
+	double centerX = 0, centerY = 0;
+	double halfWidth = 1, halfHeight = 1;
+	double pixelSize = 0.01;
+};
+
+/*samples [first, first + count) run from tStart with the common time step*/
+class ViewportRun {
+public:
+	double tStart = 0;
+	int first = 0;
+	int count = 0;
+};
+
+/*samples are relative to the viewport center, xBound and yBound are their largest magnitudes*/
+class ViewportSamples {
+public:
+	std::vector<float> xs, ys;
+	std::vector<ViewportRun> runs;
+	double timeStep = 0;
+	float xBound = 0, yBound = 0;
+};
+
+/*
+ * Samples only the parts of a closed-form curve that can reach the viewport, densely enough
+ * that the polyline stays within maxScreenError pixels of the curve.
+ *
+ * The time range is cut into coarseIntervalsCount intervals. The speed of a coordinate is at most
+ * sum(exp(-d*t) * sqrt(d^2 + f^2)), so within an interval the curve stays within speed * length / 2
+ * of its midpoint. An interval whose box misses the viewport is dropped, one whose box is still
+ * larger than the viewport is halved and tested again. A chord of length h deviates from the
+ * curve by at most acceleration * h^2 / 8, which gives the time step. Far in, the visible
+ * intervals shrink faster than the step does, so a frame costs no more than at the normal zoom.
+ */
+class ViewportSampler {
+public:
+	static const int coarseIntervalsCount = 4096;
+	static const int maxSamplesCount = 1 << 21;
+	static constexpr double maxScreenError = 0.25;
+	static constexpr double maxT = 255;
+
+	void load(Harmonograph* harmonograph);
+	void sample(const Viewport& viewport, double maxTimeStep, ViewportSamples& samples);
+
+private:
+	class Oscillator {
+	public:
+		double dumping, frequency, phase;
+	};
+	class TimeInterval {
+	public:
+		double tStart, tEnd;
+	};
+
+	std::vector<Oscillator> xOscillators, yOscillators;
+	std::vector<TimeInterval> pending, visible;
+	HarmonographSampler sampler;
+
+	static double evaluate(const std::vector<Oscillator>& oscillators, double t, bool isCosine);
+	static double speedBound(const std::vector<Oscillator>& oscillators, double tStart, double tEnd);
+	static double accelerationBound(const std::vector<Oscillator>& oscillators, double t);
+	void findVisibleIntervals(const Viewport& viewport);
+};
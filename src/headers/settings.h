@@ -23,6 +23,7 @@
 #include "Harmonograph.h"
 #include "FlexModesEnum.h"
 #include "DrawParameteres.h"
+#include "ImageEncodersEnum.h"
 
 class FlexSettings {
 public:
@@ -40,6 +41,20 @@ public:
 	int borderPercentage = 3;
 	int saveWidth = 1920;
 	int saveHeight = 1080;
+	ImageEncoders encoder = ImageEncoders::parallelPng;
+	int compressionLevel = 6;
+	bool useGpuRenderer = false;
+	float vectorTolerance = 0.25;
+	int vectorPaletteSize = 64;
+};
+
+/*one image of an export at several sizes*/
+class ExportTarget {
+public:
+	QString filename = "";
+	int width = 1920;
+	int height = 1080;
+	int borderPercentage = 3;
 };
 
 class ColorTemplate {